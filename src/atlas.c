@@ -0,0 +1,215 @@
+// Glyph atlas text rendering
+#include "atlas.h"
+#include <stdlib.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+/*  ----------------------------------------------------------------------
+    Description: Rasterize the printable ASCII glyphs of a font at the
+    given size into a new atlas texture. The font is left set to that size.
+    Glyphs are rendered white so atlas_draw() can tint them with vertex
+    colors, and packed left to right in rows of font height.
+    Parameters:
+      SDL_Renderer* renderer: renderer that will draw the text
+      TTF_Font* font: font to rasterize
+      int size: point size to rasterize the font at
+    Returns: GlyphAtlas* pointer to the new atlas, or NULL on failure
+    ---------------------------------------------------------------------- */
+GlyphAtlas* atlas_create(SDL_Renderer* renderer, TTF_Font* font, int size) {
+  if (renderer == NULL || font == NULL) {
+    return NULL;
+  }
+  if (TTF_SetFontSize(font, size) < 0) {
+    SDL_LogError(LOGCAT, "Failed to set font size %d: %s",
+      size, TTF_GetError());
+    return NULL;
+  }
+
+  GlyphAtlas* atlas = calloc(1, sizeof(GlyphAtlas));
+  if (atlas == NULL) {
+    return NULL;
+  }
+  atlas->size = size;
+  atlas->line_skip = TTF_FontLineSkip(font);
+  int glyph_h = TTF_FontHeight(font);
+
+  // rasterize every glyph and lay them out in rows
+  SDL_Color white = { .r = 255, .g = 255, .b = 255, .a = 255 };
+  SDL_Surface* surfaces[ATLAS_GLYPHS] = {0};
+  int pen_x = 0;
+  int pen_y = 0;
+  for (int i = 0; i < ATLAS_GLYPHS; i++) {
+    Uint16 ch = ATLAS_FIRST_GLYPH + i;
+    Glyph* glyph = &atlas->glyphs[i];
+    TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &glyph->advance);
+
+    surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+    if (surfaces[i] == NULL) {
+      continue;
+    }
+    if (pen_x + surfaces[i]->w > ATLAS_WIDTH) {
+      pen_x = 0;
+      pen_y += glyph_h + 1;
+    }
+    glyph->src = (SDL_Rect){ pen_x, pen_y, surfaces[i]->w, surfaces[i]->h };
+    pen_x += surfaces[i]->w + 1;
+  }
+  atlas->width = ATLAS_WIDTH;
+  atlas->height = pen_y + glyph_h + 1;
+
+  // copy the glyphs into one surface and upload it once
+  SDL_Surface* sheet = SDL_CreateRGBSurfaceWithFormat(
+    0, atlas->width, atlas->height, 32, SDL_PIXELFORMAT_RGBA32);
+  if (sheet != NULL) {
+    for (int i = 0; i < ATLAS_GLYPHS; i++) {
+      if (surfaces[i] != NULL) {
+        SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i].src);
+      }
+    }
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+  }
+  for (int i = 0; i < ATLAS_GLYPHS; i++) {
+    SDL_FreeSurface(surfaces[i]);
+  }
+
+  if (atlas->texture == NULL) {
+    SDL_LogError(LOGCAT, "Failed to create glyph atlas: %s", SDL_GetError());
+    free(atlas);
+    return NULL;
+  }
+  SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+  // two triangles per quad, the index pattern never changes
+  for (int q = 0; q < ATLAS_MAX_QUADS; q++) {
+    int* index = &atlas->indices[q * 6];
+    index[0] = q * 4;
+    index[1] = q * 4 + 1;
+    index[2] = q * 4 + 2;
+    index[3] = q * 4 + 2;
+    index[4] = q * 4 + 3;
+    index[5] = q * 4;
+  }
+  return atlas;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Free an atlas and its texture
+    Parameters:
+      GlyphAtlas* atlas: pointer to the atlas, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void atlas_destroy(GlyphAtlas* atlas) {
+  if (atlas == NULL) {
+    return;
+  }
+  SDL_DestroyTexture(atlas->texture);
+  free(atlas);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Measure the size of a string as drawn by atlas_draw().
+    Lines are separated by '\n'.
+    Parameters:
+      GlyphAtlas* atlas: pointer to the atlas
+      const char* text: string to measure
+      int* w: set to the width of the widest line in pixels
+      int* h: set to the height of all lines in pixels
+    Returns: none
+    ---------------------------------------------------------------------- */
+void atlas_measure(GlyphAtlas* atlas, const char* text, int* w, int* h) {
+  int width = 0;
+  int line_w = 0;
+  int lines = 1;
+  for (const char* c = text; *c; c++) {
+    if (*c == '\n') {
+      lines++;
+      line_w = 0;
+      continue;
+    }
+    if (*c >= ATLAS_FIRST_GLYPH && *c <= ATLAS_LAST_GLYPH) {
+      line_w += atlas->glyphs[*c - ATLAS_FIRST_GLYPH].advance;
+    }
+    if (line_w > width) {
+      width = line_w;
+    }
+  }
+  *w = width;
+  *h = lines * atlas->line_skip;
+}
+
+/*  ----------------------------------------------------------------------
+    Submit the first 'quads' quads of the atlas vertex buffer in one call
+    ---------------------------------------------------------------------- */
+static int flush_quads(SDL_Renderer* renderer, GlyphAtlas* atlas, int quads) {
+  if (quads == 0) {
+    return 0;
+  }
+  SDL_RenderGeometry(renderer, atlas->texture,
+    atlas->vertices, quads * 4, atlas->indices, quads * 6);
+  return 1;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Draw a string with its top left corner at x, y. Lines are
+    separated by '\n' and left aligned. Characters outside printable ASCII
+    are skipped. The whole string is submitted with a single
+    SDL_RenderGeometry() call (one per ATLAS_MAX_QUADS glyphs).
+    Parameters:
+      SDL_Renderer* renderer: renderer to draw with
+      GlyphAtlas* atlas: pointer to the atlas, nothing is drawn if NULL
+      const char* text: string to draw
+      int x, int y: position of the top left corner of the text
+      SDL_Color color: text color
+    Returns: number of draw calls submitted
+    ---------------------------------------------------------------------- */
+int atlas_draw(SDL_Renderer* renderer, GlyphAtlas* atlas,
+  const char* text, int x, int y, SDL_Color color) {
+  if (atlas == NULL) {
+    return 0;
+  }
+  float tex_w = atlas->width;
+  float tex_h = atlas->height;
+  int pen_x = x;
+  int pen_y = y;
+  int quads = 0;
+  int calls = 0;
+
+  for (const char* c = text; *c; c++) {
+    if (*c == '\n') {
+      pen_x = x;
+      pen_y += atlas->line_skip;
+      continue;
+    }
+    if (*c < ATLAS_FIRST_GLYPH || *c > ATLAS_LAST_GLYPH) {
+      continue;
+    }
+    Glyph* glyph = &atlas->glyphs[*c - ATLAS_FIRST_GLYPH];
+    SDL_Rect* src = &glyph->src;
+
+    if (src->w > 0 && *c != ' ') {
+      float x0 = pen_x;
+      float y0 = pen_y;
+      float x1 = x0 + src->w;
+      float y1 = y0 + src->h;
+      float u0 = src->x / tex_w;
+      float v0 = src->y / tex_h;
+      float u1 = (src->x + src->w) / tex_w;
+      float v1 = (src->y + src->h) / tex_h;
+
+      SDL_Vertex* v = &atlas->vertices[quads * 4];
+      v[0] = (SDL_Vertex){ { x0, y0 }, color, { u0, v0 } };
+      v[1] = (SDL_Vertex){ { x1, y0 }, color, { u1, v0 } };
+      v[2] = (SDL_Vertex){ { x1, y1 }, color, { u1, v1 } };
+      v[3] = (SDL_Vertex){ { x0, y1 }, color, { u0, v1 } };
+
+      if (++quads == ATLAS_MAX_QUADS) {
+        calls += flush_quads(renderer, atlas, quads);
+        quads = 0;
+      }
+    }
+    pen_x += glyph->advance;
+  }
+  return calls + flush_quads(renderer, atlas, quads);
+}
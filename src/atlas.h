@@ -0,0 +1,84 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+// printable ASCII, the only characters the game draws
+#define ATLAS_FIRST_GLYPH 32
+#define ATLAS_LAST_GLYPH 126
+#define ATLAS_GLYPHS (ATLAS_LAST_GLYPH - ATLAS_FIRST_GLYPH + 1)
+#define ATLAS_WIDTH 512
+#define ATLAS_MAX_QUADS 128
+
+typedef struct Glyph Glyph;
+struct Glyph {
+  SDL_Rect src;
+  int advance;
+};
+
+/*
+  All printable glyphs of one font at one size, rasterized once into a
+  single texture. Strings are drawn as one batch of textured quads, so
+  steady state text costs no surface allocations or texture uploads.
+  The vertex and index buffers are reused for every string.
+*/
+typedef struct GlyphAtlas GlyphAtlas;
+struct GlyphAtlas {
+  SDL_Texture* texture;
+  int width;
+  int height;
+  int size;
+  int line_skip;
+  Glyph glyphs[ATLAS_GLYPHS];
+  SDL_Vertex vertices[ATLAS_MAX_QUADS * 4];
+  int indices[ATLAS_MAX_QUADS * 6];
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Rasterize the printable ASCII glyphs of a font at the
+    given size into a new atlas texture. The font is left set to that size.
+    Parameters:
+      SDL_Renderer* renderer: renderer that will draw the text
+      TTF_Font* font: font to rasterize
+      int size: point size to rasterize the font at
+    Returns: GlyphAtlas* pointer to the new atlas, or NULL on failure
+    ---------------------------------------------------------------------- */
+GlyphAtlas* atlas_create(SDL_Renderer* renderer, TTF_Font* font, int size);
+
+/*  ----------------------------------------------------------------------
+    Description: Free an atlas and its texture
+    Parameters:
+      GlyphAtlas* atlas: pointer to the atlas, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void atlas_destroy(GlyphAtlas* atlas);
+
+/*  ----------------------------------------------------------------------
+    Description: Measure the size of a string as drawn by atlas_draw().
+    Lines are separated by '\n'.
+    Parameters:
+      GlyphAtlas* atlas: pointer to the atlas
+      const char* text: string to measure
+      int* w: set to the width of the widest line in pixels
+      int* h: set to the height of all lines in pixels
+    Returns: none
+    ---------------------------------------------------------------------- */
+void atlas_measure(GlyphAtlas* atlas, const char* text, int* w, int* h);
+
+/*  ----------------------------------------------------------------------
+    Description: Draw a string with its top left corner at x, y. Lines are
+    separated by '\n' and left aligned. Characters outside printable ASCII
+    are skipped.
+    Parameters:
+      SDL_Renderer* renderer: renderer to draw with
+      GlyphAtlas* atlas: pointer to the atlas, nothing is drawn if NULL
+      const char* text: string to draw
+      int x, int y: position of the top left corner of the text
+      SDL_Color color: text color
+    Returns: number of draw calls submitted
+    ---------------------------------------------------------------------- */
+int atlas_draw(SDL_Renderer* renderer, GlyphAtlas* atlas,
+  const char* text, int x, int y, SDL_Color color);
+
+#endif
@@ -0,0 +1,1396 @@
+// Structure-of-arrays batch simulator for many concurrent matches
+#include "batch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BATCH_X86_KERNELS 1
+#define BATCH_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Paddle bounds used by move_paddle()
+#define BATCH_PADDLE_MIN_Y (double)(COURT_OFFSIDE)
+#define BATCH_PADDLE_MAX_Y (double)(COURT_HEIGHT - PADDLE_H)
+// Lowest ball position before it rebounds from the bottom wall
+#define BATCH_BALL_MAX_Y (double)(SCREEN_HEIGHT - BALL_SIZE)
+// The same in fixed point, and where the ball leaves the court
+#define FIXED_BATCH_PADDLE_MIN_Y FIXED_INT(COURT_OFFSIDE)
+#define FIXED_BATCH_PADDLE_MAX_Y FIXED_INT(COURT_HEIGHT - PADDLE_H)
+#define FIXED_BATCH_BALL_MAX_Y FIXED_INT(SCREEN_HEIGHT - BALL_SIZE)
+#define FIXED_BATCH_GOAL_X FIXED_INT(SCREEN_WIDTH)
+
+/*  ----------------------------------------------------------------------
+    Copy one lane into Ball and Paddle objects so the scalar game logic
+    in pong.c can be applied to it, and copy the result back. The ball's
+    predicted targets are recomputed on the way back if its course changed.
+    ---------------------------------------------------------------------- */
+static void gather_lane(Batch* batch, int lane,
+  Ball* ball, Paddle* player, Paddle* robot) {
+  *ball = (Ball){
+    .speed = batch->speed[lane],
+    .dx = batch->dx[lane],
+    .dy = batch->dy[lane],
+    .x = batch->x[lane],
+    .y = batch->y[lane],
+    .fudge = batch->fudge[lane],
+    .h = BALL_SIZE,
+    .w = BALL_SIZE,
+    .time_step = batch->time_step,
+    .predicted = true,
+    .player_target_y = batch->player_target_y[lane],
+    .robot_target_y = batch->robot_target_y[lane],
+  };
+  reset_paddle(player, PLAYER);
+  player->y = batch->player_y[lane];
+  player->dy = batch->player_dy[lane];
+  reset_paddle(robot, ROBOT);
+  robot->y = batch->robot_y[lane];
+  robot->dy = batch->robot_dy[lane];
+}
+
+static void scatter_ball(Batch* batch, int lane, Ball* ball) {
+  // a paddle hit or serve changed the ball's course
+  if (!ball->predicted) {
+    predict_ball(ball);
+  }
+  batch->player_target_y[lane] = ball->player_target_y;
+  batch->robot_target_y[lane] = ball->robot_target_y;
+  batch->speed[lane] = ball->speed;
+  batch->dx[lane] = ball->dx;
+  batch->dy[lane] = ball->dy;
+  batch->x[lane] = ball->x;
+  batch->y[lane] = ball->y;
+  batch->fudge[lane] = ball->fudge;
+}
+
+/*  ----------------------------------------------------------------------
+    Kernel pass 1: update_player() for both paddles, then a test whether
+    the ball's leading edge can reach the face of the paddle it is moving
+    towards within this tick. Those lanes are marked in near and appended to
+    hit_lanes; sweep_ball() resolves them after pass 2.
+    Kernel pass 2: move_paddle() for both paddles and move_ball(), with
+    the wall bounce reflected about the wall. Lanes marked near keep their
+    ball untouched; other lanes where the ball left the court are appended
+    to goal_lanes.
+    ---------------------------------------------------------------------- */
+static void ai_collide_scalar(Batch* b, int begin) {
+  for (int i = begin; i < b->lanes; i++) {
+    double step = PADDLE_SPEED - b->fudge[i];
+
+    // a ball past a paddle face has left its predicted course: chase it
+    bool past = b->x[i] < ROBOT_X + PADDLE_W || b->x[i] > PLAYER_X - BALL_SIZE;
+    double player_target_y = past ? b->y[i] : b->player_target_y[i];
+    double robot_target_y = past ? b->y[i] : b->robot_target_y[i];
+
+    int target_top = player_target_y;
+    int target_bottom = player_target_y + BALL_SIZE;
+    int player_top = b->player_y[i];
+    int player_bottom = b->player_y[i] + PADDLE_H;
+    b->player_dy[i] = (target_top < player_top ? -step : 0) +
+      (target_bottom > player_bottom ? step : 0);
+
+    target_top = robot_target_y;
+    target_bottom = robot_target_y + BALL_SIZE;
+    int robot_top = b->robot_y[i];
+    int robot_bottom = b->robot_y[i] + PADDLE_H;
+    b->robot_dy[i] = (target_top < robot_top ? -step : 0) +
+      (target_bottom > robot_bottom ? step : 0);
+
+    double reach = b->dx[i] * b->speed[i] * b->time_step;
+    double player_gap = PLAYER_X - (b->x[i] + BALL_SIZE);
+    double robot_gap = b->x[i] - (ROBOT_X + PADDLE_W);
+    bool near =
+      (player_gap >= 0 && player_gap <= reach) ||
+      (robot_gap >= 0 && robot_gap <= -reach);
+    b->near[i] = near;
+    if (near) {
+      b->hit_lanes[b->hit_count++] = i;
+    }
+  }
+}
+
+static void move_scalar(Batch* b, int begin) {
+  double ts = b->time_step;
+  for (int i = begin; i < b->lanes; i++) {
+    double player_y = b->player_y[i] + b->player_dy[i] * PADDLE_SPEED * ts;
+    player_y = player_y < BATCH_PADDLE_MIN_Y ? BATCH_PADDLE_MIN_Y : player_y;
+    player_y = player_y > BATCH_PADDLE_MAX_Y ? BATCH_PADDLE_MAX_Y : player_y;
+    b->player_y[i] = player_y;
+
+    double robot_y = b->robot_y[i] + b->robot_dy[i] * PADDLE_SPEED * ts;
+    robot_y = robot_y < BATCH_PADDLE_MIN_Y ? BATCH_PADDLE_MIN_Y : robot_y;
+    robot_y = robot_y > BATCH_PADDLE_MAX_Y ? BATCH_PADDLE_MAX_Y : robot_y;
+    b->robot_y[i] = robot_y;
+
+    if (b->near[i]) {
+      continue;
+    }
+    double x = b->x[i] + b->dx[i] * b->speed[i] * ts;
+    double y = b->y[i] + b->dy[i] * b->speed[i] * ts;
+    if (y < 0) {
+      y = -y;
+      b->dy[i] = -b->dy[i];
+    } else if (y > BATCH_BALL_MAX_Y) {
+      y = 2 * BATCH_BALL_MAX_Y - y;
+      b->dy[i] = -b->dy[i];
+    }
+    b->x[i] = x;
+    b->y[i] = y;
+    if (x < 0 || x > SCREEN_WIDTH) {
+      b->goal_lanes[b->goal_count++] = i;
+    }
+  }
+}
+
+#ifdef BATCH_X86_KERNELS
+
+BATCH_TARGET("sse2")
+static __m128d trunc_sse2(__m128d v) {
+  return _mm_cvtepi32_pd(_mm_cvttpd_epi32(v));
+}
+
+BATCH_TARGET("sse2")
+static __m128d chase_sse2(__m128d target_y, __m128d paddle_y,
+  __m128d step) {
+  __m128d ball_top = trunc_sse2(target_y);
+  __m128d ball_bottom =
+    trunc_sse2(_mm_add_pd(target_y, _mm_set1_pd(BALL_SIZE)));
+  __m128d top = trunc_sse2(paddle_y);
+  __m128d bottom = trunc_sse2(_mm_add_pd(paddle_y, _mm_set1_pd(PADDLE_H)));
+  __m128d up = _mm_and_pd(_mm_cmplt_pd(ball_top, top),
+    _mm_sub_pd(_mm_setzero_pd(), step));
+  __m128d down = _mm_and_pd(_mm_cmpgt_pd(ball_bottom, bottom), step);
+  return _mm_add_pd(up, down);
+}
+
+BATCH_TARGET("sse2")
+static __m128d near_sse2(__m128d x, __m128d reach) {
+  __m128d zero = _mm_setzero_pd();
+  __m128d player_gap =
+    _mm_sub_pd(_mm_set1_pd(PLAYER_X - BALL_SIZE), x);
+  __m128d robot_gap = _mm_sub_pd(x, _mm_set1_pd(ROBOT_X + PADDLE_W));
+  __m128d player = _mm_and_pd(_mm_cmpge_pd(player_gap, zero),
+    _mm_cmple_pd(player_gap, reach));
+  __m128d robot = _mm_and_pd(_mm_cmpge_pd(robot_gap, zero),
+    _mm_cmple_pd(robot_gap, _mm_sub_pd(zero, reach)));
+  return _mm_or_pd(player, robot);
+}
+
+BATCH_TARGET("sse2")
+static __m128d select_sse2(__m128d mask, __m128d a, __m128d b) {
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+// lanes whose ball is past a paddle face, chased where it is
+BATCH_TARGET("sse2")
+static __m128d past_sse2(__m128d x) {
+  return _mm_or_pd(_mm_cmplt_pd(x, _mm_set1_pd(ROBOT_X + PADDLE_W)),
+    _mm_cmpgt_pd(x, _mm_set1_pd(PLAYER_X - BALL_SIZE)));
+}
+
+BATCH_TARGET("sse2")
+static int ai_collide_sse2(Batch* b) {
+  int i = 0;
+  for (; i + 2 <= b->lanes; i += 2) {
+    __m128d x = _mm_loadu_pd(b->x + i);
+    __m128d y = _mm_loadu_pd(b->y + i);
+    __m128d past = past_sse2(x);
+    __m128d step = _mm_sub_pd(_mm_set1_pd(PADDLE_SPEED),
+      _mm_loadu_pd(b->fudge + i));
+
+    _mm_storeu_pd(b->player_dy + i, chase_sse2(
+      select_sse2(past, y, _mm_loadu_pd(b->player_target_y + i)),
+      _mm_loadu_pd(b->player_y + i), step));
+    _mm_storeu_pd(b->robot_dy + i, chase_sse2(
+      select_sse2(past, y, _mm_loadu_pd(b->robot_target_y + i)),
+      _mm_loadu_pd(b->robot_y + i), step));
+
+    __m128d reach = _mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(b->dx + i),
+      _mm_loadu_pd(b->speed + i)), _mm_set1_pd(b->time_step));
+    __m128d near = near_sse2(x, reach);
+    _mm_storeu_pd(b->near + i, _mm_and_pd(near, _mm_set1_pd(1)));
+    int mask = _mm_movemask_pd(near);
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->hit_lanes[b->hit_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("sse2")
+static __m128d move_paddle_sse2(__m128d paddle_y, __m128d paddle_dy,
+  __m128d ts) {
+  paddle_y = _mm_add_pd(paddle_y,
+    _mm_mul_pd(_mm_mul_pd(paddle_dy, _mm_set1_pd(PADDLE_SPEED)), ts));
+  paddle_y = _mm_max_pd(paddle_y, _mm_set1_pd(BATCH_PADDLE_MIN_Y));
+  return _mm_min_pd(paddle_y, _mm_set1_pd(BATCH_PADDLE_MAX_Y));
+}
+
+BATCH_TARGET("sse2")
+static int move_sse2(Batch* b) {
+  __m128d ts = _mm_set1_pd(b->time_step);
+  __m128d sign = _mm_set1_pd(-0.0);
+  __m128d max_y = _mm_set1_pd(BATCH_BALL_MAX_Y);
+  int i = 0;
+  for (; i + 2 <= b->lanes; i += 2) {
+    _mm_storeu_pd(b->player_y + i, move_paddle_sse2(
+      _mm_loadu_pd(b->player_y + i), _mm_loadu_pd(b->player_dy + i), ts));
+    _mm_storeu_pd(b->robot_y + i, move_paddle_sse2(
+      _mm_loadu_pd(b->robot_y + i), _mm_loadu_pd(b->robot_dy + i), ts));
+
+    __m128d near = _mm_cmpneq_pd(_mm_loadu_pd(b->near + i),
+      _mm_setzero_pd());
+    __m128d speed = _mm_loadu_pd(b->speed + i);
+    __m128d dx = _mm_loadu_pd(b->dx + i);
+    __m128d dy0 = _mm_loadu_pd(b->dy + i);
+    __m128d x0 = _mm_loadu_pd(b->x + i);
+    __m128d y0 = _mm_loadu_pd(b->y + i);
+    __m128d x = _mm_add_pd(x0, _mm_mul_pd(_mm_mul_pd(dx, speed), ts));
+    __m128d y = _mm_add_pd(y0, _mm_mul_pd(_mm_mul_pd(dy0, speed), ts));
+
+    // reflect lanes that went past the top or bottom wall and flip dy
+    __m128d top = _mm_cmplt_pd(y, _mm_setzero_pd());
+    __m128d bottom = _mm_cmpgt_pd(y, max_y);
+    y = select_sse2(top, _mm_sub_pd(_mm_setzero_pd(), y), y);
+    y = select_sse2(bottom, _mm_sub_pd(_mm_add_pd(max_y, max_y), y), y);
+    __m128d dy = _mm_xor_pd(dy0, _mm_and_pd(_mm_or_pd(top, bottom), sign));
+
+    // near lanes are moved by sweep_ball() instead
+    _mm_storeu_pd(b->x + i, select_sse2(near, x0, x));
+    _mm_storeu_pd(b->y + i, select_sse2(near, y0, y));
+    _mm_storeu_pd(b->dy + i, select_sse2(near, dy0, dy));
+
+    int mask = _mm_movemask_pd(_mm_andnot_pd(near, _mm_or_pd(
+      _mm_cmplt_pd(x, _mm_setzero_pd()),
+      _mm_cmpgt_pd(x, _mm_set1_pd(SCREEN_WIDTH)))));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->goal_lanes[b->goal_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("avx2")
+static __m256d trunc_avx2(__m256d v) {
+  return _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+}
+
+BATCH_TARGET("avx2")
+static __m256d chase_avx2(__m256d target_y, __m256d paddle_y,
+  __m256d step) {
+  __m256d ball_top = trunc_avx2(target_y);
+  __m256d ball_bottom =
+    trunc_avx2(_mm256_add_pd(target_y, _mm256_set1_pd(BALL_SIZE)));
+  __m256d top = trunc_avx2(paddle_y);
+  __m256d bottom =
+    trunc_avx2(_mm256_add_pd(paddle_y, _mm256_set1_pd(PADDLE_H)));
+  __m256d up = _mm256_and_pd(_mm256_cmp_pd(ball_top, top, _CMP_LT_OQ),
+    _mm256_sub_pd(_mm256_setzero_pd(), step));
+  __m256d down =
+    _mm256_and_pd(_mm256_cmp_pd(ball_bottom, bottom, _CMP_GT_OQ), step);
+  return _mm256_add_pd(up, down);
+}
+
+BATCH_TARGET("avx2")
+static __m256d near_avx2(__m256d x, __m256d reach) {
+  __m256d zero = _mm256_setzero_pd();
+  __m256d player_gap =
+    _mm256_sub_pd(_mm256_set1_pd(PLAYER_X - BALL_SIZE), x);
+  __m256d robot_gap =
+    _mm256_sub_pd(x, _mm256_set1_pd(ROBOT_X + PADDLE_W));
+  __m256d player = _mm256_and_pd(
+    _mm256_cmp_pd(player_gap, zero, _CMP_GE_OQ),
+    _mm256_cmp_pd(player_gap, reach, _CMP_LE_OQ));
+  __m256d robot = _mm256_and_pd(
+    _mm256_cmp_pd(robot_gap, zero, _CMP_GE_OQ),
+    _mm256_cmp_pd(robot_gap, _mm256_sub_pd(zero, reach), _CMP_LE_OQ));
+  return _mm256_or_pd(player, robot);
+}
+
+BATCH_TARGET("avx2")
+static __m256d past_avx2(__m256d x) {
+  return _mm256_or_pd(
+    _mm256_cmp_pd(x, _mm256_set1_pd(ROBOT_X + PADDLE_W), _CMP_LT_OQ),
+    _mm256_cmp_pd(x, _mm256_set1_pd(PLAYER_X - BALL_SIZE), _CMP_GT_OQ));
+}
+
+BATCH_TARGET("avx2")
+static int ai_collide_avx2(Batch* b) {
+  int i = 0;
+  for (; i + 4 <= b->lanes; i += 4) {
+    __m256d x = _mm256_loadu_pd(b->x + i);
+    __m256d y = _mm256_loadu_pd(b->y + i);
+    __m256d past = past_avx2(x);
+    __m256d step = _mm256_sub_pd(_mm256_set1_pd(PADDLE_SPEED),
+      _mm256_loadu_pd(b->fudge + i));
+
+    _mm256_storeu_pd(b->player_dy + i, chase_avx2(
+      _mm256_blendv_pd(_mm256_loadu_pd(b->player_target_y + i), y, past),
+      _mm256_loadu_pd(b->player_y + i), step));
+    _mm256_storeu_pd(b->robot_dy + i, chase_avx2(
+      _mm256_blendv_pd(_mm256_loadu_pd(b->robot_target_y + i), y, past),
+      _mm256_loadu_pd(b->robot_y + i), step));
+
+    __m256d reach = _mm256_mul_pd(_mm256_mul_pd(
+      _mm256_loadu_pd(b->dx + i), _mm256_loadu_pd(b->speed + i)),
+      _mm256_set1_pd(b->time_step));
+    __m256d near = near_avx2(x, reach);
+    _mm256_storeu_pd(b->near + i, _mm256_and_pd(near, _mm256_set1_pd(1)));
+    int mask = _mm256_movemask_pd(near);
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->hit_lanes[b->hit_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("avx2")
+static __m256d move_paddle_avx2(__m256d paddle_y, __m256d paddle_dy,
+  __m256d ts) {
+  paddle_y = _mm256_add_pd(paddle_y, _mm256_mul_pd(
+    _mm256_mul_pd(paddle_dy, _mm256_set1_pd(PADDLE_SPEED)), ts));
+  paddle_y = _mm256_max_pd(paddle_y, _mm256_set1_pd(BATCH_PADDLE_MIN_Y));
+  return _mm256_min_pd(paddle_y, _mm256_set1_pd(BATCH_PADDLE_MAX_Y));
+}
+
+BATCH_TARGET("avx2")
+static int move_avx2(Batch* b) {
+  __m256d ts = _mm256_set1_pd(b->time_step);
+  __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d max_y = _mm256_set1_pd(BATCH_BALL_MAX_Y);
+  int i = 0;
+  for (; i + 4 <= b->lanes; i += 4) {
+    _mm256_storeu_pd(b->player_y + i, move_paddle_avx2(
+      _mm256_loadu_pd(b->player_y + i), _mm256_loadu_pd(b->player_dy + i),
+      ts));
+    _mm256_storeu_pd(b->robot_y + i, move_paddle_avx2(
+      _mm256_loadu_pd(b->robot_y + i), _mm256_loadu_pd(b->robot_dy + i),
+      ts));
+
+    __m256d near = _mm256_cmp_pd(_mm256_loadu_pd(b->near + i),
+      _mm256_setzero_pd(), _CMP_NEQ_OQ);
+    __m256d speed = _mm256_loadu_pd(b->speed + i);
+    __m256d dx = _mm256_loadu_pd(b->dx + i);
+    __m256d dy0 = _mm256_loadu_pd(b->dy + i);
+    __m256d x0 = _mm256_loadu_pd(b->x + i);
+    __m256d y0 = _mm256_loadu_pd(b->y + i);
+    __m256d x = _mm256_add_pd(x0, _mm256_mul_pd(_mm256_mul_pd(dx, speed), ts));
+    __m256d y =
+      _mm256_add_pd(y0, _mm256_mul_pd(_mm256_mul_pd(dy0, speed), ts));
+
+    // reflect lanes that went past the top or bottom wall and flip dy
+    __m256d top = _mm256_cmp_pd(y, _mm256_setzero_pd(), _CMP_LT_OQ);
+    __m256d bottom = _mm256_cmp_pd(y, max_y, _CMP_GT_OQ);
+    y = _mm256_blendv_pd(y, _mm256_sub_pd(_mm256_setzero_pd(), y), top);
+    y = _mm256_blendv_pd(y,
+      _mm256_sub_pd(_mm256_add_pd(max_y, max_y), y), bottom);
+    __m256d dy =
+      _mm256_xor_pd(dy0, _mm256_and_pd(_mm256_or_pd(top, bottom), sign));
+
+    // near lanes are moved by sweep_ball() instead
+    _mm256_storeu_pd(b->x + i, _mm256_blendv_pd(x, x0, near));
+    _mm256_storeu_pd(b->y + i, _mm256_blendv_pd(y, y0, near));
+    _mm256_storeu_pd(b->dy + i, _mm256_blendv_pd(dy, dy0, near));
+
+    int mask = _mm256_movemask_pd(_mm256_andnot_pd(near, _mm256_or_pd(
+      _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ),
+      _mm256_cmp_pd(x, _mm256_set1_pd(SCREEN_WIDTH), _CMP_GT_OQ))));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->goal_lanes[b->goal_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+#endif
+
+/*  ----------------------------------------------------------------------
+    Description: Get the display name of a batch kernel
+    Parameters:
+      BatchKernel kernel: kernel id
+    Returns: kernel name
+    ---------------------------------------------------------------------- */
+const char* batch_kernel_name(BatchKernel kernel) {
+  switch (kernel) {
+  case BATCH_KERNEL_SCALAR:
+    return "scalar";
+  case BATCH_KERNEL_SSE2:
+    return "sse2";
+  case BATCH_KERNEL_AVX2:
+    return "avx2";
+  default:
+    return "auto";
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Look up a batch kernel by its display name
+    Parameters:
+      const char* name: "auto", "scalar", "sse2" or "avx2"
+      BatchKernel* kernel: set to the matching kernel id
+    Returns: true if the name is known, otherwise false
+    ---------------------------------------------------------------------- */
+bool batch_kernel_from_name(const char* name, BatchKernel* kernel) {
+  for (BatchKernel k = BATCH_KERNEL_AUTO; k <= BATCH_KERNEL_AVX2; k++) {
+    if (strcmp(name, batch_kernel_name(k)) == 0) {
+      *kernel = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Pick the kernel to run: the requested one if this build
+    and CPU support it, otherwise the widest one that is supported.
+    ---------------------------------------------------------------------- */
+static BatchKernel select_kernel(BatchKernel requested) {
+  BatchKernel best = BATCH_KERNEL_SCALAR;
+#ifdef BATCH_X86_KERNELS
+  if (SDL_HasAVX2()) {
+    best = BATCH_KERNEL_AVX2;
+  } else if (SDL_HasSSE2()) {
+    best = BATCH_KERNEL_SSE2;
+  }
+#endif
+  if (requested == BATCH_KERNEL_AUTO) {
+    return best;
+  }
+  if (requested > best) {
+    SDL_LogWarn(LOGCAT, "Batch kernel '%s' not supported, using '%s'",
+      batch_kernel_name(requested), batch_kernel_name(best));
+    return best;
+  }
+  return requested;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a batch of matches, each reset for a new game.
+    Parameters:
+      int matches: number of concurrent matches, rounded up to a multiple
+      of BATCH_LANE_PAD
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use, BATCH_KERNEL_AUTO picks the
+      widest one supported by the CPU
+      Uint64 seed: seed of the batch's random number generator
+    Returns: Batch* pointer to new batch, or NULL on allocation failure
+    ---------------------------------------------------------------------- */
+Batch* batch_create(int matches, double time_step, BatchKernel kernel,
+  Uint64 seed) {
+  Batch* batch = calloc(1, sizeof(Batch));
+  if (batch == NULL) {
+    return NULL;
+  }
+  batch->lanes = (matches + BATCH_LANE_PAD - 1) / BATCH_LANE_PAD * BATCH_LANE_PAD;
+  batch->time_step = time_step;
+  batch->kernel = select_kernel(kernel);
+  rng_seed(&batch->rng, seed);
+
+  size_t doubles = batch->lanes * sizeof(double);
+  size_t ints = batch->lanes * sizeof(int);
+  double** double_arrays[] = {
+    &batch->x, &batch->y, &batch->dx, &batch->dy, &batch->speed,
+    &batch->fudge, &batch->player_y, &batch->player_dy, &batch->robot_y,
+    &batch->robot_dy, &batch->player_target_y, &batch->robot_target_y,
+    &batch->near
+  };
+  int** int_arrays[] = {
+    &batch->player_score, &batch->robot_score,
+    &batch->hit_lanes, &batch->goal_lanes
+  };
+  bool ok = true;
+  for (size_t i = 0; i < SDL_arraysize(double_arrays); i++) {
+    *double_arrays[i] = SDL_SIMDAlloc(doubles);
+    ok = ok && *double_arrays[i] != NULL;
+  }
+  for (size_t i = 0; i < SDL_arraysize(int_arrays); i++) {
+    *int_arrays[i] = SDL_SIMDAlloc(ints);
+    ok = ok && *int_arrays[i] != NULL;
+  }
+  if (!ok) {
+    SDL_LogError(LOGCAT, "Failed to allocate batch of %d matches", matches);
+    batch_destroy(batch);
+    return NULL;
+  }
+
+  for (int lane = 0; lane < batch->lanes; lane++) {
+    batch_reset_lane(batch, lane);
+  }
+  return batch;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch created by batch_create()
+    Parameters:
+      Batch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_destroy(Batch* batch) {
+  if (batch == NULL) {
+    return;
+  }
+  SDL_SIMDFree(batch->x);
+  SDL_SIMDFree(batch->y);
+  SDL_SIMDFree(batch->dx);
+  SDL_SIMDFree(batch->dy);
+  SDL_SIMDFree(batch->speed);
+  SDL_SIMDFree(batch->fudge);
+  SDL_SIMDFree(batch->player_y);
+  SDL_SIMDFree(batch->player_dy);
+  SDL_SIMDFree(batch->robot_y);
+  SDL_SIMDFree(batch->robot_dy);
+  SDL_SIMDFree(batch->player_target_y);
+  SDL_SIMDFree(batch->robot_target_y);
+  SDL_SIMDFree(batch->near);
+  SDL_SIMDFree(batch->player_score);
+  SDL_SIMDFree(batch->robot_score);
+  SDL_SIMDFree(batch->hit_lanes);
+  SDL_SIMDFree(batch->goal_lanes);
+  free(batch);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Reset a single lane to the start of a new game, mirroring
+    reset_match()
+    Parameters:
+      Batch* batch: pointer to the batch
+      int lane: lane index
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_reset_lane(Batch* batch, int lane) {
+  Ball ball = {0};
+  reset_ball(&ball, ROBOT, &batch->rng);
+  ball.speed = BALL_MIN_SPEED;
+  scatter_ball(batch, lane, &ball);
+
+  batch->player_y[lane] = PADDLE_Y;
+  batch->player_dy[lane] = 0;
+  batch->robot_y[lane] = PADDLE_Y;
+  batch->robot_dy[lane] = 0;
+  batch->player_score[lane] = 0;
+  batch->robot_score[lane] = 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Advance every match in the batch by one tick, following
+    the same sequence as step_match(): update_player() for both paddles,
+    move_paddle(), the ball's movement and scoring. The AI, paddle
+    movement and ball movement with wall bounces run as vector kernels;
+    lanes where the ball may reach a paddle this tick and goals, which are
+    rare per tick, are resolved per lane with the scalar sweep_ball() and
+    reset_ball() from pong.c.
+    Parameters:
+      Batch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_step(Batch* batch) {
+  Ball ball;
+  Paddle player;
+  Paddle robot;
+  int done = 0;
+
+  batch->hit_count = 0;
+#ifdef BATCH_X86_KERNELS
+  if (batch->kernel == BATCH_KERNEL_AVX2) {
+    done = ai_collide_avx2(batch);
+  } else if (batch->kernel == BATCH_KERNEL_SSE2) {
+    done = ai_collide_sse2(batch);
+  }
+#endif
+  ai_collide_scalar(batch, done);
+
+  batch->goal_count = 0;
+  done = 0;
+#ifdef BATCH_X86_KERNELS
+  if (batch->kernel == BATCH_KERNEL_AVX2) {
+    done = move_avx2(batch);
+  } else if (batch->kernel == BATCH_KERNEL_SSE2) {
+    done = move_sse2(batch);
+  }
+#endif
+  move_scalar(batch, done);
+
+  // sweep the ball against the moved paddles in lanes that may reach one
+  for (int i = 0; i < batch->hit_count; i++) {
+    int lane = batch->hit_lanes[i];
+    gather_lane(batch, lane, &ball, &player, &robot);
+    sweep_ball(&ball, &player, &robot, &batch->rng, NULL);
+    scatter_ball(batch, lane, &ball);
+    if (ball.x < 0 || ball.x > SCREEN_WIDTH) {
+      batch->goal_lanes[batch->goal_count++] = lane;
+    }
+  }
+
+  // score points, serve, and start a new game in lanes that hit MAX_SCORE
+  for (int i = 0; i < batch->goal_count; i++) {
+    int lane = batch->goal_lanes[i];
+    Player scorer = batch->x[lane] < 0 ? PLAYER : ROBOT;
+    int score = scorer == PLAYER ?
+      ++batch->player_score[lane] : ++batch->robot_score[lane];
+
+    if (score >= MAX_SCORE) {
+      batch->matches++;
+      if (scorer == PLAYER) {
+        batch->player_wins++;
+      } else {
+        batch->robot_wins++;
+      }
+      batch_reset_lane(batch, lane);
+      continue;
+    }
+
+    gather_lane(batch, lane, &ball, &player, &robot);
+    reset_ball(&ball, scorer, &batch->rng);
+    Paddle* server = scorer == PLAYER ? &player : &robot;
+    ball.y = server->y + server->h / 2;
+    scatter_ball(batch, lane, &ball);
+  }
+
+  batch->ticks++;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Run concurrent matches in a batch until the given number
+    of matches has finished, then log ball-ticks/sec and matches/sec.
+    Parameters:
+      int lanes: number of concurrent matches
+      int matches: number of matches to finish
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use
+      Uint64 seed: seed of the batch's random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_batch(int lanes, int matches, double time_step, BatchKernel kernel,
+  Uint64 seed) {
+  Batch* batch = batch_create(lanes, time_step, kernel, seed);
+  if (batch == NULL) {
+    return;
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  while (batch->matches < (Uint64)matches &&
+    batch->ticks < HEADLESS_MAX_TICKS) {
+    batch_step(batch);
+  }
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+  if (elapsed <= 0) {
+    elapsed = 1e-9;
+  }
+
+  double ball_ticks = (double)batch->ticks * batch->lanes;
+  SDL_LogInfo(LOGCAT,
+    "Batch (%s): %d lanes, %llu matches (player %llu, robot %llu), "
+    "%llu ticks in %.3f s",
+    batch_kernel_name(batch->kernel), batch->lanes,
+    (unsigned long long)batch->matches,
+    (unsigned long long)batch->player_wins,
+    (unsigned long long)batch->robot_wins,
+    (unsigned long long)batch->ticks, elapsed);
+  SDL_LogInfo(LOGCAT, "Batch: %.0f ball-ticks/sec, %.1f matches/sec",
+    ball_ticks / elapsed, batch->matches / elapsed);
+
+  batch_destroy(batch);
+}
+
+/*  ----------------------------------------------------------------------
+    Copy one lane of a fixed point batch into FixedBall and FixedPaddle
+    objects for the scalar fixed point logic in fixed.c, and back.
+    ---------------------------------------------------------------------- */
+static void gather_fixed_lane(FixedBatch* batch, int lane,
+  FixedBall* ball, FixedPaddle* player, FixedPaddle* robot) {
+  *ball = (FixedBall){
+    .speed = batch->speed[lane],
+    .dx = batch->dx[lane],
+    .dy = batch->dy[lane],
+    .x = batch->x[lane],
+    .y = batch->y[lane],
+    .fudge = batch->fudge[lane],
+    .time_step = batch->time_step,
+    .predicted = true,
+    .player_target_y = batch->player_target_y[lane],
+    .robot_target_y = batch->robot_target_y[lane],
+  };
+  *player = (FixedPaddle){
+    .owner = PLAYER,
+    .speed = PADDLE_SPEED,
+    .dy = batch->player_dy[lane],
+    .time_step = batch->time_step,
+    .x = FIXED_INT(PLAYER_X),
+    .y = batch->player_y[lane],
+  };
+  *robot = (FixedPaddle){
+    .owner = ROBOT,
+    .speed = PADDLE_SPEED,
+    .dy = batch->robot_dy[lane],
+    .time_step = batch->time_step,
+    .x = FIXED_INT(ROBOT_X),
+    .y = batch->robot_y[lane],
+  };
+}
+
+static void scatter_fixed_ball(FixedBatch* batch, int lane, FixedBall* ball) {
+  if (!ball->predicted) {
+    fixed_predict_ball(ball);
+  }
+  batch->player_target_y[lane] = ball->player_target_y;
+  batch->robot_target_y[lane] = ball->robot_target_y;
+  batch->speed[lane] = ball->speed;
+  batch->dx[lane] = ball->dx;
+  batch->dy[lane] = ball->dy;
+  batch->x[lane] = ball->x;
+  batch->y[lane] = ball->y;
+  batch->fudge[lane] = ball->fudge;
+}
+
+/*  ----------------------------------------------------------------------
+    The two kernel passes of the double batch in fixed point. Velocities
+    are whole pixels per second, so velocity * time_step is a Fixed
+    distance in one 32 bit multiply. Positions compared as whole pixels
+    are never negative, so an arithmetic shift truncates them like the
+    (int) casts of update_player().
+    ---------------------------------------------------------------------- */
+static void ai_collide_fixed_scalar(FixedBatch* b, int begin) {
+  for (int i = begin; i < b->lanes; i++) {
+    Sint32 step = PADDLE_SPEED - b->fudge[i];
+
+    // a ball past a paddle face has left its predicted course: chase it
+    bool past = b->x[i] < FIXED_INT(ROBOT_X + PADDLE_W) ||
+      b->x[i] > FIXED_INT(PLAYER_X - BALL_SIZE);
+    Fixed player_target_y = past ? b->y[i] : b->player_target_y[i];
+    Fixed robot_target_y = past ? b->y[i] : b->robot_target_y[i];
+
+    Sint32 target_top = player_target_y >> FIXED_SHIFT;
+    Sint32 target_bottom =
+      (player_target_y + FIXED_INT(BALL_SIZE)) >> FIXED_SHIFT;
+    Sint32 player_top = b->player_y[i] >> FIXED_SHIFT;
+    Sint32 player_bottom =
+      (b->player_y[i] + FIXED_INT(PADDLE_H)) >> FIXED_SHIFT;
+    b->player_dy[i] = (target_top < player_top ? -step : 0) +
+      (target_bottom > player_bottom ? step : 0);
+
+    target_top = robot_target_y >> FIXED_SHIFT;
+    target_bottom =
+      (robot_target_y + FIXED_INT(BALL_SIZE)) >> FIXED_SHIFT;
+    Sint32 robot_top = b->robot_y[i] >> FIXED_SHIFT;
+    Sint32 robot_bottom =
+      (b->robot_y[i] + FIXED_INT(PADDLE_H)) >> FIXED_SHIFT;
+    b->robot_dy[i] = (target_top < robot_top ? -step : 0) +
+      (target_bottom > robot_bottom ? step : 0);
+
+    Fixed reach = b->dx[i] * b->speed[i] * b->time_step;
+    Fixed player_gap = FIXED_INT(PLAYER_X - BALL_SIZE) - b->x[i];
+    Fixed robot_gap = b->x[i] - FIXED_INT(ROBOT_X + PADDLE_W);
+    bool near =
+      (player_gap >= 0 && player_gap <= reach) ||
+      (robot_gap >= 0 && robot_gap <= -reach);
+    b->near[i] = near;
+    if (near) {
+      b->hit_lanes[b->hit_count++] = i;
+    }
+  }
+}
+
+static void move_fixed_scalar(FixedBatch* b, int begin) {
+  Fixed ts = b->time_step;
+  Fixed paddle_step = PADDLE_SPEED * ts;
+  for (int i = begin; i < b->lanes; i++) {
+    Fixed player_y = b->player_y[i] + b->player_dy[i] * paddle_step;
+    player_y = player_y < FIXED_BATCH_PADDLE_MIN_Y ?
+      FIXED_BATCH_PADDLE_MIN_Y : player_y;
+    player_y = player_y > FIXED_BATCH_PADDLE_MAX_Y ?
+      FIXED_BATCH_PADDLE_MAX_Y : player_y;
+    b->player_y[i] = player_y;
+
+    Fixed robot_y = b->robot_y[i] + b->robot_dy[i] * paddle_step;
+    robot_y = robot_y < FIXED_BATCH_PADDLE_MIN_Y ?
+      FIXED_BATCH_PADDLE_MIN_Y : robot_y;
+    robot_y = robot_y > FIXED_BATCH_PADDLE_MAX_Y ?
+      FIXED_BATCH_PADDLE_MAX_Y : robot_y;
+    b->robot_y[i] = robot_y;
+
+    if (b->near[i]) {
+      continue;
+    }
+    Fixed x = b->x[i] + b->dx[i] * b->speed[i] * ts;
+    Fixed y = b->y[i] + b->dy[i] * b->speed[i] * ts;
+    if (y < 0) {
+      y = -y;
+      b->dy[i] = -b->dy[i];
+    } else if (y > FIXED_BATCH_BALL_MAX_Y) {
+      y = 2 * FIXED_BATCH_BALL_MAX_Y - y;
+      b->dy[i] = -b->dy[i];
+    }
+    b->x[i] = x;
+    b->y[i] = y;
+    if (x < 0 || x > FIXED_BATCH_GOAL_X) {
+      b->goal_lanes[b->goal_count++] = i;
+    }
+  }
+}
+
+#ifdef BATCH_X86_KERNELS
+
+// SSE2 multiplies only the even 32 bit lanes; do the odd ones shifted down
+BATCH_TARGET("sse2")
+static __m128i mullo_sse2(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+BATCH_TARGET("sse2")
+static __m128i select_epi32_sse2(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+BATCH_TARGET("sse2")
+static __m128i clamp_sse2(__m128i v, Sint32 low, Sint32 high) {
+  __m128i lo = _mm_set1_epi32(low);
+  __m128i hi = _mm_set1_epi32(high);
+  v = select_epi32_sse2(_mm_cmplt_epi32(v, lo), lo, v);
+  return select_epi32_sse2(_mm_cmpgt_epi32(v, hi), hi, v);
+}
+
+BATCH_TARGET("sse2")
+static __m128i chase_fixed_sse2(__m128i target_y, __m128i paddle_y,
+  __m128i step) {
+  __m128i ball_top = _mm_srai_epi32(target_y, FIXED_SHIFT);
+  __m128i ball_bottom = _mm_srai_epi32(
+    _mm_add_epi32(target_y, _mm_set1_epi32(FIXED_INT(BALL_SIZE))),
+    FIXED_SHIFT);
+  __m128i top = _mm_srai_epi32(paddle_y, FIXED_SHIFT);
+  __m128i bottom = _mm_srai_epi32(
+    _mm_add_epi32(paddle_y, _mm_set1_epi32(FIXED_INT(PADDLE_H))),
+    FIXED_SHIFT);
+  __m128i up = _mm_and_si128(_mm_cmplt_epi32(ball_top, top),
+    _mm_sub_epi32(_mm_setzero_si128(), step));
+  __m128i down = _mm_and_si128(_mm_cmpgt_epi32(ball_bottom, bottom), step);
+  return _mm_add_epi32(up, down);
+}
+
+// lanes where 0 <= gap <= reach
+BATCH_TARGET("sse2")
+static __m128i within_sse2(__m128i gap, __m128i reach) {
+  return _mm_andnot_si128(_mm_or_si128(
+    _mm_cmplt_epi32(gap, _mm_setzero_si128()), _mm_cmpgt_epi32(gap, reach)),
+    _mm_set1_epi32(-1));
+}
+
+// lanes whose ball is past a paddle face, chased where it is
+BATCH_TARGET("sse2")
+static __m128i past_fixed_sse2(__m128i x) {
+  return _mm_or_si128(
+    _mm_cmplt_epi32(x, _mm_set1_epi32(FIXED_INT(ROBOT_X + PADDLE_W))),
+    _mm_cmpgt_epi32(x, _mm_set1_epi32(FIXED_INT(PLAYER_X - BALL_SIZE))));
+}
+
+BATCH_TARGET("sse2")
+static int ai_collide_fixed_sse2(FixedBatch* b) {
+  __m128i ts = _mm_set1_epi32(b->time_step);
+  int i = 0;
+  for (; i + 4 <= b->lanes; i += 4) {
+    __m128i x = _mm_loadu_si128((__m128i*)(b->x + i));
+    __m128i y = _mm_loadu_si128((__m128i*)(b->y + i));
+    __m128i past = past_fixed_sse2(x);
+    __m128i step = _mm_sub_epi32(_mm_set1_epi32(PADDLE_SPEED),
+      _mm_loadu_si128((__m128i*)(b->fudge + i)));
+
+    _mm_storeu_si128((__m128i*)(b->player_dy + i), chase_fixed_sse2(
+      select_epi32_sse2(past, y,
+      _mm_loadu_si128((__m128i*)(b->player_target_y + i))),
+      _mm_loadu_si128((__m128i*)(b->player_y + i)), step));
+    _mm_storeu_si128((__m128i*)(b->robot_dy + i), chase_fixed_sse2(
+      select_epi32_sse2(past, y,
+      _mm_loadu_si128((__m128i*)(b->robot_target_y + i))),
+      _mm_loadu_si128((__m128i*)(b->robot_y + i)), step));
+
+    __m128i reach = mullo_sse2(mullo_sse2(
+      _mm_loadu_si128((__m128i*)(b->dx + i)),
+      _mm_loadu_si128((__m128i*)(b->speed + i))), ts);
+    __m128i player_gap =
+      _mm_sub_epi32(_mm_set1_epi32(FIXED_INT(PLAYER_X - BALL_SIZE)), x);
+    __m128i robot_gap =
+      _mm_sub_epi32(x, _mm_set1_epi32(FIXED_INT(ROBOT_X + PADDLE_W)));
+    __m128i near = _mm_or_si128(within_sse2(player_gap, reach),
+      within_sse2(robot_gap, _mm_sub_epi32(_mm_setzero_si128(), reach)));
+    _mm_storeu_si128((__m128i*)(b->near + i),
+      _mm_and_si128(near, _mm_set1_epi32(1)));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(near));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->hit_lanes[b->hit_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("sse2")
+static int move_fixed_sse2(FixedBatch* b) {
+  __m128i ts = _mm_set1_epi32(b->time_step);
+  __m128i paddle_step = _mm_set1_epi32(PADDLE_SPEED * b->time_step);
+  __m128i zero = _mm_setzero_si128();
+  __m128i max_y = _mm_set1_epi32(FIXED_BATCH_BALL_MAX_Y);
+  int i = 0;
+  for (; i + 4 <= b->lanes; i += 4) {
+    __m128i player_y = _mm_add_epi32(
+      _mm_loadu_si128((__m128i*)(b->player_y + i)), mullo_sse2(
+      _mm_loadu_si128((__m128i*)(b->player_dy + i)), paddle_step));
+    _mm_storeu_si128((__m128i*)(b->player_y + i), clamp_sse2(player_y,
+      FIXED_BATCH_PADDLE_MIN_Y, FIXED_BATCH_PADDLE_MAX_Y));
+    __m128i robot_y = _mm_add_epi32(
+      _mm_loadu_si128((__m128i*)(b->robot_y + i)), mullo_sse2(
+      _mm_loadu_si128((__m128i*)(b->robot_dy + i)), paddle_step));
+    _mm_storeu_si128((__m128i*)(b->robot_y + i), clamp_sse2(robot_y,
+      FIXED_BATCH_PADDLE_MIN_Y, FIXED_BATCH_PADDLE_MAX_Y));
+
+    __m128i far = _mm_cmpeq_epi32(
+      _mm_loadu_si128((__m128i*)(b->near + i)), zero);
+    __m128i speed = _mm_loadu_si128((__m128i*)(b->speed + i));
+    __m128i dx = _mm_loadu_si128((__m128i*)(b->dx + i));
+    __m128i dy0 = _mm_loadu_si128((__m128i*)(b->dy + i));
+    __m128i x0 = _mm_loadu_si128((__m128i*)(b->x + i));
+    __m128i y0 = _mm_loadu_si128((__m128i*)(b->y + i));
+    __m128i x = _mm_add_epi32(x0, mullo_sse2(mullo_sse2(dx, speed), ts));
+    __m128i y = _mm_add_epi32(y0, mullo_sse2(mullo_sse2(dy0, speed), ts));
+
+    // reflect lanes that went past the top or bottom wall and flip dy
+    __m128i top = _mm_cmplt_epi32(y, zero);
+    __m128i bottom = _mm_cmpgt_epi32(y, max_y);
+    y = select_epi32_sse2(top, _mm_sub_epi32(zero, y), y);
+    y = select_epi32_sse2(bottom,
+      _mm_sub_epi32(_mm_add_epi32(max_y, max_y), y), y);
+    __m128i dy = select_epi32_sse2(_mm_or_si128(top, bottom),
+      _mm_sub_epi32(zero, dy0), dy0);
+
+    _mm_storeu_si128((__m128i*)(b->x + i), select_epi32_sse2(far, x, x0));
+    _mm_storeu_si128((__m128i*)(b->y + i), select_epi32_sse2(far, y, y0));
+    _mm_storeu_si128((__m128i*)(b->dy + i), select_epi32_sse2(far, dy, dy0));
+
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(far,
+      _mm_or_si128(_mm_cmplt_epi32(x, zero),
+      _mm_cmpgt_epi32(x, _mm_set1_epi32(FIXED_BATCH_GOAL_X))))));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->goal_lanes[b->goal_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("avx2")
+static __m256i chase_fixed_avx2(__m256i target_y, __m256i paddle_y,
+  __m256i step) {
+  __m256i ball_top = _mm256_srai_epi32(target_y, FIXED_SHIFT);
+  __m256i ball_bottom = _mm256_srai_epi32(
+    _mm256_add_epi32(target_y, _mm256_set1_epi32(FIXED_INT(BALL_SIZE))),
+    FIXED_SHIFT);
+  __m256i top = _mm256_srai_epi32(paddle_y, FIXED_SHIFT);
+  __m256i bottom = _mm256_srai_epi32(
+    _mm256_add_epi32(paddle_y, _mm256_set1_epi32(FIXED_INT(PADDLE_H))),
+    FIXED_SHIFT);
+  __m256i up = _mm256_and_si256(_mm256_cmpgt_epi32(top, ball_top),
+    _mm256_sub_epi32(_mm256_setzero_si256(), step));
+  __m256i down = _mm256_and_si256(_mm256_cmpgt_epi32(ball_bottom, bottom),
+    step);
+  return _mm256_add_epi32(up, down);
+}
+
+BATCH_TARGET("avx2")
+static __m256i within_avx2(__m256i gap, __m256i reach) {
+  return _mm256_andnot_si256(_mm256_or_si256(
+    _mm256_cmpgt_epi32(_mm256_setzero_si256(), gap),
+    _mm256_cmpgt_epi32(gap, reach)), _mm256_set1_epi32(-1));
+}
+
+BATCH_TARGET("avx2")
+static __m256i past_fixed_avx2(__m256i x) {
+  return _mm256_or_si256(_mm256_cmpgt_epi32(
+    _mm256_set1_epi32(FIXED_INT(ROBOT_X + PADDLE_W)), x),
+    _mm256_cmpgt_epi32(x, _mm256_set1_epi32(FIXED_INT(PLAYER_X - BALL_SIZE))));
+}
+
+BATCH_TARGET("avx2")
+static int ai_collide_fixed_avx2(FixedBatch* b) {
+  __m256i ts = _mm256_set1_epi32(b->time_step);
+  int i = 0;
+  for (; i + 8 <= b->lanes; i += 8) {
+    __m256i x = _mm256_loadu_si256((__m256i*)(b->x + i));
+    __m256i y = _mm256_loadu_si256((__m256i*)(b->y + i));
+    __m256i past = past_fixed_avx2(x);
+    __m256i step = _mm256_sub_epi32(_mm256_set1_epi32(PADDLE_SPEED),
+      _mm256_loadu_si256((__m256i*)(b->fudge + i)));
+
+    _mm256_storeu_si256((__m256i*)(b->player_dy + i), chase_fixed_avx2(
+      _mm256_blendv_epi8(
+      _mm256_loadu_si256((__m256i*)(b->player_target_y + i)), y, past),
+      _mm256_loadu_si256((__m256i*)(b->player_y + i)), step));
+    _mm256_storeu_si256((__m256i*)(b->robot_dy + i), chase_fixed_avx2(
+      _mm256_blendv_epi8(
+      _mm256_loadu_si256((__m256i*)(b->robot_target_y + i)), y, past),
+      _mm256_loadu_si256((__m256i*)(b->robot_y + i)), step));
+
+    __m256i reach = _mm256_mullo_epi32(_mm256_mullo_epi32(
+      _mm256_loadu_si256((__m256i*)(b->dx + i)),
+      _mm256_loadu_si256((__m256i*)(b->speed + i))), ts);
+    __m256i player_gap = _mm256_sub_epi32(
+      _mm256_set1_epi32(FIXED_INT(PLAYER_X - BALL_SIZE)), x);
+    __m256i robot_gap = _mm256_sub_epi32(x,
+      _mm256_set1_epi32(FIXED_INT(ROBOT_X + PADDLE_W)));
+    __m256i near = _mm256_or_si256(within_avx2(player_gap, reach),
+      within_avx2(robot_gap,
+      _mm256_sub_epi32(_mm256_setzero_si256(), reach)));
+    _mm256_storeu_si256((__m256i*)(b->near + i),
+      _mm256_and_si256(near, _mm256_set1_epi32(1)));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(near));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->hit_lanes[b->hit_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+BATCH_TARGET("avx2")
+static __m256i move_paddle_fixed_avx2(__m256i paddle_y, __m256i paddle_dy,
+  __m256i paddle_step) {
+  paddle_y = _mm256_add_epi32(paddle_y,
+    _mm256_mullo_epi32(paddle_dy, paddle_step));
+  paddle_y = _mm256_max_epi32(paddle_y,
+    _mm256_set1_epi32(FIXED_BATCH_PADDLE_MIN_Y));
+  return _mm256_min_epi32(paddle_y,
+    _mm256_set1_epi32(FIXED_BATCH_PADDLE_MAX_Y));
+}
+
+BATCH_TARGET("avx2")
+static int move_fixed_avx2(FixedBatch* b) {
+  __m256i ts = _mm256_set1_epi32(b->time_step);
+  __m256i paddle_step = _mm256_set1_epi32(PADDLE_SPEED * b->time_step);
+  __m256i zero = _mm256_setzero_si256();
+  __m256i max_y = _mm256_set1_epi32(FIXED_BATCH_BALL_MAX_Y);
+  int i = 0;
+  for (; i + 8 <= b->lanes; i += 8) {
+    _mm256_storeu_si256((__m256i*)(b->player_y + i), move_paddle_fixed_avx2(
+      _mm256_loadu_si256((__m256i*)(b->player_y + i)),
+      _mm256_loadu_si256((__m256i*)(b->player_dy + i)), paddle_step));
+    _mm256_storeu_si256((__m256i*)(b->robot_y + i), move_paddle_fixed_avx2(
+      _mm256_loadu_si256((__m256i*)(b->robot_y + i)),
+      _mm256_loadu_si256((__m256i*)(b->robot_dy + i)), paddle_step));
+
+    __m256i near = _mm256_cmpgt_epi32(
+      _mm256_loadu_si256((__m256i*)(b->near + i)), zero);
+    __m256i speed = _mm256_loadu_si256((__m256i*)(b->speed + i));
+    __m256i dx = _mm256_loadu_si256((__m256i*)(b->dx + i));
+    __m256i dy0 = _mm256_loadu_si256((__m256i*)(b->dy + i));
+    __m256i x0 = _mm256_loadu_si256((__m256i*)(b->x + i));
+    __m256i y0 = _mm256_loadu_si256((__m256i*)(b->y + i));
+    __m256i x = _mm256_add_epi32(x0,
+      _mm256_mullo_epi32(_mm256_mullo_epi32(dx, speed), ts));
+    __m256i y = _mm256_add_epi32(y0,
+      _mm256_mullo_epi32(_mm256_mullo_epi32(dy0, speed), ts));
+
+    // reflect lanes that went past the top or bottom wall and flip dy
+    __m256i top = _mm256_cmpgt_epi32(zero, y);
+    __m256i bottom = _mm256_cmpgt_epi32(y, max_y);
+    y = _mm256_blendv_epi8(y, _mm256_sub_epi32(zero, y), top);
+    y = _mm256_blendv_epi8(y,
+      _mm256_sub_epi32(_mm256_add_epi32(max_y, max_y), y), bottom);
+    __m256i dy = _mm256_blendv_epi8(dy0, _mm256_sub_epi32(zero, dy0),
+      _mm256_or_si256(top, bottom));
+
+    // near lanes are moved by fixed_sweep_ball() instead
+    _mm256_storeu_si256((__m256i*)(b->x + i), _mm256_blendv_epi8(x, x0, near));
+    _mm256_storeu_si256((__m256i*)(b->y + i), _mm256_blendv_epi8(y, y0, near));
+    _mm256_storeu_si256((__m256i*)(b->dy + i),
+      _mm256_blendv_epi8(dy, dy0, near));
+
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(
+      near, _mm256_or_si256(_mm256_cmpgt_epi32(zero, x),
+      _mm256_cmpgt_epi32(x, _mm256_set1_epi32(FIXED_BATCH_GOAL_X))))));
+    for (int k = 0; mask; k++, mask >>= 1) {
+      if (mask & 1) {
+        b->goal_lanes[b->goal_count++] = i + k;
+      }
+    }
+  }
+  return i;
+}
+
+#endif
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a fixed point batch of matches, each reset for a
+    new game.
+    Parameters:
+      int matches: number of concurrent matches, rounded up to a multiple
+      of FIXED_BATCH_LANE_PAD
+      double time_step: simulated seconds per tick, rounded to a fixed
+      tick, at most FIXED_MAX_TIME_STEP
+      BatchKernel kernel: vector kernel to use, BATCH_KERNEL_AUTO picks the
+      widest one supported by the CPU
+      Uint64 seed: seed of the batch's random number generator
+    Returns: FixedBatch* pointer to new batch, or NULL on allocation
+    failure
+    ---------------------------------------------------------------------- */
+FixedBatch* fixed_batch_create(int matches, double time_step,
+  BatchKernel kernel, Uint64 seed) {
+  FixedBatch* batch = calloc(1, sizeof(FixedBatch));
+  if (batch == NULL) {
+    return NULL;
+  }
+  batch->lanes = (matches + FIXED_BATCH_LANE_PAD - 1) /
+    FIXED_BATCH_LANE_PAD * FIXED_BATCH_LANE_PAD;
+  batch->time_step = fixed_from_double(time_step);
+  batch->kernel = select_kernel(kernel);
+  rng_seed(&batch->rng, seed);
+
+  size_t size = batch->lanes * sizeof(Sint32);
+  Sint32** lane_arrays[] = {
+    &batch->x, &batch->y, &batch->dx, &batch->dy, &batch->speed,
+    &batch->fudge, &batch->player_y, &batch->player_dy, &batch->robot_y,
+    &batch->robot_dy, &batch->player_target_y, &batch->robot_target_y,
+    &batch->near
+  };
+  int** int_arrays[] = {
+    &batch->player_score, &batch->robot_score,
+    &batch->hit_lanes, &batch->goal_lanes
+  };
+  bool ok = true;
+  for (size_t i = 0; i < SDL_arraysize(lane_arrays); i++) {
+    *lane_arrays[i] = SDL_SIMDAlloc(size);
+    ok = ok && *lane_arrays[i] != NULL;
+  }
+  for (size_t i = 0; i < SDL_arraysize(int_arrays); i++) {
+    *int_arrays[i] = SDL_SIMDAlloc(batch->lanes * sizeof(int));
+    ok = ok && *int_arrays[i] != NULL;
+  }
+  if (!ok) {
+    SDL_LogError(LOGCAT, "Failed to allocate batch of %d matches", matches);
+    fixed_batch_destroy(batch);
+    return NULL;
+  }
+
+  for (int lane = 0; lane < batch->lanes; lane++) {
+    fixed_batch_reset_lane(batch, lane);
+  }
+  return batch;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch created by fixed_batch_create()
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_destroy(FixedBatch* batch) {
+  if (batch == NULL) {
+    return;
+  }
+  SDL_SIMDFree(batch->x);
+  SDL_SIMDFree(batch->y);
+  SDL_SIMDFree(batch->dx);
+  SDL_SIMDFree(batch->dy);
+  SDL_SIMDFree(batch->speed);
+  SDL_SIMDFree(batch->fudge);
+  SDL_SIMDFree(batch->player_y);
+  SDL_SIMDFree(batch->player_dy);
+  SDL_SIMDFree(batch->robot_y);
+  SDL_SIMDFree(batch->robot_dy);
+  SDL_SIMDFree(batch->player_target_y);
+  SDL_SIMDFree(batch->robot_target_y);
+  SDL_SIMDFree(batch->near);
+  SDL_SIMDFree(batch->player_score);
+  SDL_SIMDFree(batch->robot_score);
+  SDL_SIMDFree(batch->hit_lanes);
+  SDL_SIMDFree(batch->goal_lanes);
+  free(batch);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Reset a single lane of a fixed point batch to the start
+    of a new game, mirroring reset_match()
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+      int lane: lane index
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_reset_lane(FixedBatch* batch, int lane) {
+  Ball ball = {0};
+  FixedBall fixed;
+  reset_ball(&ball, ROBOT, &batch->rng);
+  ball.speed = BALL_MIN_SPEED;
+  fixed_load_ball(&fixed, &ball);
+  scatter_fixed_ball(batch, lane, &fixed);
+
+  batch->player_y[lane] = FIXED_INT(PADDLE_Y);
+  batch->player_dy[lane] = 0;
+  batch->robot_y[lane] = FIXED_INT(PADDLE_Y);
+  batch->robot_dy[lane] = 0;
+  batch->player_score[lane] = 0;
+  batch->robot_score[lane] = 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Advance every match in a fixed point batch by one tick,
+    as batch_step() does, with 32 bit integer kernels
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_step(FixedBatch* batch) {
+  FixedBall ball;
+  FixedPaddle player;
+  FixedPaddle robot;
+  int done = 0;
+
+  batch->hit_count = 0;
+#ifdef BATCH_X86_KERNELS
+  if (batch->kernel == BATCH_KERNEL_AVX2) {
+    done = ai_collide_fixed_avx2(batch);
+  } else if (batch->kernel == BATCH_KERNEL_SSE2) {
+    done = ai_collide_fixed_sse2(batch);
+  }
+#endif
+  ai_collide_fixed_scalar(batch, done);
+
+  batch->goal_count = 0;
+  done = 0;
+#ifdef BATCH_X86_KERNELS
+  if (batch->kernel == BATCH_KERNEL_AVX2) {
+    done = move_fixed_avx2(batch);
+  } else if (batch->kernel == BATCH_KERNEL_SSE2) {
+    done = move_fixed_sse2(batch);
+  }
+#endif
+  move_fixed_scalar(batch, done);
+
+  for (int i = 0; i < batch->hit_count; i++) {
+    int lane = batch->hit_lanes[i];
+    gather_fixed_lane(batch, lane, &ball, &player, &robot);
+    fixed_sweep_ball(&ball, &player, &robot, &batch->rng, NULL);
+    scatter_fixed_ball(batch, lane, &ball);
+    if (ball.x < 0 || ball.x > FIXED_BATCH_GOAL_X) {
+      batch->goal_lanes[batch->goal_count++] = lane;
+    }
+  }
+
+  for (int i = 0; i < batch->goal_count; i++) {
+    int lane = batch->goal_lanes[i];
+    Player scorer = batch->x[lane] < 0 ? PLAYER : ROBOT;
+    int score = scorer == PLAYER ?
+      ++batch->player_score[lane] : ++batch->robot_score[lane];
+
+    if (score >= MAX_SCORE) {
+      batch->matches++;
+      if (scorer == PLAYER) {
+        batch->player_wins++;
+      } else {
+        batch->robot_wins++;
+      }
+      fixed_batch_reset_lane(batch, lane);
+      continue;
+    }
+
+    // serve with the scalar reset_ball(), whose values are exact in
+    // fixed point
+    Ball serve = {0};
+    gather_fixed_lane(batch, lane, &ball, &player, &robot);
+    fixed_store_ball(&serve, &ball);
+    reset_ball(&serve, scorer, &batch->rng);
+    FixedPaddle* server = scorer == PLAYER ? &player : &robot;
+    serve.y = fixed_to_double(server->y) + PADDLE_H / 2;
+    fixed_load_ball(&ball, &serve);
+    scatter_fixed_ball(batch, lane, &ball);
+  }
+
+  batch->ticks++;
+}
+
+// FNV-1a step over the lanes of one array
+static void hash_lanes(Uint64* hash, const void* data, size_t size) {
+  const Uint8* bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    *hash = (*hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: FNV-1a hash of the lanes and random generator of a fixed
+    point batch, to compare runs across kernels and machines
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: 64 bit hash
+    ---------------------------------------------------------------------- */
+Uint64 fixed_batch_hash(FixedBatch* batch) {
+  Uint64 hash = 0xCBF29CE484222325ull;
+  size_t size = batch->lanes * sizeof(Sint32);
+  Sint32* arrays[] = {
+    batch->x, batch->y, batch->dx, batch->dy, batch->speed, batch->fudge,
+    batch->player_y, batch->robot_y, batch->player_target_y,
+    batch->robot_target_y
+  };
+  for (size_t i = 0; i < SDL_arraysize(arrays); i++) {
+    hash_lanes(&hash, arrays[i], size);
+  }
+  hash_lanes(&hash, batch->player_score, batch->lanes * sizeof(int));
+  hash_lanes(&hash, batch->robot_score, batch->lanes * sizeof(int));
+  hash_lanes(&hash, &batch->rng, sizeof(batch->rng));
+  return hash;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: run_batch() with a fixed point batch; also logs the hash
+    of the final state, which is the same for every kernel
+    Parameters:
+      int lanes: number of concurrent matches
+      int matches: number of matches to finish
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use
+      Uint64 seed: seed of the batch's random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_fixed_batch(int lanes, int matches, double time_step,
+  BatchKernel kernel, Uint64 seed) {
+  FixedBatch* batch = fixed_batch_create(lanes, time_step, kernel, seed);
+  if (batch == NULL) {
+    return;
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  while (batch->matches < (Uint64)matches &&
+    batch->ticks < HEADLESS_MAX_TICKS) {
+    fixed_batch_step(batch);
+  }
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+  if (elapsed <= 0) {
+    elapsed = 1e-9;
+  }
+
+  double ball_ticks = (double)batch->ticks * batch->lanes;
+  SDL_LogInfo(LOGCAT,
+    "Batch (%s, fixed point): %d lanes, %llu matches (player %llu, "
+    "robot %llu), %llu ticks in %.3f s",
+    batch_kernel_name(batch->kernel), batch->lanes,
+    (unsigned long long)batch->matches,
+    (unsigned long long)batch->player_wins,
+    (unsigned long long)batch->robot_wins,
+    (unsigned long long)batch->ticks, elapsed);
+  SDL_LogInfo(LOGCAT, "Batch: %.0f ball-ticks/sec, %.1f matches/sec",
+    ball_ticks / elapsed, batch->matches / elapsed);
+  SDL_LogInfo(LOGCAT, "Batch: state hash %016llx",
+    (unsigned long long)fixed_batch_hash(batch));
+
+  fixed_batch_destroy(batch);
+}
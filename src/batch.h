@@ -0,0 +1,261 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "pong.h"
+#include "fixed.h"
+
+// lanes are padded to a multiple of the widest vector (4 doubles for AVX2)
+#define BATCH_LANE_PAD 4
+// and in fixed point to 8 int32s for AVX2
+#define FIXED_BATCH_LANE_PAD 8
+
+typedef enum {
+  BATCH_KERNEL_AUTO,
+  BATCH_KERNEL_SCALAR,
+  BATCH_KERNEL_SSE2,
+  BATCH_KERNEL_AVX2
+} BatchKernel;
+
+/*
+  Structure-of-arrays state for many concurrent AI vs AI matches. Each lane
+  is one match; every array holds one value per lane so the per-tick
+  kernels can load, compute and store whole vectors of matches at once.
+  Ball and paddle sizes, paddle x positions and paddle speed are the same
+  for every match and are taken from the constants in pong.h.
+*/
+typedef struct Batch Batch;
+struct Batch {
+  int lanes;
+  double time_step;
+  BatchKernel kernel;
+  Rng rng;
+
+  // ball
+  double* x;
+  double* y;
+  double* dx;
+  double* dy;
+  double* speed;
+  double* fudge;
+
+  // paddles
+  double* player_y;
+  double* player_dy;
+  double* robot_y;
+  double* robot_dy;
+  // where the ball will cross each paddle face, see predict_ball()
+  double* player_target_y;
+  double* robot_target_y;
+
+  // 1 in lanes where the ball may reach a paddle this tick, else 0
+  double* near;
+
+  // scores
+  int* player_score;
+  int* robot_score;
+
+  // lanes needing scalar follow-up this tick (paddle sweeps, goals)
+  int* hit_lanes;
+  int hit_count;
+  int* goal_lanes;
+  int goal_count;
+
+  Uint64 ticks;
+  Uint64 matches;
+  Uint64 player_wins;
+  Uint64 robot_wins;
+};
+
+/*
+  The batch in 16.16 fixed point, see fixed.h. Positions are Fixed and
+  everything else whole numbers, all 32 bits wide, so a vector holds twice
+  as many lanes as in Batch: 4 per SSE2 and 8 per AVX2 register. Integer
+  kernels give the same result bit for bit whichever is used, on any
+  machine. Lanes near a paddle are swept with fixed_sweep_ball().
+*/
+typedef struct FixedBatch FixedBatch;
+struct FixedBatch {
+  int lanes;
+  Fixed time_step;
+  BatchKernel kernel;
+  Rng rng;
+
+  // ball
+  Fixed* x;
+  Fixed* y;
+  Sint32* dx;
+  Sint32* dy;
+  Sint32* speed;
+  Sint32* fudge;
+
+  // paddles
+  Fixed* player_y;
+  Sint32* player_dy;
+  Fixed* robot_y;
+  Sint32* robot_dy;
+  Fixed* player_target_y;
+  Fixed* robot_target_y;
+
+  // 1 in lanes where the ball may reach a paddle this tick, else 0
+  Sint32* near;
+
+  // scores
+  int* player_score;
+  int* robot_score;
+
+  int* hit_lanes;
+  int hit_count;
+  int* goal_lanes;
+  int goal_count;
+
+  Uint64 ticks;
+  Uint64 matches;
+  Uint64 player_wins;
+  Uint64 robot_wins;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a batch of matches, each reset for a new game.
+    Parameters:
+      int matches: number of concurrent matches, rounded up to a multiple
+      of BATCH_LANE_PAD
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use, BATCH_KERNEL_AUTO picks the
+      widest one supported by the CPU
+      Uint64 seed: seed of the batch's random number generator
+    Returns: Batch* pointer to new batch, or NULL on allocation failure
+    ---------------------------------------------------------------------- */
+Batch* batch_create(int matches, double time_step, BatchKernel kernel,
+  Uint64 seed);
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch created by batch_create()
+    Parameters:
+      Batch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_destroy(Batch* batch);
+
+/*  ----------------------------------------------------------------------
+    Description: Reset a single lane to the start of a new game, mirroring
+    reset_match()
+    Parameters:
+      Batch* batch: pointer to the batch
+      int lane: lane index
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_reset_lane(Batch* batch, int lane);
+
+/*  ----------------------------------------------------------------------
+    Description: Advance every match in the batch by one tick, following
+    the same sequence as step_match(): update_player() for both paddles,
+    move_paddle(), the ball's movement and scoring. The AI, paddle
+    movement and ball movement with wall bounces run as vector kernels;
+    lanes where the ball may reach a paddle this tick and goals, which are
+    rare per tick, are resolved per lane with the scalar sweep_ball() and
+    reset_ball() from pong.c.
+    Parameters:
+      Batch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void batch_step(Batch* batch);
+
+/*  ----------------------------------------------------------------------
+    Description: Get the display name of a batch kernel
+    Parameters:
+      BatchKernel kernel: kernel id
+    Returns: kernel name
+    ---------------------------------------------------------------------- */
+const char* batch_kernel_name(BatchKernel kernel);
+
+/*  ----------------------------------------------------------------------
+    Description: Look up a batch kernel by its display name
+    Parameters:
+      const char* name: "auto", "scalar", "sse2" or "avx2"
+      BatchKernel* kernel: set to the matching kernel id
+    Returns: true if the name is known, otherwise false
+    ---------------------------------------------------------------------- */
+bool batch_kernel_from_name(const char* name, BatchKernel* kernel);
+
+/*  ----------------------------------------------------------------------
+    Description: Run concurrent matches in a batch until the given number
+    of matches has finished, then log ball-ticks/sec and matches/sec.
+    Parameters:
+      int lanes: number of concurrent matches
+      int matches: number of matches to finish
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use
+      Uint64 seed: seed of the batch's random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_batch(int lanes, int matches, double time_step, BatchKernel kernel,
+  Uint64 seed);
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a fixed point batch of matches, each reset for a
+    new game.
+    Parameters:
+      int matches: number of concurrent matches, rounded up to a multiple
+      of FIXED_BATCH_LANE_PAD
+      double time_step: simulated seconds per tick, rounded to a fixed
+      tick, at most FIXED_MAX_TIME_STEP
+      BatchKernel kernel: vector kernel to use, BATCH_KERNEL_AUTO picks the
+      widest one supported by the CPU
+      Uint64 seed: seed of the batch's random number generator
+    Returns: FixedBatch* pointer to new batch, or NULL on allocation
+    failure
+    ---------------------------------------------------------------------- */
+FixedBatch* fixed_batch_create(int matches, double time_step,
+  BatchKernel kernel, Uint64 seed);
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch created by fixed_batch_create()
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_destroy(FixedBatch* batch);
+
+/*  ----------------------------------------------------------------------
+    Description: Reset a single lane of a fixed point batch to the start
+    of a new game, mirroring reset_match()
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+      int lane: lane index
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_reset_lane(FixedBatch* batch, int lane);
+
+/*  ----------------------------------------------------------------------
+    Description: Advance every match in a fixed point batch by one tick,
+    as batch_step() does, with 32 bit integer kernels
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_batch_step(FixedBatch* batch);
+
+/*  ----------------------------------------------------------------------
+    Description: FNV-1a hash of the lanes and random generator of a fixed
+    point batch, to compare runs across kernels and machines
+    Parameters:
+      FixedBatch* batch: pointer to the batch
+    Returns: 64 bit hash
+    ---------------------------------------------------------------------- */
+Uint64 fixed_batch_hash(FixedBatch* batch);
+
+/*  ----------------------------------------------------------------------
+    Description: run_batch() with a fixed point batch; also logs the hash
+    of the final state, which is the same for every kernel
+    Parameters:
+      int lanes: number of concurrent matches
+      int matches: number of matches to finish
+      double time_step: simulated seconds per tick
+      BatchKernel kernel: vector kernel to use
+      Uint64 seed: seed of the batch's random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_fixed_batch(int lanes, int matches, double time_step,
+  BatchKernel kernel, Uint64 seed);
+
+#endif
@@ -0,0 +1,313 @@
+// Pipelined frame capture to a Y4M video stream and PNG files
+#include "capture.h"
+#include <SDL_image.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+/*  ----------------------------------------------------------------------
+    Convert an ARGB8888 frame to 4:2:0 planes with full range BT.601
+    coefficients in 8 bit fixed point. Each chroma sample averages a 2x2
+    block of pixels, repeating the last row and column for odd sizes.
+    ---------------------------------------------------------------------- */
+static void convert_yuv420(const Uint8* pixels, int w, int h, Uint8* yuv) {
+  int cw = (w + 1) / 2;
+  int ch = (h + 1) / 2;
+  Uint8* y_plane = yuv;
+  Uint8* u_plane = yuv + w * h;
+  Uint8* v_plane = u_plane + cw * ch;
+
+  for (int y = 0; y < h; y++) {
+    const Uint32* row = (const Uint32*)(pixels + y * w * 4);
+    for (int x = 0; x < w; x++) {
+      Uint32 p = row[x];
+      int r = (p >> 16) & 0xFF;
+      int g = (p >> 8) & 0xFF;
+      int b = p & 0xFF;
+      y_plane[y * w + x] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+    }
+  }
+
+  for (int cy = 0; cy < ch; cy++) {
+    const Uint32* row0 = (const Uint32*)(pixels + 2 * cy * w * 4);
+    const Uint32* row1 = 2 * cy + 1 < h ?
+      (const Uint32*)(pixels + (2 * cy + 1) * w * 4) : row0;
+    for (int cx = 0; cx < cw; cx++) {
+      int x0 = 2 * cx;
+      int x1 = x0 + 1 < w ? x0 + 1 : x0;
+      Uint32 block[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+      // sums of four pixels, so the coefficients are shifted by 10
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      for (int i = 0; i < 4; i++) {
+        r += (block[i] >> 16) & 0xFF;
+        g += (block[i] >> 8) & 0xFF;
+        b += block[i] & 0xFF;
+      }
+      int u = (-43 * r - 85 * g + 128 * b + (128 << 10) + 512) >> 10;
+      int v = (128 * r - 107 * g - 21 * b + (128 << 10) + 512) >> 10;
+      u_plane[cy * cw + cx] = u > 255 ? 255 : u;
+      v_plane[cy * cw + cx] = v > 255 ? 255 : v;
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Write one queued frame to the video stream and/or its PNG file
+    ---------------------------------------------------------------------- */
+static void encode_frame(Capture* capture, CaptureFrame* frame) {
+  if (frame->video && !capture->video_failed) {
+    int cw = (capture->w + 1) / 2;
+    int ch = (capture->h + 1) / 2;
+    size_t size = (size_t)capture->w * capture->h + 2 * (size_t)cw * ch;
+    convert_yuv420(frame->pixels, capture->w, capture->h, capture->yuv);
+    fputs("FRAME\n", capture->video);
+    if (fwrite(capture->yuv, 1, size, capture->video) != size) {
+      SDL_LogError(LOGCAT, "Failed to write video frame, video stopped");
+      capture->video_failed = true;
+    }
+  }
+
+  if (frame->path[0] != '\0') {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(frame->pixels,
+      capture->w, capture->h, 32, capture->w * 4, CAPTURE_FORMAT);
+    if (surface == NULL || IMG_SavePNG(surface, frame->path) < 0) {
+      SDL_LogError(LOGCAT, "Failed to save '%s': %s",
+        frame->path, IMG_GetError());
+    } else {
+      capture->pngs++;
+    }
+    SDL_FreeSurface(surface);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Worker thread: encode queued frames in order and return their buffers
+    until told to quit and the queue is empty
+    ---------------------------------------------------------------------- */
+static int capture_worker(void* data) {
+  Capture* capture = data;
+  SDL_LockMutex(capture->lock);
+  for (;;) {
+    while (capture->queue_count == 0 && !capture->quit) {
+      SDL_CondWait(capture->cond, capture->lock);
+    }
+    if (capture->queue_count == 0) {
+      break;
+    }
+    int index = capture->queue[capture->queue_head];
+    SDL_UnlockMutex(capture->lock);
+
+    encode_frame(capture, &capture->frames[index]);
+
+    SDL_LockMutex(capture->lock);
+    capture->queue_head = (capture->queue_head + 1) % CAPTURE_BUFFERS;
+    capture->queue_count--;
+    capture->free[capture->free_count++] = index;
+    SDL_CondBroadcast(capture->cond);
+  }
+  SDL_UnlockMutex(capture->lock);
+  return 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Start capturing the frames of a renderer
+    Parameters:
+      SDL_Renderer* renderer: renderer whose output is captured
+      const char* video: Y4M file or named pipe to stream every frame to,
+      or NULL
+      const char* stills: prefix of PNG files to save every frame to, as
+      PREFIX_000001.png, or NULL
+      int fps: frame rate written to the Y4M header
+      bool offline: wait for a free buffer instead of dropping frames
+    Returns: Capture* pointer to the capture, or NULL on failure
+    ---------------------------------------------------------------------- */
+Capture* capture_open(SDL_Renderer* renderer, const char* video,
+  const char* stills, int fps, bool offline) {
+  int w = 0;
+  int h = 0;
+  if (renderer == NULL || SDL_GetRendererOutputSize(renderer, &w, &h) < 0 ||
+    w <= 0 || h <= 0) {
+    SDL_LogError(LOGCAT, "Nothing to capture: %s", SDL_GetError());
+    return NULL;
+  }
+
+  Capture* capture = calloc(1, sizeof(Capture));
+  if (capture == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate the frame capture");
+    return NULL;
+  }
+  capture->w = w;
+  capture->h = h;
+  capture->fps = fps > 0 ? fps : 60;
+  capture->offline = offline;
+  capture->stills = stills;
+
+  bool ok = true;
+  for (int i = 0; i < CAPTURE_BUFFERS; i++) {
+    capture->frames[i].pixels = malloc((size_t)w * h * 4);
+    ok = ok && capture->frames[i].pixels != NULL;
+    capture->free[capture->free_count++] = i;
+  }
+  size_t chroma = (size_t)((w + 1) / 2) * ((h + 1) / 2);
+  capture->yuv = malloc((size_t)w * h + 2 * chroma);
+  capture->lock = SDL_CreateMutex();
+  capture->cond = SDL_CreateCond();
+  ok = ok && capture->yuv != NULL && capture->lock != NULL &&
+    capture->cond != NULL;
+
+  if (ok && video != NULL) {
+    capture->video = fopen(video, "wb");
+    if (capture->video == NULL) {
+      SDL_LogError(LOGCAT, "Failed to open video '%s'", video);
+      ok = false;
+    } else {
+      fprintf(capture->video,
+        "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+        w, h, capture->fps);
+    }
+  }
+
+  if (ok) {
+    capture->thread = SDL_CreateThread(capture_worker, "capture", capture);
+    if (capture->thread == NULL) {
+      SDL_LogError(LOGCAT, "Failed to start the capture worker: %s",
+        SDL_GetError());
+      ok = false;
+    }
+  }
+
+  if (!ok) {
+    capture_close(capture);
+    return NULL;
+  }
+  return capture;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Save the next captured frame as a PNG screenshot named
+    after the current time
+    Parameters:
+      Capture* capture: pointer to the capture
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_screenshot(Capture* capture) {
+  if (capture != NULL) {
+    capture->screenshot = true;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Read the frame just rendered back and queue it for the
+    worker. Call after drawing and before SDL_RenderPresent(). Does
+    nothing if the frame isn't wanted for video, stills or a screenshot.
+    Parameters:
+      Capture* capture: pointer to the capture, NULL is ignored
+      SDL_Renderer* renderer: renderer the frame was drawn with
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_frame(Capture* capture, SDL_Renderer* renderer) {
+  if (capture == NULL || (capture->video == NULL &&
+    capture->stills == NULL && !capture->screenshot)) {
+    return;
+  }
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  SDL_LockMutex(capture->lock);
+  while (capture->free_count == 0 && capture->offline) {
+    SDL_CondWait(capture->cond, capture->lock);
+  }
+  int index = capture->free_count > 0 ?
+    capture->free[--capture->free_count] : -1;
+  SDL_UnlockMutex(capture->lock);
+  if (index < 0) {
+    // the worker is behind; a pending screenshot takes the next frame
+    capture->dropped++;
+    return;
+  }
+
+  CaptureFrame* frame = &capture->frames[index];
+  bool read = SDL_RenderReadPixels(renderer, NULL, CAPTURE_FORMAT,
+    frame->pixels, capture->w * 4) == 0;
+  if (read) {
+    capture->frame_number++;
+    frame->video = capture->video != NULL;
+    frame->path[0] = '\0';
+    if (capture->screenshot) {
+      char stamp[32];
+      time_t now = time(NULL);
+      strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+      snprintf(frame->path, sizeof(frame->path), "screenshot-%s-%d.png",
+        stamp, capture->frame_number);
+      SDL_LogInfo(LOGCAT, "Screenshot: %s", frame->path);
+      capture->screenshot = false;
+    } else if (capture->stills != NULL) {
+      snprintf(frame->path, sizeof(frame->path), "%s_%06d.png",
+        capture->stills, capture->frame_number);
+    }
+  } else {
+    SDL_LogWarn(LOGCAT, "Failed to read the frame back: %s", SDL_GetError());
+  }
+
+  SDL_LockMutex(capture->lock);
+  if (read) {
+    int tail = (capture->queue_head + capture->queue_count) % CAPTURE_BUFFERS;
+    capture->queue[tail] = index;
+    capture->queue_count++;
+  } else {
+    capture->free[capture->free_count++] = index;
+  }
+  SDL_CondBroadcast(capture->cond);
+  SDL_UnlockMutex(capture->lock);
+
+  histogram_record(&capture->cost, (SDL_GetPerformanceCounter() - start) *
+    1000000 / SDL_GetPerformanceFrequency());
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Finish encoding the queued frames, stop the worker, log
+    the frame count, drops and main thread cost, and free the capture
+    Parameters:
+      Capture* capture: pointer to the capture, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_close(Capture* capture) {
+  if (capture == NULL) {
+    return;
+  }
+  if (capture->thread != NULL) {
+    SDL_LockMutex(capture->lock);
+    capture->quit = true;
+    SDL_CondBroadcast(capture->cond);
+    SDL_UnlockMutex(capture->lock);
+    SDL_WaitThread(capture->thread, NULL);
+  }
+
+  if (capture->cost.count > 0) {
+    SDL_LogInfo(LOGCAT,
+      "Capture: %d frames, %llu dropped, %llu PNGs, main thread "
+      "p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+      capture->frame_number, (unsigned long long)capture->dropped,
+      (unsigned long long)capture->pngs,
+      histogram_percentile(&capture->cost, 50) / 1000.0,
+      histogram_percentile(&capture->cost, 99) / 1000.0,
+      capture->cost.max / 1000.0);
+  }
+  if (capture->pngs > 0) {
+    IMG_Quit();
+  }
+
+  if (capture->video != NULL) {
+    fclose(capture->video);
+  }
+  for (int i = 0; i < CAPTURE_BUFFERS; i++) {
+    free(capture->frames[i].pixels);
+  }
+  free(capture->yuv);
+  SDL_DestroyCond(capture->cond);
+  SDL_DestroyMutex(capture->lock);
+  free(capture);
+}
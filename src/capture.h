@@ -0,0 +1,116 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "histogram.h"
+
+// frame buffers read back and waiting for or being encoded
+#define CAPTURE_BUFFERS 4
+// pixel format frames are read back in, the native format of most renderers
+#define CAPTURE_FORMAT SDL_PIXELFORMAT_ARGB8888
+#define CAPTURE_PATH_SIZE 256
+
+/*
+  A frame read back from the renderer, with what to encode it as
+*/
+typedef struct CaptureFrame CaptureFrame;
+struct CaptureFrame {
+  Uint8* pixels;
+  bool video;
+  // PNG file to save the frame to, empty if none
+  char path[CAPTURE_PATH_SIZE];
+};
+
+/*
+  Pipelined frame capture. The main thread reads each frame back with
+  SDL_RenderReadPixels() into one of CAPTURE_BUFFERS reusable buffers and
+  queues it; a worker thread converts and writes the queued frames in
+  order, to an uncompressed Y4M video stream (4:2:0, full range BT.601),
+  and/or to PNG files with IMG_SavePNG(), then returns the buffers. So the
+  main thread only pays for the read back. When all buffers are waiting,
+  a realtime capture drops the frame rather than wait, and an offline
+  capture (e.g. headless) waits for the worker.
+  The free buffers are a stack and the queued buffers a FIFO of indexes
+  into frames, guarded by lock; cond is signalled whenever either
+  changes.
+*/
+typedef struct Capture Capture;
+struct Capture {
+  int w;
+  int h;
+  int fps;
+  bool offline;
+  FILE* video;
+  // set by the worker if writing the video failed
+  bool video_failed;
+  // prefix of PNG files for every frame, NULL if none
+  const char* stills;
+  // the next frame is saved as a PNG screenshot
+  bool screenshot;
+  int frame_number;
+  Uint64 dropped;
+  Uint64 pngs;
+  // main thread microseconds spent per captured frame
+  Histogram cost;
+
+  SDL_Thread* thread;
+  SDL_mutex* lock;
+  SDL_cond* cond;
+  bool quit;
+  CaptureFrame frames[CAPTURE_BUFFERS];
+  int free[CAPTURE_BUFFERS];
+  int free_count;
+  int queue[CAPTURE_BUFFERS];
+  int queue_head;
+  int queue_count;
+  // worker's 4:2:0 planes of one video frame
+  Uint8* yuv;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Start capturing the frames of a renderer
+    Parameters:
+      SDL_Renderer* renderer: renderer whose output is captured
+      const char* video: Y4M file or named pipe to stream every frame to,
+      or NULL
+      const char* stills: prefix of PNG files to save every frame to, as
+      PREFIX_000001.png, or NULL
+      int fps: frame rate written to the Y4M header
+      bool offline: wait for a free buffer instead of dropping frames
+    Returns: Capture* pointer to the capture, or NULL on failure
+    ---------------------------------------------------------------------- */
+Capture* capture_open(SDL_Renderer* renderer, const char* video,
+  const char* stills, int fps, bool offline);
+
+/*  ----------------------------------------------------------------------
+    Description: Save the next captured frame as a PNG screenshot named
+    after the current time
+    Parameters:
+      Capture* capture: pointer to the capture
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_screenshot(Capture* capture);
+
+/*  ----------------------------------------------------------------------
+    Description: Read the frame just rendered back and queue it for the
+    worker. Call after drawing and before SDL_RenderPresent(). Does
+    nothing if the frame isn't wanted for video, stills or a screenshot.
+    Parameters:
+      Capture* capture: pointer to the capture, NULL is ignored
+      SDL_Renderer* renderer: renderer the frame was drawn with
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_frame(Capture* capture, SDL_Renderer* renderer);
+
+/*  ----------------------------------------------------------------------
+    Description: Finish encoding the queued frames, stop the worker, log
+    the frame count, drops and main thread cost, and free the capture
+    Parameters:
+      Capture* capture: pointer to the capture, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void capture_close(Capture* capture);
+
+#endif
@@ -0,0 +1,772 @@
+// SDL-free game simulation: the pong_core library
+#include "core.h"
+#include "fixed.h"
+
+/*  ---------------------------------------------------------------------- 
+    Description: Seed a random number generator. Each Match (and each 
+    simulation worker thread) owns its own generator, so concurrent games
+    never share or lock random state.
+    The four xoshiro256** state words are filled from the seed with
+    splitmix64, so that nearby seeds give unrelated sequences and the
+    state is never all zero.
+    Parameters: 
+      Rng* rng: pointer to the generator
+      uint64_t seed: seed value, any value including 0 is valid
+    Returns: none
+    ---------------------------------------------------------------------- */
+void rng_seed(Rng* rng, uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    seed += 0x9E3779B97F4A7C15ull;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    rng->state[i] = z ^ (z >> 31);
+  }
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Draw 64 random bits (xoshiro256**)
+    Parameters: 
+      Rng* rng: pointer to the generator
+    Returns: random uint64_t
+    ---------------------------------------------------------------------- */
+uint64_t rng_next(Rng* rng) {
+  uint64_t* s = rng->state;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Advance a generator by 2^128 draws. Generators seeded
+    once and then jumped 0, 1, 2... times give non-overlapping streams for
+    parallel workers.
+    Parameters: 
+      Rng* rng: pointer to the generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void rng_jump(Rng* rng) {
+  static const uint64_t jump[4] = {
+    0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+    0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+  };
+  uint64_t s[4] = {0};
+  for (int i = 0; i < 4; i++) {
+    for (int b = 0; b < 64; b++) {
+      if (jump[i] & ((uint64_t)1 << b)) {
+        s[0] ^= rng->state[0];
+        s[1] ^= rng->state[1];
+        s[2] ^= rng->state[2];
+        s[3] ^= rng->state[3];
+      }
+      rng_next(rng);
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    rng->state[i] = s[i];
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Draw a random integer from 0 to n-1, the range of the 
+    rand() % n expressions it replaces. Every value is equally likely:
+    32 random bits are scaled by n (Lemire's multiply-shift) and the few
+    draws that would favour low values are rejected.
+    Parameters: 
+      Rng* rng: pointer to the generator
+      int n: number of possible values, greater than 0
+    Returns: random int in [0, n)
+    ---------------------------------------------------------------------- */
+int rng_int(Rng* rng, int n) {
+  uint32_t range = (uint32_t)n;
+  uint64_t m = (rng_next(rng) >> 32) * range;
+  uint32_t low = (uint32_t)m;
+  if (low < range) {
+    // 2^32 mod range, the number of biased low products
+    uint32_t threshold = (0u - range) % range;
+    while (low < threshold) {
+      m = (rng_next(rng) >> 32) * range;
+      low = (uint32_t)m;
+    }
+  }
+  return (int)(m >> 32);
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset Match object to defaults for new game
+    Parameters: Match* match - match object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_match(Match* match) {
+  match->score_board.player = 0;
+  match->score_board.robot = 0;
+  match->winner = match->over ? match->winner : NOBODY;
+  reset_paddle(&match->player, PLAYER);
+  reset_paddle(&match->robot, ROBOT);
+  reset_ball(&match->ball, ROBOT, &match->rng);
+  match->ball.speed = BALL_MIN_SPEED;
+  match->rally = 0;
+  match->last_rally = 0;
+  match->idle = true;
+  match->over = false;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Seed the match and serve the first ball, leaving the
+    scores as they are. A recorded game and its replay start from this
+    same state.
+    Parameters:
+      Match* match: pointer to the Match object
+      uint64_t seed: random seed
+    Returns: none
+    ---------------------------------------------------------------------- */
+void seed_match(Match* match, uint64_t seed) {
+  rng_seed(&match->rng, seed);
+  reset_paddle(&match->player, PLAYER);
+  reset_paddle(&match->robot, ROBOT);
+  reset_ball(&match->ball, ROBOT, &match->rng);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Apply one player command to the match: move the player
+    paddle, or start or reset the match
+    Parameters:
+      Match* match: pointer to the Match object
+      Command command: command to apply
+    Returns: none
+    ---------------------------------------------------------------------- */
+void apply_match_command(Match* match, Command command) {
+  Paddle* paddle = &match->player;
+  switch (command) {
+  case COMMAND_UP_PRESS:
+    paddle->dy -= paddle->speed;
+    break;
+  case COMMAND_UP_RELEASE:
+    paddle->dy += paddle->speed;
+    break;
+  case COMMAND_DOWN_PRESS:
+    paddle->dy += paddle->speed;
+    break;
+  case COMMAND_DOWN_RELEASE:
+    paddle->dy -= paddle->speed;
+    break;
+  case COMMAND_START:
+    reset_match(match);
+    match->idle = false;
+    break;
+  case COMMAND_RESET:
+    reset_match(match);
+    break;
+  default:
+    break;
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset specified Paddle object to defaults for given Player
+    Parameters: 
+      Paddle* paddle: pointer to player paddle
+      Player* owner: owner of paddle (either PLAYER or ROBOT), 
+      determines x position of paddle on court
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_paddle(Paddle* paddle, Player owner) {
+  paddle->owner = owner;
+  paddle->speed = PADDLE_SPEED;
+  paddle->time_step = 0;
+  paddle->dx = 0;
+  paddle->dy = 0;
+  paddle->fudge = 0;
+  paddle->h = PADDLE_H;
+  paddle->w = PADDLE_W;
+  paddle->x = paddle->owner == PLAYER ? PLAYER_X : ROBOT_X;
+  paddle->y = PADDLE_Y;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset Ball object to defaults. Sets the ball's initial
+    dx, dy and 'fudge' to random values within a specified range.
+    Parameters:   
+      Ball* ball: ball object
+      Player server: player serving ball, determines the position and direction
+      of the ball for service.
+      Rng* rng: random number generator of the game
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_ball(Ball* ball, Player server, Rng* rng) {
+  ball->service = server;
+  ball->speed = ball->speed < BALL_MIN_SPEED ? BALL_MIN_SPEED : ball->speed;
+  ball->x = 0;
+  ball->y = 0;
+
+  /*
+    Service angle adjustment
+    rng_int(rng, n)      ->  0 to n-1
+    rng_int(rng, 7)      ->  0 to 6
+    rng_int(rng, 7) - 3  -> -3 to 3
+    rng_int(rng, 9) - 4  -> -4 to 4
+  */
+
+  do {
+    ball->dy = rng_int(rng, 7) - 3;
+  } while (ball->dy == 0);
+
+  // rng_int(rng, 4):     0 to 3
+  // rng_int(rng, 4) + 2: 2 to 5
+  ball->dx = rng_int(rng, 4) + 2;
+  if (ball->service == PLAYER) {
+    ball->dx *= -1;
+  }
+
+  ball->fudge = get_fudge(rng);
+  ball->paddle_segment = 0;
+  // the server moves the ball before the next step, predict it then
+  ball->predicted = false;
+
+  ball->time_step = 0;
+  ball->x = ball->service == ROBOT ? ROBOT_SERVICE_X : PLAYER_SERVICE_X;
+  ball->y = SCREEN_MID_H - BALL_SIZE / 2;
+  ball->h = BALL_SIZE;
+  ball->w = BALL_SIZE;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Generate a random 'fudge' value between 0 and 14 
+    that affects a paddle's movement speed, either increasing or decreasing 
+    the paddle's y axis motion
+    Parameters: 
+      Rng* rng: random number generator of the game
+    Returns: int fudge value
+    ---------------------------------------------------------------------- */
+int get_fudge(Rng* rng) {
+  return rng_int(rng, 15);
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Updates the paddle oject's dy value to move the paddle 
+    toward where the ball will cross its face, as found by predict_ball().
+    The dy value is set to the paddle speed minus the 'fudge' factor, which
+    may speed up or slow down the paddle, so the AI can still miss.
+    Called by the Robot paddle when in play state. Called by both player and
+    robot paddles when game is in Idle state, to simulate a game.
+    Parameters: 
+      Ball* ball: the game ball
+      Paddle* paddle: the paddle object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void update_player(Ball* ball, Paddle* paddle) {
+  int paddle_top = paddle->y;
+  int paddle_bottom = paddle->y + paddle->h;
+
+  // a ball past a paddle face has left its predicted course: chase it
+  if (ball->x < ROBOT_X + PADDLE_W || ball->x > PLAYER_X - ball->w) {
+    ball->predicted = false;
+  }
+  if (!ball->predicted) {
+    predict_ball(ball);
+  }
+  double target_y = paddle->owner == PLAYER ?
+    ball->player_target_y : ball->robot_target_y;
+  int ball_top = target_y;
+  int ball_bottom = target_y + ball->h;
+  paddle->dy = 0;
+
+  // move paddle up
+  if (ball_top < paddle_top) {
+    paddle->dy -= paddle->speed - ball->fudge;
+  }
+
+  // move paddle down
+  if (ball_bottom > paddle_bottom) {
+    paddle->dy += paddle->speed - ball->fudge;
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Work out in closed form the y position at which the ball
+    will reach the player and the robot paddle faces, and cache them in the
+    ball until a paddle hit or serve changes its course. Wall rebounds are
+    accounted for by unfolding the court: the ball's y travels in a straight
+    line and is folded back into the court (y mod 2 * height, mirrored in
+    the upper half), so a wall hit doesn't change the prediction. For the
+    paddle the ball is moving away from, the ball is assumed to rebound from
+    the other paddle without any english. A ball with no course to a face,
+    e.g. one already past a paddle, is chased where it is: the targets are
+    its current y and the prediction is left stale, so the next step
+    predicts again.
+    Parameters: 
+      Ball* ball: the game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void predict_ball(Ball* ball) {
+  // ball x at which its leading edge touches the robot and player faces
+  double left = ROBOT_X + PADDLE_W;
+  double right = PLAYER_X - ball->w;
+  // ball y between the walls, and the period of its unfolded motion
+  double height = SCREEN_HEIGHT - ball->h;
+  double period = 2 * height;
+
+  if (ball->dx == 0 || ball->x < left || ball->x > right || height <= 0) {
+    // no course to predict, e.g. the ball is past a paddle: chase it
+    ball->player_target_y = ball->y;
+    ball->robot_target_y = ball->y;
+    ball->predicted = false;
+    return;
+  }
+  ball->predicted = true;
+
+  // x distance to each face, by way of the other face when moving away
+  double to_player = ball->dx > 0 ?
+    right - ball->x : (ball->x - left) + (right - left);
+  double to_robot = ball->dx < 0 ?
+    ball->x - left : (right - ball->x) + (right - left);
+
+  double slope = ball->dy / fabs(ball->dx);
+  double target[2] = {
+    ball->y + slope * to_player,
+    ball->y + slope * to_robot
+  };
+  for (int i = 0; i < 2; i++) {
+    double y = fmod(target[i], period);
+    if (y < 0) {
+      y += period;
+    }
+    target[i] = y > height ? period - y : y;
+  }
+  ball->player_target_y = target[0];
+  ball->robot_target_y = target[1];
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Check whether the ball hits the face of the given paddle
+    during the rest of its time step. The ball's path is swept from its
+    current position, so a fast ball or a long step can't tunnel through
+    the paddle, and only a ball moving towards the paddle can hit it, so a
+    ball still touching the paddle after a rebound isn't bounced again.
+    If a collision is detected:
+      - move the ball to the point of impact and use up that part of its
+        time_step
+      - flip the ball's dx so it rebounds from the paddle
+      - update the ball's 'fudge' factor for the next collision
+      - call apply_english() to change the ball's speed or angle of return
+    Parameters:
+      Ball* ball: pointer to game ball object
+      Paddle* paddle: pointer to player paddle
+      Rng* rng: random number generator of the game
+    Returns: true if the ball rebounded from the paddle
+    ---------------------------------------------------------------------- */
+bool check_collision(Ball* ball, Paddle* paddle, Rng* rng) {
+  double vx = ball->dx * ball->speed;
+  double vy = ball->dy * ball->speed;
+  if (vx == 0) {
+    return false;
+  }
+
+  // the ball's leading edge and the paddle face it is heading for
+  double lead = vx > 0 ? ball->x + ball->w : ball->x;
+  double face = vx > 0 ? paddle->x : paddle->x + paddle->w;
+  double impact = (face - lead) / vx;
+  if (impact < 0 || impact > ball->time_step) {
+    // moving away from the face, already past it, or not reaching it
+    return false;
+  }
+
+  double y = ball->y + vy * impact;
+  bool collided =
+    y + ball->h >= paddle->y &&         // ball bottom past paddle top
+    y <= paddle->y + paddle->h;         // ball top edge past paddle bottom
+
+  // bounce the ball off the paddle
+  if (collided) {
+    ball->x = vx > 0 ? face - ball->w : face;
+    ball->y = y;
+    ball->time_step -= impact;
+    ball->dx *= -1;
+    ball->fudge = get_fudge(rng);
+    // give player a chance to change the ball speed
+    apply_english(ball, paddle, rng);
+    ball->predicted = false;
+  }
+  return collided;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Applies 'English' to the ball on rebound from the paddle.
+    Calculates a value based on which of 5 segments the ball makes contact:
+      - For the outermost segments 1 and 5 the ball's dy value is increased by 2.
+      - For the inner segments 2 and 4 the ball's dy value is increased by 1.
+      - For the middle segment 3 the ball's speed is increased by 10, up to 
+        BALL_MAX_SPEED.
+    Parameters:
+      Ball* ball: pointer to game ball object
+      Paddle* paddle: pointer to player paddle
+      Rng* rng: random number generator of the game
+    Returns: none
+
+    'paddle_segment' is only used for display in the stats string
+
+    By a random 1 in 6 chance the function may return early without 
+    changing the ball.
+    ---------------------------------------------------------------------- */
+void apply_english(Ball* ball, Paddle* paddle, Rng* rng) {
+  // rng_int(rng, n) == 0 is true 1/n times, i.e. 1/6
+  if (rng_int(rng, 6) == 0) {
+    return;
+  }
+  // reset segment id
+  ball->paddle_segment = 0;
+
+  // divide paddle into 5 sections, apply angle and/or speed change
+  // for each section
+  int ball_top = ball->y;
+  int paddle_top = paddle->y;
+  int paddle_s1 = paddle->y + paddle->h / 5;
+  int paddle_s2 = paddle->y + (paddle->h / 5) * 2;
+  int paddle_s3 = paddle->y + (paddle->h / 5) * 3;
+  int paddle_s4 = paddle->y + (paddle->h / 5) * 4;
+  int paddle_bottom = paddle->y + paddle->h;
+
+  bool hit_s1 = ball_top >= paddle_top && ball_top <= paddle_s1;
+  bool hit_s2 = ball_top >= paddle_s1 && ball_top <= paddle_s2;
+  bool hit_s3 = ball_top >= paddle_s2 && ball_top <= paddle_s3;
+  bool hit_s4 = ball_top >= paddle_s3 && ball_top <= paddle_s4;
+  bool hit_s5 = ball_top >= paddle_s4 && ball_top <= paddle_bottom;
+
+  if (hit_s1) {
+    ball->dy -= 2;
+    ball->paddle_segment = 1;
+  }
+  if (hit_s2) {
+    ball->dy -= 1;
+    ball->paddle_segment = 2;
+  }
+  if (hit_s3) {
+    if (ball->speed < BALL_MAX_SPEED) {
+      ball->speed += 10;
+    }
+    ball->paddle_segment = 3;
+  }
+  if (hit_s4) {
+    ball->dy += 1;
+    ball->paddle_segment = 4;
+  }
+
+  if (hit_s5) {
+    ball->dy += 2;
+    ball->paddle_segment = 5;
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Move the paddle up or down within the bounds of the court,
+    COURT_OFFSIDE at the top edge, or COURT_HEIGHT at the bottom edge. This
+    creates a buffer area at top and bottom of the court (delineated by white
+    lines) that allows the ball to occasionally sneak past the paddle. 
+    Parameters: 
+      Paddle* paddle: pointer to player paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void move_paddle(Paddle* paddle) {
+  paddle->y += paddle->dy * paddle->speed * paddle->time_step;
+  if (paddle->y < COURT_OFFSIDE) {
+    paddle->y = COURT_OFFSIDE;
+  }
+  if (paddle->y + paddle->h > COURT_HEIGHT) {
+    paddle->y = COURT_HEIGHT - paddle->h;
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Update the ball's x and y position to move it across the court.
+    The new positions are the product of the ball's dx, speed and the time_step
+    which adjusts the dx and speed to consitent frame independent motion.
+    If the ball reaches the court wall it is moving towards within its
+    time_step, it stops at the wall, dy is flipped so that it rebounds, and
+    the rest of the time_step is left for the next call.
+    Parameters: 
+      Ball* ball: pointer to the game ball object
+    Returns: true if the ball rebounded from a wall
+    ---------------------------------------------------------------------- */
+bool move_ball(Ball* ball) {
+  double vx = ball->dx * ball->speed;
+  double vy = ball->dy * ball->speed;
+
+  // time until the ball reaches the wall it is moving towards
+  double impact = ball->time_step;
+  double wall_y = 0;
+  if (vy < 0) {
+    wall_y = 0;
+    impact = -ball->y / vy;
+  } else if (vy > 0) {
+    wall_y = SCREEN_HEIGHT - ball->h;
+    impact = (wall_y - ball->y) / vy;
+  }
+
+  if (impact >= ball->time_step) {
+    ball->x += vx * ball->time_step;
+    ball->y += vy * ball->time_step;
+    ball->time_step = 0;
+    return false;
+  }
+
+  // bounce off top and bottom at the point of impact
+  if (impact < 0) {
+    impact = 0;
+  }
+  ball->x += vx * impact;
+  ball->y = wall_y;
+  ball->time_step -= impact;
+  ball->dy *= -1;
+  return true;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Move the ball through its whole time_step, rebounding from
+    paddles and walls at the point of impact. Paddles and walls are tested
+    in turn from each impact point; after BALL_MAX_IMPACTS impacts the rest
+    of the step is dropped. Each rebound is added to the events.
+    Parameters: 
+      Ball* ball: pointer to the game ball object
+      Paddle* player: pointer to the player paddle
+      Paddle* robot: pointer to the robot paddle
+      Rng* rng: random number generator of the game
+      EventBuffer* events: receives the rebounds, or NULL
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int sweep_ball(Ball* ball, Paddle* player, Paddle* robot, Rng* rng,
+  EventBuffer* events) {
+  int hits = 0;
+  for (int i = 0; i < BALL_MAX_IMPACTS && ball->time_step > 0; i++) {
+    if (check_collision(ball, player, rng)) {
+      push_event(events, EVENT_PADDLE_HIT, PLAYER);
+      hits++;
+    } else if (check_collision(ball, robot, rng)) {
+      push_event(events, EVENT_PADDLE_HIT, ROBOT);
+      hits++;
+    } else if (move_ball(ball)) {
+      push_event(events, EVENT_WALL_HIT, NOBODY);
+    }
+  }
+  return hits;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Add an event to a buffer. Events past MATCH_MAX_EVENTS
+    are dropped.
+    Parameters:
+      EventBuffer* events: pointer to the buffer, NULL is ignored
+      EventType type: what happened
+      Player player: owner of the paddle hit, the scorer, or NOBODY
+    Returns: none
+    ---------------------------------------------------------------------- */
+void push_event(EventBuffer* events, EventType type, Player player) {
+  if (events == NULL || events->count >= MATCH_MAX_EVENTS) {
+    return;
+  }
+  events->events[events->count++] = (Event){ .type = type, .player = player };
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Score a point: end the match at MAX_SCORE, otherwise
+    serve the ball from the scorer's paddle. The point is added to the
+    events and the rally is closed.
+    Parameters:
+      Match* match: pointer to the Match object
+      Player scorer: PLAYER or ROBOT
+    Returns: none
+    ---------------------------------------------------------------------- */
+void award_point(Match* match, Player scorer) {
+  Paddle* paddle = scorer == PLAYER ? &match->player : &match->robot;
+  int* score = scorer == PLAYER ?
+    &match->score_board.player : &match->score_board.robot;
+  (*score)++;
+  if (*score >= MAX_SCORE) {
+    match->over = true;
+    match->winner = scorer;
+  } else {
+    reset_ball(&match->ball, scorer, &match->rng);
+    match->ball.y = paddle->y + paddle->h / 2;
+  }
+  push_event(&match->events, EVENT_POINT, scorer);
+  match->last_rally = match->rally;
+  match->rally = 0;
+}
+
+// tell the match's phase hook, if any, that a phase begins or ends
+static void mark_phase(Match* match, const char* name, bool begin) {
+  if (match->phase != NULL) {
+    match->phase(name, begin, match->phase_ctx);
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Advance the match by one step: AI paddle updates,
+    paddle movement, the ball's swept movement with its paddle and wall
+    rebounds, then scoring. Resets the
+    match first if the previous step ended it. With the match's
+    fixed_point set, the movement runs in fixed point with fixed_step().
+    The match's events are cleared, then hold what happened in this step.
+    The match's phase hook, if set, brackets the "update_player",
+    "movement", "check_collision" or "fixed_step", and "scoring" phases.
+    Parameters: 
+      Match* match: pointer to the Match object
+      double time_step: elapsed time in seconds to simulate
+    Returns: Player who scored a point during this step, or NOBODY
+    ---------------------------------------------------------------------- */
+Player step_match(Match* match, double time_step) {
+  Player scorer = NOBODY;
+  match->events.count = 0;
+
+  // reset game
+  if (match->over) {
+    reset_match(match);
+  }
+
+  if (match->fixed_point) {
+    // the same AI, movement and sweep in integers
+    mark_phase(match, "fixed_step", true);
+    match->rally += fixed_step(match, time_step);
+    mark_phase(match, "fixed_step", false);
+  } else {
+    mark_phase(match, "update_player", true);
+    if (match->idle) {
+      // let AI control player paddle
+      update_player(&match->ball, &match->player);
+    }
+
+    // in a versus match the robot paddle has its own input
+    if (match->idle || !match->versus) {
+      update_player(&match->ball, &match->robot);
+    }
+    mark_phase(match, "update_player", false);
+
+    match->ball.time_step = time_step;
+    match->player.time_step = time_step;
+    match->robot.time_step = time_step;
+
+    mark_phase(match, "movement", true);
+    move_paddle(&match->player);
+    move_paddle(&match->robot);
+    mark_phase(match, "movement", false);
+
+    // move ball, rebounding from the paddles where they now are
+    mark_phase(match, "check_collision", true);
+    match->rally += sweep_ball(&match->ball, &match->player, &match->robot,
+      &match->rng, &match->events);
+    mark_phase(match, "check_collision", false);
+  }
+
+  // check for score
+  mark_phase(match, "scoring", true);
+  if (match->ball.x < 0) {
+    scorer = PLAYER;
+  } else if (match->ball.x > SCREEN_WIDTH) {
+    scorer = ROBOT;
+  }
+  if (scorer != NOBODY) {
+    award_point(match, scorer);
+  }
+  mark_phase(match, "scoring", false);
+  return scorer;
+}
+
+// FNV-1a step over raw bytes
+static void hash_bytes(uint64_t* hash, const void* data, size_t size) {
+  const unsigned char* bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    *hash = (*hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: FNV-1a hash over the state that decides the rest of a
+    match: random generator, ball and paddles. Used to check that a replay
+    or a networked peer ended up in exactly the same state.
+    Parameters: 
+      Match* match: pointer to the Match object
+    Returns: 64 bit hash
+    ---------------------------------------------------------------------- */
+uint64_t hash_match(Match* match) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  hash_bytes(&hash, &match->rng, sizeof(match->rng));
+  hash_bytes(&hash, &match->ball.x, sizeof(match->ball.x));
+  hash_bytes(&hash, &match->ball.y, sizeof(match->ball.y));
+  hash_bytes(&hash, &match->ball.dx, sizeof(match->ball.dx));
+  hash_bytes(&hash, &match->ball.dy, sizeof(match->ball.dy));
+  hash_bytes(&hash, &match->ball.speed, sizeof(match->ball.speed));
+  hash_bytes(&hash, &match->player.y, sizeof(match->player.y));
+  hash_bytes(&hash, &match->player.dy, sizeof(match->player.dy));
+  hash_bytes(&hash, &match->robot.y, sizeof(match->robot.y));
+  hash_bytes(&hash, &match->robot.dy, sizeof(match->robot.dy));
+  return hash;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Play one AI vs AI match from a fresh game to MAX_SCORE with
+    a fixed time step, accumulating the result into the given stats. 
+    Matches that fail to finish within HEADLESS_MAX_TICKS (e.g. a ball 
+    stuck on a wall) are abandoned and counted separately.
+    Parameters: 
+      Match* match: pointer to the Match object
+      double time_step: simulated seconds per tick
+      MatchStats* stats: pointer to the stats to add this match to
+    Returns: winner of the match, or NOBODY if it was abandoned
+    ---------------------------------------------------------------------- */
+Player play_match(Match* match, double time_step, MatchStats* stats) {
+  reset_match(match);
+  match->winner = NOBODY;
+
+  int ticks = 0;
+  while (!match->over && ticks < HEADLESS_MAX_TICKS) {
+    if (step_match(match, time_step) != NOBODY) {
+      stats->points++;
+      stats->volleys += match->last_rally;
+      if (match->last_rally > stats->longest_rally) {
+        stats->longest_rally = match->last_rally;
+      }
+    }
+    ticks++;
+  }
+  stats->ticks += ticks;
+  stats->matches++;
+
+  if (match->winner == PLAYER) {
+    stats->player_wins++;
+  } else if (match->winner == ROBOT) {
+    stats->robot_wins++;
+  } else {
+    stats->abandoned++;
+  }
+  return match->winner;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Add the counts of one MatchStats object into another
+    Parameters: 
+      MatchStats* total: pointer to the stats to add to
+      MatchStats* stats: pointer to the stats to add
+    Returns: none
+    ---------------------------------------------------------------------- */
+void add_match_stats(MatchStats* total, MatchStats* stats) {
+  total->matches += stats->matches;
+  total->player_wins += stats->player_wins;
+  total->robot_wins += stats->robot_wins;
+  total->abandoned += stats->abandoned;
+  total->ticks += stats->ticks;
+  total->events += stats->events;
+  total->points += stats->points;
+  total->volleys += stats->volleys;
+  if (stats->longest_rally > total->longest_rally) {
+    total->longest_rally = stats->longest_rally;
+  }
+}
@@ -0,0 +1,452 @@
+#ifndef CORE_H
+#define CORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+/*
+  The simulation of a match, with no SDL in it: court, ball, paddles,
+  AI, scoring and the random number generator. It builds on its own into
+  the pong_core library (make core), for servers, benchmarks and
+  trainers that have no window, audio or fonts. The game's front end in
+  pong.h wraps a Match in its Game and plays the sounds of the events a
+  step leaves behind.
+*/
+
+#define SCREEN_WIDTH 640
+#define SCREEN_HEIGHT 480
+#define SCREEN_MID_W SCREEN_WIDTH / 2
+#define SCREEN_MID_H SCREEN_HEIGHT / 2
+#define COURT_OFFSIDE 20
+#define COURT_HEIGHT SCREEN_HEIGHT - COURT_OFFSIDE
+
+#define BALL_SIZE 10
+#define BALL_MIN_SPEED 70
+#define BALL_MAX_SPEED 120
+#define PADDLE_W 10
+#define PADDLE_H 60
+#define PADDLE_SPEED 20
+#define PADDLE_Y SCREEN_MID_H - PADDLE_H / 2
+#define GOAL_OFFSET 15
+#define PLAYER_X SCREEN_WIDTH - PADDLE_W - GOAL_OFFSET
+#define ROBOT_X GOAL_OFFSET
+//                        | -1 |  BS  |   PW   |   GO   ||<- Screen Width
+#define PLAYER_SERVICE_X SCREEN_WIDTH - GOAL_OFFSET - PADDLE_W - BALL_SIZE - 1
+#define ROBOT_SERVICE_X PADDLE_W + GOAL_OFFSET + 1
+
+#define MAX_SCORE 20
+// paddle and wall rebounds resolved per simulation step
+#define BALL_MAX_IMPACTS 8
+// events one step can leave: every impact, then a point
+#define MATCH_MAX_EVENTS BALL_MAX_IMPACTS + 1
+
+#define HEADLESS_MAX_TICKS 1000000
+
+typedef enum {
+  NOBODY,
+  PLAYER,
+  ROBOT
+} Player;
+
+// player input that changes the simulation, as recorded in replays
+typedef enum {
+  COMMAND_NONE,
+  COMMAND_UP_PRESS,
+  COMMAND_UP_RELEASE,
+  COMMAND_DOWN_PRESS,
+  COMMAND_DOWN_RELEASE,
+  COMMAND_START,
+  COMMAND_RESET,
+  COMMAND_COUNT
+} Command;
+
+typedef struct Rng Rng;
+struct Rng {
+  uint64_t state[4];
+};
+
+typedef struct Ball Ball;
+struct Ball {
+  int speed;
+  double dx;
+  double dy;
+  double x;
+  double y;
+  int fudge;
+  int paddle_segment;
+  int h;
+  int w;
+  double time_step;
+  Player service;
+  // where the ball will cross each paddle face, see predict_ball()
+  bool predicted;
+  double player_target_y;
+  double robot_target_y;
+};
+
+typedef struct Paddle Paddle;
+struct Paddle {
+  Player owner;
+  int speed;
+  double time_step;
+  double dx;
+  double dy;
+  int fudge;
+  int h;
+  int w;
+  double x;
+  double y;
+};
+
+typedef struct ScoreBoard ScoreBoard;
+struct ScoreBoard {
+  int player;
+  int robot;
+};
+
+// something a step did that the front end may want to hear
+typedef enum {
+  EVENT_PADDLE_HIT,
+  EVENT_WALL_HIT,
+  EVENT_POINT
+} EventType;
+
+typedef struct Event Event;
+struct Event {
+  EventType type;
+  // owner of the paddle hit, or the player who scored
+  Player player;
+};
+
+// the events of the last step, in the order they happened
+typedef struct EventBuffer EventBuffer;
+struct EventBuffer {
+  int count;
+  Event events[MATCH_MAX_EVENTS];
+};
+
+// called by step_match() as each phase begins and ends, e.g. to time it
+typedef void (*MatchPhase)(const char* name, bool begin, void* ctx);
+
+/*
+  Everything that decides a match, as plain data: it can be copied,
+  saved for a rollback or stepped on any thread.
+*/
+typedef struct Match Match;
+struct Match {
+  ScoreBoard score_board;
+  Player winner;
+  Paddle player;
+  Paddle robot;
+  Ball ball;
+  Rng rng;
+  int rally;
+  int last_rally;
+  // two-player match: the robot paddle is moved by its own input
+  bool versus;
+  // move the ball and paddles in fixed point, see fixed.h
+  bool fixed_point;
+  bool idle;
+  bool over;
+  EventBuffer events;
+  // optional step_match() phase hook and its context, NULL for none
+  MatchPhase phase;
+  void* phase_ctx;
+};
+
+typedef struct MatchStats MatchStats;
+struct MatchStats {
+  uint64_t matches;
+  uint64_t player_wins;
+  uint64_t robot_wins;
+  uint64_t abandoned;
+  uint64_t ticks;
+  // ball events of event-driven matches, which have no ticks, see skip.h
+  uint64_t events;
+  uint64_t points;
+  uint64_t volleys;
+  int longest_rally;
+};
+
+/*  ---------------------------------------------------------------------- 
+    Description: Seed a random number generator. Each Match (and each 
+    simulation worker thread) owns its own generator, so concurrent games
+    never share or lock random state.
+    Parameters: 
+      Rng* rng: pointer to the generator
+      uint64_t seed: seed value, any value including 0 is valid
+    Returns: none
+    ---------------------------------------------------------------------- */
+void rng_seed(Rng* rng, uint64_t seed);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Draw 64 random bits (xoshiro256**)
+    Parameters: 
+      Rng* rng: pointer to the generator
+    Returns: random uint64_t
+    ---------------------------------------------------------------------- */
+uint64_t rng_next(Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Advance a generator by 2^128 draws. Generators seeded
+    once and then jumped 0, 1, 2... times give non-overlapping streams for
+    parallel workers.
+    Parameters: 
+      Rng* rng: pointer to the generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+void rng_jump(Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Draw a random integer from 0 to n-1, the range of the 
+    rand() % n expressions it replaces. Every value is equally likely.
+    Parameters: 
+      Rng* rng: pointer to the generator
+      int n: number of possible values, greater than 0
+    Returns: random int in [0, n)
+    ---------------------------------------------------------------------- */
+int rng_int(Rng* rng, int n);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset Match object to defaults for new game
+    Parameters: Match* match - match object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_match(Match* match);
+
+/*  ----------------------------------------------------------------------
+    Description: Seed the match and serve the first ball, leaving the
+    scores as they are. A recorded game and its replay start from this
+    same state.
+    Parameters:
+      Match* match: pointer to the Match object
+      uint64_t seed: random seed
+    Returns: none
+    ---------------------------------------------------------------------- */
+void seed_match(Match* match, uint64_t seed);
+
+/*  ----------------------------------------------------------------------
+    Description: Apply one player command to the match: move the player
+    paddle, or start or reset the match
+    Parameters:
+      Match* match: pointer to the Match object
+      Command command: command to apply
+    Returns: none
+    ---------------------------------------------------------------------- */
+void apply_match_command(Match* match, Command command);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset specified Paddle object to defaults for given Player
+    Parameters: 
+      Paddle* paddle: pointer to player paddle
+      Player* owner: owner of paddle (either PLAYER or ROBOT), 
+      determines x position of paddle on court
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_paddle(Paddle* paddle, Player owner);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Reset Ball object to defaults. Sets the ball's initial
+    dx, dy and 'fudge' to random values within a specified range.
+    Parameters:   
+      Ball* ball: ball object
+      Player server: player serving ball, determines the position and direction
+      of the ball for service.
+      Rng* rng: random number generator of the game
+    Returns: none
+    ---------------------------------------------------------------------- */
+void reset_ball(Ball* ball, Player server, Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Generate a random 'fudge' value between 0 and 14 
+    that affects a paddle's movement speed, either increasing or decreasing 
+    the paddle's y axis motion
+    Parameters: 
+      Rng* rng: random number generator of the game
+    Returns: int fudge value
+    ---------------------------------------------------------------------- */
+int get_fudge(Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Updates the paddle oject's dy value to move the paddle 
+    toward where the ball will cross its face, as found by predict_ball().
+    The dy value is set to the paddle speed minus the 'fudge' factor, which
+    may speed up or slow down the paddle, so the AI can still miss.
+    Called by the Robot paddle when in play state. Called by both player and
+    robot paddles when game is in Idle state, to simulate a game.
+    Parameters: 
+      Ball* ball: the game ball
+      Paddle* paddle: the paddle object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void update_player(Ball* ball, Paddle* paddle);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Work out in closed form the y position at which the ball
+    will reach the player and the robot paddle faces, and cache them in the
+    ball until a paddle hit or serve changes its course. Wall rebounds are
+    accounted for by unfolding the court: the ball's y travels in a straight
+    line and is folded back into the court (y mod 2 * height, mirrored in
+    the upper half), so a wall hit doesn't change the prediction. For the
+    paddle the ball is moving away from, the ball is assumed to rebound from
+    the other paddle without any english. A ball with no course to a face,
+    e.g. one already past a paddle, is chased where it is: the targets are
+    its current y and the prediction is left stale, so the next step
+    predicts again.
+    Parameters: 
+      Ball* ball: the game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void predict_ball(Ball* ball);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Check whether the ball hits the face of the given paddle
+    during the rest of its time step. The ball's path is swept from its
+    current position, so a fast ball or a long step can't tunnel through
+    the paddle, and only a ball moving towards the paddle can hit it, so a
+    ball still touching the paddle after a rebound isn't bounced again.
+    If a collision is detected:
+      - move the ball to the point of impact and use up that part of its
+        time_step
+      - flip the ball's dx so it rebounds from the paddle
+      - update the ball's 'fudge' factor for the next collision
+      - call apply_english() to change the ball's speed or angle of return
+    Parameters:
+      Ball* ball: pointer to game ball object
+      Paddle* paddle: pointer to player paddle
+      Rng* rng: random number generator of the game
+    Returns: true if the ball rebounded from the paddle
+    ---------------------------------------------------------------------- */
+bool check_collision(Ball* ball, Paddle* paddle, Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Applies 'English' to the ball on rebound from the paddle.
+    Calculates a value based on which of 5 segments the ball makes contact:
+      - For the outermost segments 1 and 5 the ball's dy value is increased by 2.
+      - For the inner segments 2 and 4 the ball's dy value is increased by 1.
+      - For the middle segment 3 the ball's speed is increased by 10, up to 
+        BALL_MAX_SPEED.
+    Parameters:
+      Ball* ball: pointer to game ball object
+      Paddle* paddle: pointer to player paddle
+      Rng* rng: random number generator of the game
+    Returns: none
+
+    'paddle_segment' is only used for display in the stats string
+
+    By a random 1 in 6 chance the function may return early without 
+    changing the ball.
+    ---------------------------------------------------------------------- */
+void apply_english(Ball* ball, Paddle* paddle, Rng* rng);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Move the paddle up or down within the bounds of the court,
+    COURT_OFFSIDE at the top edge, or COURT_HEIGHT at the bottom edge. This
+    creates a buffer area at top and bottom of the court (delineated by white
+    lines) that allows the ball to occasionally sneak past the paddle. 
+    Parameters: 
+      Paddle* paddle: pointer to player paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void move_paddle(Paddle* paddle);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Update the ball's x and y position to move it across the court.
+    The new positions are the product of the ball's dx, speed and the time_step
+    which adjusts the dx and speed to consitent frame independent motion.
+    If the ball reaches the court wall it is moving towards within its
+    time_step, it stops at the wall, dy is flipped so that it rebounds, and
+    the rest of the time_step is left for the next call.
+    Parameters: 
+      Ball* ball: pointer to the game ball object
+    Returns: true if the ball rebounded from a wall
+    ---------------------------------------------------------------------- */
+bool move_ball(Ball* ball);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Move the ball through its whole time_step, rebounding from
+    paddles and walls at the point of impact. Paddles and walls are tested
+    in turn from each impact point; after BALL_MAX_IMPACTS impacts the rest
+    of the step is dropped. Each rebound is added to the events.
+    Parameters: 
+      Ball* ball: pointer to the game ball object
+      Paddle* player: pointer to the player paddle
+      Paddle* robot: pointer to the robot paddle
+      Rng* rng: random number generator of the game
+      EventBuffer* events: receives the rebounds, or NULL
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int sweep_ball(Ball* ball, Paddle* player, Paddle* robot, Rng* rng,
+  EventBuffer* events);
+
+/*  ----------------------------------------------------------------------
+    Description: Add an event to a buffer. Events past MATCH_MAX_EVENTS
+    are dropped.
+    Parameters:
+      EventBuffer* events: pointer to the buffer, NULL is ignored
+      EventType type: what happened
+      Player player: owner of the paddle hit, the scorer, or NOBODY
+    Returns: none
+    ---------------------------------------------------------------------- */
+void push_event(EventBuffer* events, EventType type, Player player);
+
+/*  ----------------------------------------------------------------------
+    Description: Score a point: end the match at MAX_SCORE, otherwise
+    serve the ball from the scorer's paddle. The point is added to the
+    events and the rally is closed.
+    Parameters:
+      Match* match: pointer to the Match object
+      Player scorer: PLAYER or ROBOT
+    Returns: none
+    ---------------------------------------------------------------------- */
+void award_point(Match* match, Player scorer);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Advance the match by one step: AI paddle updates,
+    paddle movement, the ball's swept movement with its paddle and wall
+    rebounds, then scoring. Resets the
+    match first if the previous step ended it. With the match's
+    fixed_point set, the movement runs in fixed point with fixed_step().
+    The match's events are cleared, then hold what happened in this step.
+    The match's phase hook, if set, brackets the "update_player",
+    "movement", "check_collision" or "fixed_step", and "scoring" phases.
+    Parameters: 
+      Match* match: pointer to the Match object
+      double time_step: elapsed time in seconds to simulate
+    Returns: Player who scored a point during this step, or NOBODY
+    ---------------------------------------------------------------------- */
+Player step_match(Match* match, double time_step);
+
+/*  ---------------------------------------------------------------------- 
+    Description: FNV-1a hash over the state that decides the rest of a
+    match: random generator, ball and paddles. Used to check that a replay
+    or a networked peer ended up in exactly the same state.
+    Parameters: 
+      Match* match: pointer to the Match object
+    Returns: 64 bit hash
+    ---------------------------------------------------------------------- */
+uint64_t hash_match(Match* match);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Play one AI vs AI match from a fresh game to MAX_SCORE with
+    a fixed time step, accumulating the result into the given stats. 
+    Parameters: 
+      Match* match: pointer to the Match object
+      double time_step: simulated seconds per tick
+      MatchStats* stats: pointer to the stats to add this match to
+    Returns: winner of the match, or NOBODY if it was abandoned
+    ---------------------------------------------------------------------- */
+Player play_match(Match* match, double time_step, MatchStats* stats);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Add the counts of one MatchStats object into another
+    Parameters: 
+      MatchStats* total: pointer to the stats to add to
+      MatchStats* stats: pointer to the stats to add
+    Returns: none
+    ---------------------------------------------------------------------- */
+void add_match_stats(MatchStats* total, MatchStats* stats);
+
+#endif
@@ -0,0 +1,135 @@
+// Batched training environments for paddle agents
+#include <stdio.h>
+#include <stdlib.h>
+#include "env.h"
+
+// start an episode: fresh scores, ball served, robot AI in play
+static void start_episode(EnvGame* game) {
+  game->match.over = false;
+  reset_match(&game->match);
+  game->match.idle = false;
+  game->ticks = 0;
+}
+
+static void observe(Match* match, float* observation) {
+  observation[ENV_BALL_X] = (float)match->ball.x;
+  observation[ENV_BALL_Y] = (float)match->ball.y;
+  observation[ENV_BALL_DX] = (float)match->ball.dx;
+  observation[ENV_BALL_DY] = (float)match->ball.dy;
+  observation[ENV_BALL_SPEED] = (float)match->ball.speed;
+  observation[ENV_PLAYER_Y] = (float)match->player.y;
+  observation[ENV_ROBOT_Y] = (float)match->robot.y;
+  observation[ENV_PLAYER_SCORE] = (float)match->score_board.player;
+  observation[ENV_ROBOT_SCORE] = (float)match->score_board.robot;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Create a batch of environments
+    Parameters:
+      int n_envs: number of environments
+      uint64_t seed: seed of the first environment, each further one jumps
+      ahead of the previous one with rng_jump()
+    Returns: PongEnv* pointer to the new batch, or NULL on failure
+    ---------------------------------------------------------------------- */
+PongEnv* pong_env_create(int n_envs, uint64_t seed) {
+  if (n_envs < 1) {
+    fprintf(stderr, "An environment batch needs at least one game\n");
+    return NULL;
+  }
+  PongEnv* env = calloc(1, sizeof(PongEnv));
+  EnvGame* games = calloc(n_envs, sizeof(EnvGame));
+  if (env == NULL || games == NULL) {
+    fprintf(stderr, "Failed to allocate %d environments\n", n_envs);
+    free(env);
+    free(games);
+    return NULL;
+  }
+  env->count = n_envs;
+  env->time_step = ENV_TIME_STEP;
+  env->games = games;
+
+  // one generator, jumped ahead per environment for non-overlapping streams
+  Rng rng;
+  rng_seed(&rng, seed);
+  for (int i = 0; i < n_envs; i++) {
+    games[i] = (EnvGame){
+      .match = { .winner = NOBODY },
+    };
+    games[i].match.rng = rng;
+    rng_jump(&rng);
+    start_episode(&games[i]);
+  }
+  return env;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Number of floats per environment in the observations,
+    for bindings that can't see ENV_OBS_SIZE
+    Parameters: none
+    Returns: ENV_OBS_SIZE
+    ---------------------------------------------------------------------- */
+int pong_env_observation_size(void) {
+  return ENV_OBS_SIZE;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Start a new episode in every environment
+    Parameters:
+      PongEnv* env: pointer to the batch
+      float* observations: receives n_envs * ENV_OBS_SIZE floats
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_reset(PongEnv* env, float* observations) {
+  for (int i = 0; i < env->count; i++) {
+    start_episode(&env->games[i]);
+    observe(&env->games[i].match, observations + (size_t)i * ENV_OBS_SIZE);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Step every environment once with its action, resetting
+    those whose episode ended
+    Parameters:
+      PongEnv* env: pointer to the batch
+      const int* actions: n_envs ENV_ACTION_* values
+      float* observations: receives n_envs * ENV_OBS_SIZE floats
+      float* rewards: receives n_envs rewards
+      float* dones: receives n_envs flags, 1 where an episode ended
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_step(PongEnv* env, const int* actions, float* observations,
+  float* rewards, float* dones) {
+  for (int i = 0; i < env->count; i++) {
+    EnvGame* game = &env->games[i];
+    Paddle* paddle = &game->match.player;
+    paddle->dy = actions[i] == ENV_ACTION_UP ? -paddle->speed :
+      actions[i] == ENV_ACTION_DOWN ? paddle->speed : 0;
+
+    Player scorer = step_match(&game->match, env->time_step);
+    game->ticks++;
+    rewards[i] = scorer == PLAYER ? 1.0f : scorer == ROBOT ? -1.0f : 0.0f;
+
+    bool done = game->match.over || game->ticks >= ENV_MAX_TICKS;
+    dones[i] = done ? 1.0f : 0.0f;
+    if (done) {
+      start_episode(game);
+      env->episodes++;
+    }
+    observe(&game->match, observations + (size_t)i * ENV_OBS_SIZE);
+  }
+  env->steps += env->count;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch of environments
+    Parameters:
+      PongEnv* env: pointer to the batch, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_destroy(PongEnv* env) {
+  if (env == NULL) {
+    return;
+  }
+  free(env->games);
+  free(env);
+}
@@ -0,0 +1,112 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include "core.h"
+
+// steps after which an episode that hasn't reached MAX_SCORE is cut off,
+// e.g. an agent that never misses against a robot that never misses
+#define ENV_MAX_TICKS 100000
+// simulated seconds per step by default, one frame of the game at 60 fps
+#define ENV_TIME_STEP (1.0 / 60)
+
+// actions for the player paddle
+#define ENV_ACTION_STAY 0
+#define ENV_ACTION_UP 1
+#define ENV_ACTION_DOWN 2
+
+// floats per environment in the observation buffer, in this order
+typedef enum {
+  ENV_BALL_X,
+  ENV_BALL_Y,
+  ENV_BALL_DX,
+  ENV_BALL_DY,
+  ENV_BALL_SPEED,
+  ENV_PLAYER_Y,
+  ENV_ROBOT_Y,
+  ENV_PLAYER_SCORE,
+  ENV_ROBOT_SCORE,
+  ENV_OBS_SIZE
+} EnvObservation;
+
+/*
+  A batch of independent training environments. In each, an agent moves
+  the player (right) paddle against the robot's update_player() AI with
+  the game's own step_match(). One call steps every environment and
+  writes straight into the caller's buffers, laid out as C arrays of
+  float32, so e.g. numpy arrays can be passed without copies:
+    observations[n_envs][ENV_OBS_SIZE], rewards[n_envs], dones[n_envs]
+  Rewards are +1 when the player scores and -1 when the robot does. An
+  episode is done when either reaches MAX_SCORE (or after ENV_MAX_TICKS),
+  and the environment resets right away, so the observation written with
+  done = 1 is the first of the next episode.
+  Each environment has its own generator, jumped ahead of the previous
+  one's, so the batch is reproducible from one seed. Only the SDL-free
+  simulation (core.h) is used, so a trainer doesn't need SDL.
+*/
+typedef struct EnvGame EnvGame;
+struct EnvGame {
+  Match match;
+  // steps in the current episode
+  int ticks;
+};
+
+typedef struct PongEnv PongEnv;
+struct PongEnv {
+  int count;
+  // simulated seconds per step, ENV_TIME_STEP unless changed
+  double time_step;
+  EnvGame* games;
+  uint64_t steps;
+  uint64_t episodes;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Create a batch of environments
+    Parameters:
+      int n_envs: number of environments
+      uint64_t seed: seed of the first environment, each further one jumps
+      ahead of the previous one with rng_jump()
+    Returns: PongEnv* pointer to the new batch, or NULL on failure
+    ---------------------------------------------------------------------- */
+PongEnv* pong_env_create(int n_envs, uint64_t seed);
+
+/*  ----------------------------------------------------------------------
+    Description: Number of floats per environment in the observations,
+    for bindings that can't see ENV_OBS_SIZE
+    Parameters: none
+    Returns: ENV_OBS_SIZE
+    ---------------------------------------------------------------------- */
+int pong_env_observation_size(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Start a new episode in every environment
+    Parameters:
+      PongEnv* env: pointer to the batch
+      float* observations: receives n_envs * ENV_OBS_SIZE floats
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_reset(PongEnv* env, float* observations);
+
+/*  ----------------------------------------------------------------------
+    Description: Step every environment once with its action, resetting
+    those whose episode ended
+    Parameters:
+      PongEnv* env: pointer to the batch
+      const int* actions: n_envs ENV_ACTION_* values
+      float* observations: receives n_envs * ENV_OBS_SIZE floats
+      float* rewards: receives n_envs rewards
+      float* dones: receives n_envs flags, 1 where an episode ended
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_step(PongEnv* env, const int* actions, float* observations,
+  float* rewards, float* dones);
+
+/*  ----------------------------------------------------------------------
+    Description: Free a batch of environments
+    Parameters:
+      PongEnv* env: pointer to the batch, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pong_env_destroy(PongEnv* env);
+
+#endif
@@ -0,0 +1,191 @@
+// Multi-core headless match farm with work stealing
+#include "farm.h"
+#include "skip.h"
+
+/*  ----------------------------------------------------------------------
+    Take up to FARM_CHUNK matches from the front of the worker's own queue.
+    Returns the number of matches taken, starting at *first.
+    ---------------------------------------------------------------------- */
+static int take_own(FarmWorker* worker, int* first) {
+  SDL_AtomicLock(&worker->lock);
+  int count = worker->end - worker->next;
+  if (count > FARM_CHUNK) {
+    count = FARM_CHUNK;
+  }
+  *first = worker->next;
+  worker->next += count;
+  SDL_AtomicUnlock(&worker->lock);
+  return count;
+}
+
+// matches left in a worker's queue, read under its lock
+static int queue_left(FarmWorker* worker) {
+  SDL_AtomicLock(&worker->lock);
+  int left = worker->end - worker->next;
+  SDL_AtomicUnlock(&worker->lock);
+  return left;
+}
+
+/*  ----------------------------------------------------------------------
+    Move half of the remaining matches of the fullest other worker onto
+    the thief's own queue. Returns false once no worker has matches left.
+    ---------------------------------------------------------------------- */
+static bool steal(FarmWorker* thief) {
+  Farm* farm = thief->farm;
+
+  for (;;) {
+    FarmWorker* victim = NULL;
+    int most = 0;
+    for (int i = 0; i < farm->count; i++) {
+      FarmWorker* worker = &farm->workers[i];
+      if (worker == thief) {
+        continue;
+      }
+      // only picks a victim, its queue may change before it is locked
+      int left = queue_left(worker);
+      if (left > most) {
+        most = left;
+        victim = worker;
+      }
+    }
+    if (victim == NULL) {
+      return false;
+    }
+
+    SDL_AtomicLock(&victim->lock);
+    int left = victim->end - victim->next;
+    int count = left > 1 ? left / 2 : left;
+    int first = victim->end - count;
+    victim->end = first;
+    SDL_AtomicUnlock(&victim->lock);
+
+    if (count > 0) {
+      SDL_AtomicLock(&thief->lock);
+      thief->next = first;
+      thief->end = first + count;
+      SDL_AtomicUnlock(&thief->lock);
+      thief->steals++;
+      return true;
+    }
+    // the victim drained its queue before we got the lock, look again
+  }
+}
+
+static int farm_worker(void* data) {
+  FarmWorker* worker = data;
+  int first;
+
+  char name[TRACE_THREAD_NAME_SIZE];
+  snprintf(name, sizeof(name), FARM_THREAD_NAME, worker->id);
+  trace_thread_name(name);
+
+  for (;;) {
+    int count = take_own(worker, &first);
+    if (count == 0) {
+      if (!steal(worker)) {
+        break;
+      }
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      if (worker->farm->event_driven) {
+        play_skip_match(&worker->match, &worker->stats);
+      } else {
+        play_match(&worker->match, worker->farm->time_step, &worker->stats);
+      }
+    }
+  }
+  return 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Play headless AI vs AI matches to MAX_SCORE on a pool of
+    worker threads. Matches are split evenly between the workers up front;
+    a worker that runs out steals half of the remaining matches from the
+    busiest other worker. Aggregated win rates, rally lengths and
+    throughput are logged when all matches are done.
+    Parameters:
+      int threads: number of worker threads, 0 for one per CPU
+      int matches: total number of matches to play
+      double time_step: simulated seconds per tick
+      Uint64 seed: seed of the first worker, each further worker jumps
+      ahead of the previous one with rng_jump()
+      bool fixed_point: play the matches with fixed point physics
+      bool event_driven: play the matches with play_skip_match()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_farm(int threads, int matches, double time_step, Uint64 seed,
+  bool fixed_point, bool event_driven) {
+  if (threads <= 0) {
+    threads = SDL_GetCPUCount();
+  }
+  if (threads > matches) {
+    threads = matches;
+  }
+
+  Farm farm = {
+    .workers = calloc(threads, sizeof(FarmWorker)),
+    .count = threads,
+    .time_step = time_step,
+    .event_driven = event_driven,
+  };
+  if (farm.workers == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate %d farm workers", threads);
+    return;
+  }
+
+  // one generator, jumped ahead per worker for non-overlapping streams
+  Rng rng;
+  rng_seed(&rng, seed);
+
+  for (int i = 0; i < threads; i++) {
+    FarmWorker* worker = &farm.workers[i];
+    worker->id = i;
+    worker->farm = &farm;
+    worker->next = (int)((Sint64)matches * i / threads);
+    worker->end = (int)((Sint64)matches * (i + 1) / threads);
+    worker->match = (Match){
+      .winner = NOBODY,
+      .idle = true,
+      .fixed_point = fixed_point,
+    };
+    worker->match.rng = rng;
+    rng_jump(&rng);
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // worker 0 runs on the calling thread
+  for (int i = 1; i < threads; i++) {
+    char name[TRACE_THREAD_NAME_SIZE];
+    snprintf(name, sizeof(name), FARM_THREAD_NAME, i);
+    farm.workers[i].thread =
+      SDL_CreateThread(farm_worker, name, &farm.workers[i]);
+    if (farm.workers[i].thread == NULL) {
+      SDL_LogWarn(LOGCAT, "Failed to start farm worker %d: %s",
+        i, SDL_GetError());
+    }
+  }
+  farm_worker(&farm.workers[0]);
+  for (int i = 1; i < threads; i++) {
+    SDL_WaitThread(farm.workers[i].thread, NULL);
+  }
+
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+
+  MatchStats total = {0};
+  int steals = 0;
+  for (int i = 0; i < threads; i++) {
+    add_match_stats(&total, &farm.workers[i].stats);
+    steals += farm.workers[i].steals;
+    SDL_LogDebug(LOGCAT, "Farm worker %d: %llu matches, %d steals",
+      i, (unsigned long long)farm.workers[i].stats.matches,
+      farm.workers[i].steals);
+  }
+
+  SDL_LogInfo(LOGCAT, "Farm: %d threads, %d steals", threads, steals);
+  log_match_stats("Farm", &total, elapsed);
+
+  free(farm.workers);
+}
@@ -0,0 +1,59 @@
+#ifndef FARM_H
+#define FARM_H
+
+#include "pong.h"
+
+// matches an idle worker takes from its own queue at a time
+#define FARM_CHUNK 8
+// name of worker N's thread, in SDL and in traces
+#define FARM_THREAD_NAME "farm-%d"
+
+typedef struct Farm Farm;
+
+/*
+  One worker thread of the match farm. Each worker owns its Game, random
+  number generator and stats, so matches never share mutable state. The
+  worker's queue is the half-open range of match numbers [next, end); the
+  owner takes chunks from the front and thieves take half of what is left
+  from the back, both under the worker's spinlock.
+*/
+typedef struct FarmWorker FarmWorker;
+struct FarmWorker {
+  SDL_SpinLock lock;
+  int next;
+  int end;
+  int id;
+  int steals;
+  Farm* farm;
+  SDL_Thread* thread;
+  Match match;
+  MatchStats stats;
+};
+
+struct Farm {
+  FarmWorker* workers;
+  int count;
+  double time_step;
+  bool event_driven;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Play headless AI vs AI matches to MAX_SCORE on a pool of
+    worker threads. Matches are split evenly between the workers up front;
+    a worker that runs out steals half of the remaining matches from the
+    busiest other worker. Aggregated win rates, rally lengths and
+    throughput are logged when all matches are done.
+    Parameters:
+      int threads: number of worker threads, 0 for one per CPU
+      int matches: total number of matches to play
+      double time_step: simulated seconds per tick
+      Uint64 seed: seed of the first worker, each further worker jumps
+      ahead of the previous one with rng_jump()
+      bool fixed_point: play the matches with fixed point physics
+      bool event_driven: play the matches with play_skip_match()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void run_farm(int threads, int matches, double time_step, Uint64 seed,
+  bool fixed_point, bool event_driven);
+
+#endif
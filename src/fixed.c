@@ -0,0 +1,413 @@
+// Deterministic 16.16 fixed point physics
+#include "fixed.h"
+
+// Ball and paddle limits in fixed point, see move_ball() and move_paddle()
+#define FIXED_BALL_MAX_Y FIXED_INT(SCREEN_HEIGHT - BALL_SIZE)
+#define FIXED_PADDLE_MIN_Y FIXED_INT(COURT_OFFSIDE)
+#define FIXED_PADDLE_MAX_Y FIXED_INT(COURT_HEIGHT - PADDLE_H)
+
+// whole pixels of a non-negative fixed point value, as an (int) cast
+static int fixed_pixels(Fixed value) {
+  return value / FIXED_ONE;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Round a double to the nearest fixed point value. Values
+    that came from fixed point convert back exactly.
+    Parameters:
+      double value: value to convert
+    Returns: Fixed value
+    ---------------------------------------------------------------------- */
+Fixed fixed_from_double(double value) {
+  // scaling by a power of two and truncating are exact in any float mode
+  double scaled = value * FIXED_ONE;
+  return scaled < 0 ? -(Fixed)(0.5 - scaled) : (Fixed)(scaled + 0.5);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point value to a double, exactly
+    Parameters:
+      Fixed value: value to convert
+    Returns: double value
+    ---------------------------------------------------------------------- */
+double fixed_to_double(Fixed value) {
+  return value / (double)FIXED_ONE;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a ball to fixed point
+    Parameters:
+      FixedBall* fixed: receives the fixed point ball
+      Ball* ball: game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_load_ball(FixedBall* fixed, Ball* ball) {
+  *fixed = (FixedBall){
+    .speed = ball->speed,
+    .dx = (int)ball->dx,
+    .dy = (int)ball->dy,
+    .x = fixed_from_double(ball->x),
+    .y = fixed_from_double(ball->y),
+    .fudge = ball->fudge,
+    .paddle_segment = ball->paddle_segment,
+    .time_step = fixed_from_double(ball->time_step),
+    .predicted = ball->predicted,
+    .player_target_y = fixed_from_double(ball->player_target_y),
+    .robot_target_y = fixed_from_double(ball->robot_target_y),
+  };
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point ball back into a game ball
+    Parameters:
+      Ball* ball: game ball, its sizes are kept
+      FixedBall* fixed: fixed point ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_store_ball(Ball* ball, FixedBall* fixed) {
+  ball->speed = fixed->speed;
+  ball->dx = fixed->dx;
+  ball->dy = fixed->dy;
+  ball->x = fixed_to_double(fixed->x);
+  ball->y = fixed_to_double(fixed->y);
+  ball->fudge = fixed->fudge;
+  ball->paddle_segment = fixed->paddle_segment;
+  ball->time_step = fixed_to_double(fixed->time_step);
+  ball->predicted = fixed->predicted;
+  ball->player_target_y = fixed_to_double(fixed->player_target_y);
+  ball->robot_target_y = fixed_to_double(fixed->robot_target_y);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a paddle to fixed point
+    Parameters:
+      FixedPaddle* fixed: receives the fixed point paddle
+      Paddle* paddle: game paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_load_paddle(FixedPaddle* fixed, Paddle* paddle) {
+  *fixed = (FixedPaddle){
+    .owner = paddle->owner,
+    .speed = paddle->speed,
+    .dy = (int)paddle->dy,
+    .time_step = fixed_from_double(paddle->time_step),
+    .x = fixed_from_double(paddle->x),
+    .y = fixed_from_double(paddle->y),
+  };
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point paddle back into a game paddle
+    Parameters:
+      Paddle* paddle: game paddle, its sizes are kept
+      FixedPaddle* fixed: fixed point paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_store_paddle(Paddle* paddle, FixedPaddle* fixed) {
+  paddle->speed = fixed->speed;
+  paddle->dy = fixed->dy;
+  paddle->time_step = fixed_to_double(fixed->time_step);
+  paddle->x = fixed_to_double(fixed->x);
+  paddle->y = fixed_to_double(fixed->y);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: predict_ball() in fixed point. The unfolded course is
+    worked out in 64 bit integers, so there is no fmod() to round.
+    Parameters:
+      FixedBall* ball: the game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_predict_ball(FixedBall* ball) {
+  Fixed left = FIXED_INT(ROBOT_X + PADDLE_W);
+  Fixed right = FIXED_INT(PLAYER_X - BALL_SIZE);
+  int64_t height = FIXED_INT(SCREEN_HEIGHT - BALL_SIZE);
+  int64_t period = 2 * height;
+
+  if (ball->dx == 0 || ball->x < left || ball->x > right) {
+    // chase the ball where it is, and again next step
+    ball->player_target_y = ball->y;
+    ball->robot_target_y = ball->y;
+    ball->predicted = false;
+    return;
+  }
+  ball->predicted = true;
+
+  int64_t to_player = ball->dx > 0 ?
+    right - ball->x : (int64_t)(ball->x - left) + (right - left);
+  int64_t to_robot = ball->dx < 0 ?
+    ball->x - left : (int64_t)(right - ball->x) + (right - left);
+
+  int run = ball->dx < 0 ? -ball->dx : ball->dx;
+  int64_t target[2] = {
+    ball->y + ball->dy * to_player / run,
+    ball->y + ball->dy * to_robot / run
+  };
+  for (int i = 0; i < 2; i++) {
+    int64_t y = target[i] % period;
+    if (y < 0) {
+      y += period;
+    }
+    target[i] = y > height ? period - y : y;
+  }
+  ball->player_target_y = (Fixed)target[0];
+  ball->robot_target_y = (Fixed)target[1];
+}
+
+/*  ----------------------------------------------------------------------
+    Description: update_player() in fixed point
+    Parameters:
+      FixedBall* ball: the game ball
+      FixedPaddle* paddle: the paddle object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_update_player(FixedBall* ball, FixedPaddle* paddle) {
+  int paddle_top = fixed_pixels(paddle->y);
+  int paddle_bottom = fixed_pixels(paddle->y + FIXED_INT(PADDLE_H));
+
+  // a ball past a paddle face has left its predicted course: chase it
+  if (ball->x < FIXED_INT(ROBOT_X + PADDLE_W) ||
+    ball->x > FIXED_INT(PLAYER_X - BALL_SIZE)) {
+    ball->predicted = false;
+  }
+  if (!ball->predicted) {
+    fixed_predict_ball(ball);
+  }
+  Fixed target_y = paddle->owner == PLAYER ?
+    ball->player_target_y : ball->robot_target_y;
+  int ball_top = fixed_pixels(target_y);
+  int ball_bottom = fixed_pixels(target_y + FIXED_INT(BALL_SIZE));
+  paddle->dy = 0;
+
+  if (ball_top < paddle_top) {
+    paddle->dy -= paddle->speed - ball->fudge;
+  }
+  if (ball_bottom > paddle_bottom) {
+    paddle->dy += paddle->speed - ball->fudge;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: move_paddle() in fixed point
+    Parameters:
+      FixedPaddle* paddle: pointer to the paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_move_paddle(FixedPaddle* paddle) {
+  paddle->y += paddle->dy * paddle->speed * paddle->time_step;
+  if (paddle->y < FIXED_PADDLE_MIN_Y) {
+    paddle->y = FIXED_PADDLE_MIN_Y;
+  }
+  if (paddle->y > FIXED_PADDLE_MAX_Y) {
+    paddle->y = FIXED_PADDLE_MAX_Y;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: move_ball() in fixed point. The time to the wall is
+    truncated, so the ball never passes it before it bounces.
+    Parameters:
+      FixedBall* ball: pointer to the game ball object
+    Returns: true if the ball rebounded from a wall
+    ---------------------------------------------------------------------- */
+bool fixed_move_ball(FixedBall* ball) {
+  int vx = ball->dx * ball->speed;
+  int vy = ball->dy * ball->speed;
+
+  Fixed impact = ball->time_step;
+  Fixed wall_y = 0;
+  if (vy < 0) {
+    wall_y = 0;
+    impact = -ball->y / vy;
+  } else if (vy > 0) {
+    wall_y = FIXED_BALL_MAX_Y;
+    impact = (wall_y - ball->y) / vy;
+  }
+
+  if (impact >= ball->time_step) {
+    ball->x += vx * ball->time_step;
+    ball->y += vy * ball->time_step;
+    ball->time_step = 0;
+    return false;
+  }
+
+  if (impact < 0) {
+    impact = 0;
+  }
+  ball->x += vx * impact;
+  ball->y = wall_y;
+  ball->time_step -= impact;
+  ball->dy *= -1;
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: check_collision() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to game ball object
+      FixedPaddle* paddle: pointer to the paddle
+      Rng* rng: random number generator of the game
+    Returns: true if the ball rebounded from the paddle
+    ---------------------------------------------------------------------- */
+bool fixed_check_collision(FixedBall* ball, FixedPaddle* paddle, Rng* rng) {
+  int vx = ball->dx * ball->speed;
+  int vy = ball->dy * ball->speed;
+  if (vx == 0) {
+    return false;
+  }
+
+  Fixed lead = vx > 0 ? ball->x + FIXED_INT(BALL_SIZE) : ball->x;
+  Fixed face = vx > 0 ? paddle->x : paddle->x + FIXED_INT(PADDLE_W);
+  Fixed gap = face - lead;
+  // moving away from the face or already past it; checked before the
+  // division, which would truncate a small negative time to 0
+  if (gap != 0 && (gap < 0) != (vx < 0)) {
+    return false;
+  }
+  Fixed impact = gap / vx;
+  if (impact > ball->time_step) {
+    return false;
+  }
+
+  Fixed y = ball->y + vy * impact;
+  bool collided =
+    y + FIXED_INT(BALL_SIZE) >= paddle->y &&
+    y <= paddle->y + FIXED_INT(PADDLE_H);
+
+  if (collided) {
+    ball->x = vx > 0 ? face - FIXED_INT(BALL_SIZE) : face;
+    ball->y = y;
+    ball->time_step -= impact;
+    ball->dx *= -1;
+    ball->fudge = get_fudge(rng);
+    fixed_apply_english(ball, paddle, rng);
+    ball->predicted = false;
+  }
+  return collided;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: apply_english() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to game ball object
+      FixedPaddle* paddle: pointer to the paddle
+      Rng* rng: random number generator of the game
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_apply_english(FixedBall* ball, FixedPaddle* paddle, Rng* rng) {
+  if (rng_int(rng, 6) == 0) {
+    return;
+  }
+  ball->paddle_segment = 0;
+
+  int segment = PADDLE_H / 5;
+  int ball_top = fixed_pixels(ball->y);
+  int paddle_top = fixed_pixels(paddle->y);
+  int paddle_s1 = fixed_pixels(paddle->y + FIXED_INT(segment));
+  int paddle_s2 = fixed_pixels(paddle->y + FIXED_INT(segment * 2));
+  int paddle_s3 = fixed_pixels(paddle->y + FIXED_INT(segment * 3));
+  int paddle_s4 = fixed_pixels(paddle->y + FIXED_INT(segment * 4));
+  int paddle_bottom = fixed_pixels(paddle->y + FIXED_INT(PADDLE_H));
+
+  bool hit_s1 = ball_top >= paddle_top && ball_top <= paddle_s1;
+  bool hit_s2 = ball_top >= paddle_s1 && ball_top <= paddle_s2;
+  bool hit_s3 = ball_top >= paddle_s2 && ball_top <= paddle_s3;
+  bool hit_s4 = ball_top >= paddle_s3 && ball_top <= paddle_s4;
+  bool hit_s5 = ball_top >= paddle_s4 && ball_top <= paddle_bottom;
+
+  if (hit_s1) {
+    ball->dy -= 2;
+    ball->paddle_segment = 1;
+  }
+  if (hit_s2) {
+    ball->dy -= 1;
+    ball->paddle_segment = 2;
+  }
+  if (hit_s3) {
+    if (ball->speed < BALL_MAX_SPEED) {
+      ball->speed += 10;
+    }
+    ball->paddle_segment = 3;
+  }
+  if (hit_s4) {
+    ball->dy += 1;
+    ball->paddle_segment = 4;
+  }
+  if (hit_s5) {
+    ball->dy += 2;
+    ball->paddle_segment = 5;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: sweep_ball() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to the game ball object
+      FixedPaddle* player: pointer to the player paddle
+      FixedPaddle* robot: pointer to the robot paddle
+      Rng* rng: random number generator of the game
+      EventBuffer* events: receives the rebounds, or NULL
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int fixed_sweep_ball(FixedBall* ball, FixedPaddle* player,
+  FixedPaddle* robot, Rng* rng, EventBuffer* events) {
+  int hits = 0;
+  for (int i = 0; i < BALL_MAX_IMPACTS && ball->time_step > 0; i++) {
+    if (fixed_check_collision(ball, player, rng)) {
+      push_event(events, EVENT_PADDLE_HIT, PLAYER);
+      hits++;
+    } else if (fixed_check_collision(ball, robot, rng)) {
+      push_event(events, EVENT_PADDLE_HIT, ROBOT);
+      hits++;
+    } else if (fixed_move_ball(ball)) {
+      push_event(events, EVENT_WALL_HIT, NOBODY);
+    }
+  }
+  return hits;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: The movement part of step_match() in fixed point, for
+    matches with fixed_point set: the AI paddle updates, paddle movement
+    and the ball's sweep, whose rebounds go into the match's events. The
+    match's ball and paddles are converted to fixed point, stepped and
+    stored back; since they only ever hold values that came from fixed
+    point, the conversions are exact, and the result is the same on every
+    compiler, CPU and floating point mode. The time step is rounded to a
+    fixed tick of whole 1/65536ths of a second.
+    Parameters:
+      Match* match: pointer to the Match object
+      double time_step: elapsed time in seconds to simulate, at most
+      FIXED_MAX_TIME_STEP
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int fixed_step(Match* match, double time_step) {
+  FixedBall ball;
+  FixedPaddle player;
+  FixedPaddle robot;
+  fixed_load_ball(&ball, &match->ball);
+  fixed_load_paddle(&player, &match->player);
+  fixed_load_paddle(&robot, &match->robot);
+
+  if (match->idle) {
+    fixed_update_player(&ball, &player);
+  }
+  if (match->idle || !match->versus) {
+    fixed_update_player(&ball, &robot);
+  }
+
+  Fixed tick = fixed_from_double(time_step);
+  ball.time_step = tick;
+  player.time_step = tick;
+  robot.time_step = tick;
+
+  fixed_move_paddle(&player);
+  fixed_move_paddle(&robot);
+  int hits = fixed_sweep_ball(&ball, &player, &robot, &match->rng,
+    &match->events);
+
+  fixed_store_ball(&match->ball, &ball);
+  fixed_store_paddle(&match->player, &player);
+  fixed_store_paddle(&match->robot, &robot);
+  return hits;
+}
@@ -0,0 +1,185 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include "core.h"
+
+// 16.16 fixed point: court pixels and seconds in 1/65536ths
+typedef int32_t Fixed;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_INT(n) ((Fixed)(n) * FIXED_ONE)
+// longest time step, so a velocity times a step stays within 32 bits
+#define FIXED_MAX_TIME_STEP 1.0
+
+/*
+  The ball in fixed point. Direction, speed and fudge are whole numbers
+  in the double path as well, so they are plain ints. Velocities are
+  dx * speed whole pixels per second, which makes velocity * Fixed time a
+  Fixed distance and Fixed distance / velocity a Fixed time, both without
+  leaving 32 bits. Ball and paddle sizes are the court's constants.
+*/
+typedef struct FixedBall FixedBall;
+struct FixedBall {
+  int speed;
+  int dx;
+  int dy;
+  Fixed x;
+  Fixed y;
+  int fudge;
+  int paddle_segment;
+  Fixed time_step;
+  bool predicted;
+  Fixed player_target_y;
+  Fixed robot_target_y;
+};
+
+typedef struct FixedPaddle FixedPaddle;
+struct FixedPaddle {
+  Player owner;
+  int speed;
+  int dy;
+  Fixed time_step;
+  Fixed x;
+  Fixed y;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Round a double to the nearest fixed point value. Values
+    that came from fixed point convert back exactly.
+    Parameters:
+      double value: value to convert
+    Returns: Fixed value
+    ---------------------------------------------------------------------- */
+Fixed fixed_from_double(double value);
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point value to a double, exactly
+    Parameters:
+      Fixed value: value to convert
+    Returns: double value
+    ---------------------------------------------------------------------- */
+double fixed_to_double(Fixed value);
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a ball to fixed point
+    Parameters:
+      FixedBall* fixed: receives the fixed point ball
+      Ball* ball: game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_load_ball(FixedBall* fixed, Ball* ball);
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point ball back into a game ball
+    Parameters:
+      Ball* ball: game ball, its sizes are kept
+      FixedBall* fixed: fixed point ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_store_ball(Ball* ball, FixedBall* fixed);
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a paddle to fixed point
+    Parameters:
+      FixedPaddle* fixed: receives the fixed point paddle
+      Paddle* paddle: game paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_load_paddle(FixedPaddle* fixed, Paddle* paddle);
+
+/*  ----------------------------------------------------------------------
+    Description: Convert a fixed point paddle back into a game paddle
+    Parameters:
+      Paddle* paddle: game paddle, its sizes are kept
+      FixedPaddle* fixed: fixed point paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_store_paddle(Paddle* paddle, FixedPaddle* fixed);
+
+/*  ----------------------------------------------------------------------
+    Description: predict_ball() in fixed point. The unfolded course is
+    worked out in 64 bit integers, so there is no fmod() to round.
+    Parameters:
+      FixedBall* ball: the game ball
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_predict_ball(FixedBall* ball);
+
+/*  ----------------------------------------------------------------------
+    Description: update_player() in fixed point
+    Parameters:
+      FixedBall* ball: the game ball
+      FixedPaddle* paddle: the paddle object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_update_player(FixedBall* ball, FixedPaddle* paddle);
+
+/*  ----------------------------------------------------------------------
+    Description: move_paddle() in fixed point
+    Parameters:
+      FixedPaddle* paddle: pointer to the paddle
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_move_paddle(FixedPaddle* paddle);
+
+/*  ----------------------------------------------------------------------
+    Description: move_ball() in fixed point. The time to the wall is
+    truncated, so the ball never passes it before it bounces.
+    Parameters:
+      FixedBall* ball: pointer to the game ball object
+    Returns: true if the ball rebounded from a wall
+    ---------------------------------------------------------------------- */
+bool fixed_move_ball(FixedBall* ball);
+
+/*  ----------------------------------------------------------------------
+    Description: check_collision() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to game ball object
+      FixedPaddle* paddle: pointer to the paddle
+      Rng* rng: random number generator of the game
+    Returns: true if the ball rebounded from the paddle
+    ---------------------------------------------------------------------- */
+bool fixed_check_collision(FixedBall* ball, FixedPaddle* paddle, Rng* rng);
+
+/*  ----------------------------------------------------------------------
+    Description: apply_english() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to game ball object
+      FixedPaddle* paddle: pointer to the paddle
+      Rng* rng: random number generator of the game
+    Returns: none
+    ---------------------------------------------------------------------- */
+void fixed_apply_english(FixedBall* ball, FixedPaddle* paddle, Rng* rng);
+
+/*  ----------------------------------------------------------------------
+    Description: sweep_ball() in fixed point
+    Parameters:
+      FixedBall* ball: pointer to the game ball object
+      FixedPaddle* player: pointer to the player paddle
+      FixedPaddle* robot: pointer to the robot paddle
+      Rng* rng: random number generator of the game
+      EventBuffer* events: receives the rebounds, or NULL
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int fixed_sweep_ball(FixedBall* ball, FixedPaddle* player,
+  FixedPaddle* robot, Rng* rng, EventBuffer* events);
+
+/*  ----------------------------------------------------------------------
+    Description: The movement part of step_match() in fixed point, for
+    matches with fixed_point set: the AI paddle updates, paddle movement
+    and the ball's sweep, whose rebounds go into the match's events. The
+    match's ball and paddles are converted to fixed point, stepped and
+    stored back; since they only ever hold values that came from fixed
+    point, the conversions are exact, and the result is the same on every
+    compiler, CPU and floating point mode. The time step is rounded to a
+    fixed tick of whole 1/65536ths of a second.
+    Parameters:
+      Match* match: pointer to the Match object
+      double time_step: elapsed time in seconds to simulate, at most
+      FIXED_MAX_TIME_STEP
+    Returns: number of paddle rebounds
+    ---------------------------------------------------------------------- */
+int fixed_step(Match* match, double time_step);
+
+#endif
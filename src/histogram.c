@@ -0,0 +1,125 @@
+// HDR-style log-linear histogram
+#include "histogram.h"
+#include <math.h>
+#include <string.h>
+
+#define HISTOGRAM_MAX_VALUE ((((Uint64)1) << HISTOGRAM_MAX_BITS) - 1)
+
+/*  ----------------------------------------------------------------------
+    Map a value to its bucket. Values with their highest set bit at
+    position b >= HISTOGRAM_SUB_BITS keep their top HISTOGRAM_SUB_BITS bits.
+    ---------------------------------------------------------------------- */
+static int bucket_index(Uint64 value) {
+  if (value < HISTOGRAM_SUB_COUNT) {
+    return (int)value;
+  }
+  int shift = 1;
+  while ((value >> shift) >= HISTOGRAM_SUB_COUNT) {
+    shift++;
+  }
+  return HISTOGRAM_SUB_COUNT + (shift - 1) * HISTOGRAM_HALF_COUNT +
+    (int)(value >> shift) - HISTOGRAM_HALF_COUNT;
+}
+
+/*  ----------------------------------------------------------------------
+    Largest value that maps to the given bucket
+    ---------------------------------------------------------------------- */
+static Uint64 bucket_upper(int index) {
+  if (index < HISTOGRAM_SUB_COUNT) {
+    return index;
+  }
+  int shift = (index - HISTOGRAM_SUB_COUNT) / HISTOGRAM_HALF_COUNT + 1;
+  Uint64 top = (index - HISTOGRAM_SUB_COUNT) % HISTOGRAM_HALF_COUNT +
+    HISTOGRAM_HALF_COUNT;
+  return ((top + 1) << shift) - 1;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Empty a histogram
+    Parameters:
+      Histogram* hist: pointer to the histogram
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_reset(Histogram* hist) {
+  memset(hist, 0, sizeof(Histogram));
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Count one value
+    Parameters:
+      Histogram* hist: pointer to the histogram
+      Uint64 value: value to count, clamped to the trackable range
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_record(Histogram* hist, Uint64 value) {
+  if (value > HISTOGRAM_MAX_VALUE) {
+    value = HISTOGRAM_MAX_VALUE;
+  }
+  if (hist->count == 0 || value < hist->min) {
+    hist->min = value;
+  }
+  if (value > hist->max) {
+    hist->max = value;
+  }
+  hist->count++;
+  hist->total += value;
+  hist->buckets[bucket_index(value)]++;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Find the value at a percentile. Exact for values below
+    HISTOGRAM_SUB_COUNT, otherwise the upper bound of the bucket holding it.
+    The maximum is always exact.
+    Parameters:
+      Histogram* hist: pointer to the histogram
+      double percentile: 0 to 100
+    Returns: value at or below which the given percentage of the counted
+    values lie, 0 if the histogram is empty
+    ---------------------------------------------------------------------- */
+Uint64 histogram_percentile(Histogram* hist, double percentile) {
+  if (hist->count == 0) {
+    return 0;
+  }
+  // rank of the value we are looking for, 1 based
+  Uint64 rank = (Uint64)ceil(percentile / 100 * hist->count);
+  if (rank < 1) {
+    rank = 1;
+  }
+  if (rank >= hist->count) {
+    return hist->max;
+  }
+
+  Uint64 seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= rank) {
+      Uint64 upper = bucket_upper(i);
+      return upper < hist->max ? upper : hist->max;
+    }
+  }
+  return hist->max;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Add all counts of one histogram to another
+    Parameters:
+      Histogram* total: pointer to the histogram to add to
+      Histogram* hist: pointer to the histogram to add
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_add(Histogram* total, Histogram* hist) {
+  if (hist->count == 0) {
+    return;
+  }
+  if (total->count == 0 || hist->min < total->min) {
+    total->min = hist->min;
+  }
+  if (hist->max > total->max) {
+    total->max = hist->max;
+  }
+  total->count += hist->count;
+  total->total += hist->total;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    total->buckets[i] += hist->buckets[i];
+  }
+}
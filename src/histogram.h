@@ -0,0 +1,70 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// values below 2^HISTOGRAM_SUB_BITS are counted exactly, larger values in
+// 2^(HISTOGRAM_SUB_BITS - 1) linear steps per power of two (< 1.6% error)
+#define HISTOGRAM_SUB_BITS 7
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_HALF_COUNT (HISTOGRAM_SUB_COUNT / 2)
+// largest trackable value is 2^HISTOGRAM_MAX_BITS - 1, larger ones clamp
+#define HISTOGRAM_MAX_BITS 40
+#define HISTOGRAM_BUCKETS \
+  (HISTOGRAM_SUB_COUNT + \
+  (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS) * HISTOGRAM_HALF_COUNT)
+
+/*
+  HDR-style log-linear histogram of non-negative integer values, e.g.
+  frame times in microseconds. Recording is constant time and the
+  relative precision of percentiles is the same for short and long values.
+*/
+typedef struct Histogram Histogram;
+struct Histogram {
+  Uint64 count;
+  Uint64 total;
+  Uint64 min;
+  Uint64 max;
+  Uint64 buckets[HISTOGRAM_BUCKETS];
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Empty a histogram
+    Parameters:
+      Histogram* hist: pointer to the histogram
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_reset(Histogram* hist);
+
+/*  ----------------------------------------------------------------------
+    Description: Count one value
+    Parameters:
+      Histogram* hist: pointer to the histogram
+      Uint64 value: value to count, clamped to the trackable range
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_record(Histogram* hist, Uint64 value);
+
+/*  ----------------------------------------------------------------------
+    Description: Find the value at a percentile. Exact for values below
+    HISTOGRAM_SUB_COUNT, otherwise the upper bound of the bucket holding it.
+    The maximum is always exact.
+    Parameters:
+      Histogram* hist: pointer to the histogram
+      double percentile: 0 to 100
+    Returns: value at or below which the given percentage of the counted
+    values lie, 0 if the histogram is empty
+    ---------------------------------------------------------------------- */
+Uint64 histogram_percentile(Histogram* hist, double percentile);
+
+/*  ----------------------------------------------------------------------
+    Description: Add all counts of one histogram to another
+    Parameters:
+      Histogram* total: pointer to the histogram to add to
+      Histogram* hist: pointer to the histogram to add
+    Returns: none
+    ---------------------------------------------------------------------- */
+void histogram_add(Histogram* total, Histogram* hist);
+
+#endif
@@ -0,0 +1,93 @@
+// Background loading of fonts and sounds at startup
+#include "pong.h"
+#include "loader.h"
+
+/*  ----------------------------------------------------------------------
+    Loader thread: load the fonts, open the audio device and synthesize
+    the sounds, then publish them by setting ready
+    ---------------------------------------------------------------------- */
+static int load_assets(void* data) {
+  Loader* loader = data;
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  if (TTF_Init() == -1) {
+    SDL_LogCritical(LOGCAT,
+      "SDL_ttf could not initialize! SDL_ttf Error: %s\n",
+      TTF_GetError());
+  } else {
+    loader->score_font = load_font("VT323-Regular.ttf", SCORE_FONT_SIZE);
+    loader->stats_font =
+      load_font("Inconsolata-Regular.ttf", STATS_FONT_SIZE);
+  }
+
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+    SDL_LogError(LOGCAT, "Could not initialize audio: %s", SDL_GetError());
+  } else if (sound_open(loader->audio_buffer)) {
+    loader->paddle_sound = sound_beep(SOUND_PADDLE_HZ, SOUND_PADDLE_MS);
+    loader->wall_sound = sound_beep(SOUND_WALL_HZ, SOUND_WALL_MS);
+    loader->point_sound = sound_beep(SOUND_POINT_HZ, SOUND_POINT_MS);
+  }
+
+  loader->elapsed = SDL_GetPerformanceCounter() - start;
+  // the atomic store orders the writes above before the main thread's
+  // reads after loader_ready()
+  SDL_AtomicSet(&loader->ready, 1);
+  return 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Start loading the fonts and sounds on a background
+    thread. If the thread can't be started, they are loaded before
+    returning.
+    Parameters:
+      int audio_buffer: audio buffer size in sample frames
+    Returns: Loader* pointer to the new loader, or NULL on failure
+    ---------------------------------------------------------------------- */
+Loader* loader_start(int audio_buffer) {
+  Loader* loader = calloc(1, sizeof(Loader));
+  if (loader == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate the asset loader");
+    return NULL;
+  }
+  loader->audio_buffer = audio_buffer;
+  SDL_AtomicSet(&loader->ready, 0);
+
+  loader->thread = SDL_CreateThread(load_assets, "loader", loader);
+  if (loader->thread == NULL) {
+    SDL_LogWarn(LOGCAT, "Failed to start the asset loader: %s",
+      SDL_GetError());
+    load_assets(loader);
+  }
+  return loader;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Check without blocking whether the loader has finished.
+    Once it returns true the loader's fields may be read and taken.
+    Parameters:
+      Loader* loader: pointer to the loader, NULL is never ready
+    Returns: true if loading is done
+    ---------------------------------------------------------------------- */
+bool loader_ready(Loader* loader) {
+  return loader != NULL && SDL_AtomicGet(&loader->ready) != 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Wait for the loader thread, free the fonts and sounds
+    that were not taken, and free the loader
+    Parameters:
+      Loader* loader: pointer to the loader, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void loader_destroy(Loader* loader) {
+  if (loader == NULL) {
+    return;
+  }
+  SDL_WaitThread(loader->thread, NULL);
+  TTF_CloseFont(loader->score_font);
+  TTF_CloseFont(loader->stats_font);
+  Mix_FreeChunk(loader->paddle_sound);
+  Mix_FreeChunk(loader->wall_sound);
+  Mix_FreeChunk(loader->point_sound);
+  free(loader);
+}
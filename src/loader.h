@@ -0,0 +1,61 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <SDL_mixer.h>
+#include <stdbool.h>
+
+/*
+  Startup assets loaded on a background thread, so the window can show
+  its first frame while they load. The thread initializes SDL_ttf and
+  opens the fonts, then initializes the audio subsystem, opens the audio
+  device and synthesizes the sound effects. The main thread checks
+  loader_ready() each frame and, once it is true, takes the fonts and
+  sounds (setting the fields it took to NULL) and builds the glyph
+  atlases itself, as the renderer may only be used from the main thread.
+  Nothing else may use SDL_ttf or SDL_mixer until the loader is ready.
+*/
+typedef struct Loader Loader;
+struct Loader {
+  SDL_Thread* thread;
+  SDL_atomic_t ready;
+  int audio_buffer;
+  // performance counter ticks the loader took
+  Uint64 elapsed;
+  TTF_Font* score_font;
+  TTF_Font* stats_font;
+  Mix_Chunk* paddle_sound;
+  Mix_Chunk* wall_sound;
+  Mix_Chunk* point_sound;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Start loading the fonts and sounds on a background
+    thread. If the thread can't be started, they are loaded before
+    returning.
+    Parameters:
+      int audio_buffer: audio buffer size in sample frames
+    Returns: Loader* pointer to the new loader, or NULL on failure
+    ---------------------------------------------------------------------- */
+Loader* loader_start(int audio_buffer);
+
+/*  ----------------------------------------------------------------------
+    Description: Check without blocking whether the loader has finished.
+    Once it returns true the loader's fields may be read and taken.
+    Parameters:
+      Loader* loader: pointer to the loader, NULL is never ready
+    Returns: true if loading is done
+    ---------------------------------------------------------------------- */
+bool loader_ready(Loader* loader);
+
+/*  ----------------------------------------------------------------------
+    Description: Wait for the loader thread, free the fonts and sounds
+    that were not taken, and free the loader
+    Parameters:
+      Loader* loader: pointer to the loader, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void loader_destroy(Loader* loader);
+
+#endif
@@ -0,0 +1,703 @@
+// Two-player matches over UDP with rollback
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "sockets.h"
+#include "net.h"
+#include <string.h>
+
+// packet types, after the two magic bytes
+#define NET_HELLO 1
+#define NET_WELCOME 2
+#define NET_INPUTS 3
+
+// WELCOME: magic, type, seed, sim_hz and flags
+#define NET_WELCOME_SIZE 14
+#define NET_FIXED_POINT 1
+
+// INPUTS header: magic, type, tick, advantage, ack, start, count,
+// check tick and check hash, followed by count inputs
+#define NET_INPUTS_HEADER 29
+
+static void put_u16(Uint8* p, Uint16 value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static void put_u32(Uint8* p, Uint32 value) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+static void put_u64(Uint8* p, Uint64 value) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+static Uint16 get_u16(const Uint8* p) {
+  return (Uint16)(p[0] | p[1] << 8);
+}
+
+static Uint32 get_u32(const Uint8* p) {
+  Uint32 value = 0;
+  for (int i = 3; i >= 0; i--) {
+    value = value << 8 | p[i];
+  }
+  return value;
+}
+
+static Uint64 get_u64(const Uint8* p) {
+  Uint64 value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = value << 8 | p[i];
+  }
+  return value;
+}
+
+/*  ----------------------------------------------------------------------
+    Open a non-blocking UDP socket bound to a local port and allocate the
+    connection around it, with the configuration clamped to its limits
+    ---------------------------------------------------------------------- */
+static Net* net_open(int port, NetConfig* config) {
+  if (!sockets_start()) {
+    SDL_LogError(LOGCAT, "Failed to start networking");
+    return NULL;
+  }
+  Socket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == INVALID_SOCKET) {
+    SDL_LogError(LOGCAT, "Failed to open a UDP socket");
+    return NULL;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons((Uint16)port);
+  if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    SDL_LogError(LOGCAT, "Failed to bind UDP port %d", port);
+    closesocket(s);
+    return NULL;
+  }
+  Net* net = socket_set_nonblocking(s) ? calloc(1, sizeof(Net)) : NULL;
+  if (net == NULL) {
+    SDL_LogError(LOGCAT, "Failed to set up the network connection");
+    closesocket(s);
+    return NULL;
+  }
+
+  net->socket = (Uint64)s;
+  net->config = *config;
+  if (net->config.input_delay < 0) {
+    net->config.input_delay = 0;
+  } else if (net->config.input_delay > NET_MAX_INPUT_DELAY) {
+    net->config.input_delay = NET_MAX_INPUT_DELAY;
+  }
+  if (net->config.rollback < 1) {
+    net->config.rollback = 1;
+  } else if (net->config.rollback > NET_MAX_ROLLBACK) {
+    net->config.rollback = NET_MAX_ROLLBACK;
+  }
+  // the first input_delay ticks have no input on either side
+  net->local_known = net->config.input_delay;
+  net->next_check = NET_CHECK_INTERVAL;
+  rng_seed(&net->link_rng, SDL_GetPerformanceCounter() ^ (Uint64)port);
+  return net;
+}
+
+static void send_now(Net* net, const Uint8* data, int size) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(net->peer_ip);
+  addr.sin_port = htons(net->peer_port);
+  if (sendto((Socket)net->socket, (const char*)data, size, 0,
+    (struct sockaddr*)&addr, sizeof(addr)) == size) {
+    net->sent++;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Send a packet to the peer through the simulated link: dropped with
+    the configured loss, otherwise held back for the latency plus a
+    random jitter, which also reorders packets
+    ---------------------------------------------------------------------- */
+static void send_packet(Net* net, const Uint8* data, int size) {
+  if (net->config.loss > 0 &&
+    rng_int(&net->link_rng, 10000) < (int)(net->config.loss * 100)) {
+    net->dropped++;
+    return;
+  }
+  if (net->config.latency <= 0 && net->config.jitter <= 0) {
+    send_now(net, data, size);
+    return;
+  }
+  if (net->link_count == NET_LINK_QUEUE) {
+    net->dropped++;
+    return;
+  }
+  NetPacket* packet = &net->link[net->link_count++];
+  int jitter = net->config.jitter > 0 ?
+    rng_int(&net->link_rng, net->config.jitter + 1) : 0;
+  packet->due = net->now + net->config.latency + jitter;
+  packet->size = size;
+  memcpy(packet->data, data, size);
+}
+
+// send the held back packets that are due
+static void flush_link(Net* net) {
+  for (int i = 0; i < net->link_count;) {
+    NetPacket* packet = &net->link[i];
+    if ((Sint32)(net->now - packet->due) >= 0) {
+      send_now(net, packet->data, packet->size);
+      *packet = net->link[--net->link_count];
+    } else {
+      i++;
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Save the state before the game's next tick, with its hash
+    ---------------------------------------------------------------------- */
+static void save_state(NetState* state, Game* game) {
+  state->tick = game->sim_ticks;
+  state->hash = hash_match(&game->match);
+  state->match = game->match;
+}
+
+/*  ----------------------------------------------------------------------
+    Restore a saved state
+    ---------------------------------------------------------------------- */
+static void load_state(Game* game, NetState* state) {
+  game->sim_ticks = state->tick;
+  game->match = state->match;
+}
+
+static void set_paddle_input(Paddle* paddle, Uint8 input) {
+  paddle->dy = 0;
+  if (input & NET_INPUT_UP) {
+    paddle->dy -= paddle->speed;
+  }
+  if (input & NET_INPUT_DOWN) {
+    paddle->dy += paddle->speed;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Save the state, then simulate the next tick with the inputs of both
+    sides, predicting the remote one if it hasn't arrived: the last known
+    input, without its start press
+    ---------------------------------------------------------------------- */
+static void simulate_tick(Net* net, Game* game, double sim_step) {
+  Uint64 tick = game->sim_ticks;
+  save_state(&net->states[tick % NET_RING], game);
+
+  Uint8 local = net->local_inputs[tick % NET_RING];
+  Uint8 remote = 0;
+  if (tick < net->remote_known) {
+    remote = net->remote_inputs[tick % NET_RING];
+  } else if (net->remote_known > 0) {
+    remote = net->remote_inputs[(net->remote_known - 1) % NET_RING] &
+      ~NET_INPUT_START;
+  }
+  net->used_remote[tick % NET_RING] = remote;
+
+  Uint8 player = net->hosting ? local : remote;
+  Uint8 robot = net->hosting ? remote : local;
+  if (game->match.idle && ((player | robot) & NET_INPUT_START)) {
+    reset_match(&game->match);
+    game->match.idle = false;
+  }
+  set_paddle_input(&game->match.player, player);
+  set_paddle_input(&game->match.robot, robot);
+  tick_game(game, sim_step);
+}
+
+/*  ----------------------------------------------------------------------
+    Restore the state before the earliest mispredicted tick and simulate
+    forward again to the current tick, without sounds
+    ---------------------------------------------------------------------- */
+static void roll_back(Net* net, Game* game, double sim_step) {
+  net->rollback_pending = false;
+  Uint64 target = game->sim_ticks;
+  Uint64 from = net->rollback_tick;
+  NetState* state = &net->states[from % NET_RING];
+  if (from >= target || state->tick != from) {
+    return;
+  }
+
+  Mix_Chunk* wall_sound = game->wall_sound;
+  Mix_Chunk* paddle_sound = game->paddle_sound;
+  Mix_Chunk* point_sound = game->point_sound;
+  game->wall_sound = NULL;
+  game->paddle_sound = NULL;
+  game->point_sound = NULL;
+
+  load_state(game, state);
+  while (game->sim_ticks < target) {
+    simulate_tick(net, game, sim_step);
+  }
+  snap_interpolation(game);
+
+  game->wall_sound = wall_sound;
+  game->paddle_sound = paddle_sound;
+  game->point_sound = point_sound;
+
+  net->rollbacks++;
+  net->rollback_ticks += target - from;
+  if (target - from > net->max_rollback) {
+    net->max_rollback = target - from;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Take the peer's inputs in order, flag a rollback for any that differ
+    from what was predicted, and note its tick, acknowledgement and
+    latest state hash
+    ---------------------------------------------------------------------- */
+static void read_inputs(Net* net, Game* game, const Uint8* data, int size) {
+  if (size < NET_INPUTS_HEADER || size < NET_INPUTS_HEADER + data[16]) {
+    return;
+  }
+  Uint32 tick = get_u32(data + 3);
+  if (tick >= net->remote_tick) {
+    net->remote_tick = tick;
+    net->remote_advantage = (Sint8)data[7];
+  }
+  Uint32 ack = get_u32(data + 8);
+  if (ack > net->remote_acked && ack <= net->local_known) {
+    net->remote_acked = ack;
+  }
+
+  Uint32 start = get_u32(data + 12);
+  for (int i = 0; i < data[16]; i++) {
+    Uint64 t = (Uint64)start + i;
+    // in order only, and never overwrite a tick still waiting in the ring
+    if (t != net->remote_known || t >= game->sim_ticks + NET_RING / 2) {
+      continue;
+    }
+    Uint8 input = data[NET_INPUTS_HEADER + i];
+    net->remote_inputs[t % NET_RING] = input;
+    net->remote_known++;
+    if (t < game->sim_ticks && input != net->used_remote[t % NET_RING] &&
+      (!net->rollback_pending || t < net->rollback_tick)) {
+      net->rollback_pending = true;
+      net->rollback_tick = t;
+    }
+  }
+
+  Uint32 check_tick = get_u32(data + 17);
+  if (check_tick > net->remote_check_tick) {
+    net->remote_check_tick = check_tick;
+    net->remote_check_hash = get_u64(data + 21);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Read every waiting packet. The host takes the first guest that says
+    hello and welcomes it with the seed, rate and physics, again for every
+    hello in case the welcome was lost. Inputs are only read with a game.
+    ---------------------------------------------------------------------- */
+static void receive_packets(Net* net, Game* game) {
+  Uint8 data[NET_MAX_PACKET];
+  for (;;) {
+    struct sockaddr_in from;
+    socklen_t from_size = sizeof(from);
+    int size = recvfrom((Socket)net->socket, (char*)data, sizeof(data), 0,
+      (struct sockaddr*)&from, &from_size);
+    if (size < 0) {
+      break;
+    }
+    if (size < 3 || data[0] != 'P' || data[1] != 'N') {
+      continue;
+    }
+    Uint32 ip = ntohl(from.sin_addr.s_addr);
+    Uint16 port = ntohs(from.sin_port);
+    if (net->hosting && !net->connected && data[2] == NET_HELLO) {
+      net->peer_ip = ip;
+      net->peer_port = port;
+      net->connected = true;
+      SDL_LogInfo(LOGCAT, "Guest joined from %s:%d",
+        inet_ntoa(from.sin_addr), port);
+    }
+    if (ip != net->peer_ip || port != net->peer_port) {
+      continue;
+    }
+    net->received++;
+
+    if (net->hosting && data[2] == NET_HELLO) {
+      Uint8 welcome[NET_WELCOME_SIZE] = { 'P', 'N', NET_WELCOME };
+      put_u64(welcome + 3, net->seed);
+      put_u16(welcome + 11, (Uint16)net->sim_hz);
+      welcome[13] = net->fixed_point ? NET_FIXED_POINT : 0;
+      send_packet(net, welcome, sizeof(welcome));
+    } else if (!net->hosting && data[2] == NET_WELCOME &&
+      size >= NET_WELCOME_SIZE) {
+      if (!net->connected) {
+        net->seed = get_u64(data + 3);
+        net->sim_hz = get_u16(data + 11);
+        net->fixed_point = (data[13] & NET_FIXED_POINT) != 0;
+        net->connected = true;
+        SDL_LogInfo(LOGCAT, "Joined the host, seed %llu at %d Hz%s",
+          (unsigned long long)net->seed, net->sim_hz,
+          net->fixed_point ? ", fixed point" : "");
+      }
+    } else if (data[2] == NET_INPUTS && game != NULL) {
+      read_inputs(net, game, data, size);
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Send the local inputs the peer hasn't acknowledged, along with our
+    tick, lead, acknowledgement and latest confirmed state hash
+    ---------------------------------------------------------------------- */
+static void send_inputs(Net* net, Game* game) {
+  Uint8 data[NET_INPUTS_HEADER + NET_MAX_INPUTS] = { 'P', 'N', NET_INPUTS };
+  Uint64 start = net->remote_acked;
+  Uint64 count = net->local_known - start;
+  if (count > NET_MAX_INPUTS) {
+    count = NET_MAX_INPUTS;
+  }
+  Sint64 advantage = (Sint64)game->sim_ticks - (Sint64)net->remote_tick;
+  advantage = advantage > 127 ? 127 : advantage < -127 ? -127 : advantage;
+
+  Uint64 check_tick = 0;
+  Uint64 check_hash = 0;
+  if (net->next_check > NET_CHECK_INTERVAL) {
+    Uint64 tick = net->next_check - NET_CHECK_INTERVAL;
+    int slot = (tick / NET_CHECK_INTERVAL) % NET_CHECKS;
+    if (net->check_ticks[slot] == tick) {
+      check_tick = tick;
+      check_hash = net->check_hashes[slot];
+    }
+  }
+
+  put_u32(data + 3, (Uint32)game->sim_ticks);
+  data[7] = (Uint8)(Sint8)advantage;
+  put_u32(data + 8, (Uint32)net->remote_known);
+  put_u32(data + 12, (Uint32)start);
+  data[16] = (Uint8)count;
+  put_u32(data + 17, (Uint32)check_tick);
+  put_u64(data + 21, check_hash);
+  for (Uint64 i = 0; i < count; i++) {
+    data[NET_INPUTS_HEADER + i] = net->local_inputs[(start + i) % NET_RING];
+  }
+  send_packet(net, data, NET_INPUTS_HEADER + (int)count);
+}
+
+/*  ----------------------------------------------------------------------
+    Record the hashes of saved states whose inputs are now confirmed on
+    both sides, and compare the peer's latest one with ours
+    ---------------------------------------------------------------------- */
+static void check_states(Net* net, Game* game) {
+  while (net->next_check < game->sim_ticks &&
+    net->next_check < net->remote_known) {
+    NetState* state = &net->states[net->next_check % NET_RING];
+    if (state->tick == net->next_check) {
+      int slot = (net->next_check / NET_CHECK_INTERVAL) % NET_CHECKS;
+      net->check_ticks[slot] = net->next_check;
+      net->check_hashes[slot] = state->hash;
+    }
+    net->next_check += NET_CHECK_INTERVAL;
+  }
+
+  Uint64 tick = net->remote_check_tick;
+  int slot = (tick / NET_CHECK_INTERVAL) % NET_CHECKS;
+  if (tick > net->compared_tick && net->check_ticks[slot] == tick) {
+    net->compared_tick = tick;
+    net->checks++;
+    if (net->check_hashes[slot] != net->remote_check_hash) {
+      if (net->desyncs == 0) {
+        SDL_LogError(LOGCAT, "Desync with the peer at tick %llu",
+          (unsigned long long)tick);
+      }
+      net->desyncs++;
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Listen for a guest on a UDP port. The host decides the
+    seed, simulation rate and physics and plays the player paddle.
+    Parameters:
+      int port: UDP port to listen on, 0 for any free port
+      Uint64 seed: seed of the match
+      int sim_hz: simulation steps per second
+      bool fixed_point: the match runs fixed point physics
+      NetConfig* config: input delay, rollback depth and link impairments
+    Returns: Net* pointer to the new connection, or NULL on failure
+    ---------------------------------------------------------------------- */
+Net* net_host(int port, Uint64 seed, int sim_hz, bool fixed_point,
+  NetConfig* config) {
+  Net* net = net_open(port, config);
+  if (net == NULL) {
+    return NULL;
+  }
+  net->hosting = true;
+  net->side = PLAYER;
+  net->seed = seed;
+  net->sim_hz = sim_hz;
+  net->fixed_point = fixed_point;
+  SDL_LogInfo(LOGCAT, "Hosting on UDP port %d",
+    socket_local_port((Socket)net->socket));
+  return net;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Join a host. The guest plays the robot paddle and takes
+    the seed, simulation rate and physics from the host when connected.
+    Parameters:
+      const char* address: host as HOST:PORT, or HOST for NET_PORT
+      NetConfig* config: input delay, rollback depth and link impairments
+    Returns: Net* pointer to the new connection, or NULL on failure
+    ---------------------------------------------------------------------- */
+Net* net_join(const char* address, NetConfig* config) {
+  Uint32 ip = 0;
+  Uint16 port = 0;
+  if (!socket_resolve(address, NET_PORT, &ip, &port)) {
+    return NULL;
+  }
+  Net* net = net_open(0, config);
+  if (net == NULL) {
+    return NULL;
+  }
+  net->peer_ip = ip;
+  net->peer_port = port;
+  net->side = ROBOT;
+  // say hello on the first call to net_connect()
+  net->last_hello = SDL_GetTicks() - NET_HELLO_MS;
+  return net;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Make progress on connecting without blocking: the guest
+    says hello every NET_HELLO_MS, the host answers with the seed,
+    simulation rate and physics
+    Parameters:
+      Net* net: pointer to the connection
+      Uint32 now: current time in milliseconds
+    Returns: true once connected
+    ---------------------------------------------------------------------- */
+bool net_connect(Net* net, Uint32 now) {
+  net->now = now;
+  if (!net->hosting && !net->connected &&
+    now - net->last_hello >= NET_HELLO_MS) {
+    Uint8 hello[3] = { 'P', 'N', NET_HELLO };
+    send_packet(net, hello, sizeof(hello));
+    net->last_hello = now;
+  }
+  receive_packets(net, NULL);
+  flush_link(net);
+  return net->connected;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Sample the local player's input from the keyboard: the
+    arrow keys move the paddle and space starts the match
+    Parameters: none
+    Returns: NET_INPUT_* bits
+    ---------------------------------------------------------------------- */
+Uint8 net_local_input(void) {
+  const Uint8* keys = SDL_GetKeyboardState(NULL);
+  Uint8 input = 0;
+  if (keys[SDL_SCANCODE_UP]) {
+    input |= NET_INPUT_UP;
+  }
+  if (keys[SDL_SCANCODE_DOWN]) {
+    input |= NET_INPUT_DOWN;
+  }
+  if (keys[SDL_SCANCODE_SPACE]) {
+    input |= NET_INPUT_START;
+  }
+  return input;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Advance a network match by one tick: receive packets,
+    roll back and simulate forward again if a remote input was
+    mispredicted, then send the local input and simulate the next tick,
+    unless the game has to wait for the peer
+    Parameters:
+      Net* net: pointer to the connection
+      Game* game: pointer to the Game object, started with new_game()
+      from the connection's seed and with its fixed_point
+      Uint8 input: local NET_INPUT_* bits for input_delay ticks ahead
+      double sim_step: fixed simulation step in seconds
+      Uint32 now: current time in milliseconds
+    Returns: true if a tick was simulated, false if stalled
+    ---------------------------------------------------------------------- */
+bool net_advance(Net* net, Game* game, Uint8 input, double sim_step,
+  Uint32 now) {
+  net->now = now;
+  receive_packets(net, game);
+  if (net->rollback_pending) {
+    roll_back(net, game, sim_step);
+  }
+  check_states(net, game);
+
+  Uint64 tick = game->sim_ticks;
+  // too far ahead of the peer's inputs, or of its acknowledgements
+  bool stall = tick >= net->remote_known + net->config.rollback ||
+    net->local_known - net->remote_acked >= NET_MAX_INPUTS;
+  // both sides see the same gap the other way round, latency cancels
+  // out: the one ahead waits a tick at a time to close half of it
+  int advantage = (int)((Sint64)tick - (Sint64)net->remote_tick);
+  net->sync_gap += NET_SYNC_SMOOTHING *
+    (advantage - net->remote_advantage - net->sync_gap);
+  if (!stall && tick >= net->last_sync + NET_SYNC_INTERVAL &&
+    net->sync_gap / 2 >= 1) {
+    stall = true;
+    net->sync_stalls++;
+    net->last_sync = tick;
+  }
+  if (stall) {
+    net->stalls++;
+    send_inputs(net, game);
+    flush_link(net);
+    return false;
+  }
+
+  net->local_inputs[net->local_known % NET_RING] = input;
+  net->local_known++;
+  send_inputs(net, game);
+  simulate_tick(net, game, sim_step);
+  net->ticks++;
+  flush_link(net);
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Log the rollback, stall, packet and desync counts, close
+    the socket and free the connection
+    Parameters:
+      Net* net: pointer to the connection, NULL is ignored
+      const char* label: name of this side in the log
+    Returns: none
+    ---------------------------------------------------------------------- */
+void net_close(Net* net, const char* label) {
+  if (net == NULL) {
+    return;
+  }
+  if (label != NULL && net->connected) {
+    SDL_LogInfo(LOGCAT,
+      "%s: %llu ticks, %llu rollbacks of %.1f ticks average (%llu max), "
+      "%llu stalls (%llu for time sync), %llu packets sent, %llu received, "
+      "%llu dropped, %llu state checks, %llu desyncs",
+      label, (unsigned long long)net->ticks,
+      (unsigned long long)net->rollbacks,
+      net->rollbacks > 0 ? (double)net->rollback_ticks / net->rollbacks : 0.0,
+      (unsigned long long)net->max_rollback,
+      (unsigned long long)net->stalls, (unsigned long long)net->sync_stalls,
+      (unsigned long long)net->sent, (unsigned long long)net->received,
+      (unsigned long long)net->dropped, (unsigned long long)net->checks,
+      (unsigned long long)net->desyncs);
+  }
+  closesocket((Socket)net->socket);
+  free(net);
+}
+
+/*  ----------------------------------------------------------------------
+    Random test input: hold a direction for a while, and press start now
+    and then, which begins a match when idle
+    ---------------------------------------------------------------------- */
+static Uint8 random_input(Rng* rng, Uint8* held) {
+  if (rng_int(rng, 15) == 0) {
+    *held = (Uint8)rng_int(rng, (NET_INPUT_UP | NET_INPUT_DOWN) + 1);
+  }
+  Uint8 input = *held;
+  if (rng_int(rng, 240) == 0) {
+    input |= NET_INPUT_START;
+  }
+  return input;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Test harness: play a host and a guest against each other
+    over loopback UDP in one process, with the configured latency, jitter
+    and loss on both links and random inputs, on a simulated clock as
+    fast as possible. Logs the rollbacks and stalls of both sides and
+    checks that their states agree.
+    Parameters:
+      NetConfig* config: input delay, rollback depth and link impairments
+      double seconds: seconds of play to simulate
+      Uint64 seed: seed of the match and the inputs
+      int sim_hz: simulation steps per second
+      bool fixed_point: run fixed point physics
+    Returns: true if both sides compared states and never disagreed
+    ---------------------------------------------------------------------- */
+bool run_net_test(NetConfig* config, double seconds, Uint64 seed, int sim_hz,
+  bool fixed_point) {
+  Net* nets[2] = { net_host(0, seed, sim_hz, fixed_point, config), NULL };
+  if (nets[0] == NULL) {
+    return false;
+  }
+  char address[32];
+  snprintf(address, sizeof(address), "127.0.0.1:%d",
+    socket_local_port((Socket)nets[0]->socket));
+  nets[1] = net_join(address, config);
+  if (nets[1] == NULL) {
+    net_close(nets[0], NULL);
+    return false;
+  }
+
+  // simulated milliseconds, so the link delays don't depend on speed
+  Uint32 now = nets[1]->last_hello + NET_HELLO_MS;
+  Uint32 connect_start = now;
+  bool connected = false;
+  while (!connected && now - connect_start < NET_CONNECT_MS) {
+    bool host_connected = net_connect(nets[0], now);
+    connected = net_connect(nets[1], now) && host_connected;
+    now++;
+  }
+  if (!connected) {
+    SDL_LogError(LOGCAT, "Net test: the peers failed to connect");
+    net_close(nets[0], NULL);
+    net_close(nets[1], NULL);
+    return false;
+  }
+
+  Game games[2];
+  Rng rngs[2];
+  Uint8 held[2] = { 0, 0 };
+  for (int i = 0; i < 2; i++) {
+    games[i] = (Game){
+      .match = { .winner = NOBODY, .idle = true, .versus = true,
+        .fixed_point = nets[i]->fixed_point },
+      .running = true, .net = nets[i] };
+    new_game(&games[i], nets[i]->seed);
+    rng_seed(&rngs[i], seed + 1 + i);
+  }
+
+  Uint64 steps = (Uint64)(seconds * sim_hz);
+  double sim_step = 1.0 / sim_hz;
+  double clock = now;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (Uint64 step = 0; step < steps; step++) {
+    clock += 1000.0 / sim_hz;
+    for (int i = 0; i < 2; i++) {
+      net_advance(nets[i], &games[i], random_input(&rngs[i], &held[i]),
+        sim_step, (Uint32)clock);
+    }
+  }
+  double elapsed = (SDL_GetPerformanceCounter() - start) /
+    (double)SDL_GetPerformanceFrequency();
+
+  SDL_LogInfo(LOGCAT, "Net test: %.0f s of play at %d Hz in %.2f s, "
+    "input delay %d, rollback %d, latency %d ms, jitter %d ms, loss %.1f%%",
+    seconds, sim_hz, elapsed, nets[0]->config.input_delay,
+    nets[0]->config.rollback, config->latency, config->jitter, config->loss);
+  bool ok = nets[0]->checks > 0 && nets[1]->checks > 0 &&
+    nets[0]->desyncs == 0 && nets[1]->desyncs == 0;
+  net_close(nets[0], "Host");
+  net_close(nets[1], "Guest");
+  if (ok) {
+    SDL_LogInfo(LOGCAT, "Net test passed");
+  } else {
+    SDL_LogError(LOGCAT, "Net test failed");
+  }
+  return ok;
+}
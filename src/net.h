@@ -0,0 +1,236 @@
+#ifndef NET_H
+#define NET_H
+
+#include "pong.h"
+
+#define NET_PORT 7777
+// default ticks of input delay and of rollback (prediction) depth
+#define NET_INPUT_DELAY 2
+#define NET_ROLLBACK 12
+#define NET_MAX_INPUT_DELAY 10
+#define NET_MAX_ROLLBACK 30
+// ring size of inputs and snapshots, more than delay plus rollback
+#define NET_RING 64
+// local inputs resent in every packet until the peer acknowledges them
+#define NET_MAX_INPUTS 32
+#define NET_MAX_PACKET 128
+// ticks between state hashes compared with the peer
+#define NET_CHECK_INTERVAL 60
+#define NET_CHECKS 8
+// fewest ticks between two stalls that let the peer catch up, and the
+// weight of each tick's lead in the smoothed lead
+#define NET_SYNC_INTERVAL 16
+#define NET_SYNC_SMOOTHING 0.05
+#define NET_HELLO_MS 100
+#define NET_CONNECT_MS 30000
+// packets held back by the simulated link
+#define NET_LINK_QUEUE 512
+
+// player input sampled every tick
+#define NET_INPUT_UP 1
+#define NET_INPUT_DOWN 2
+#define NET_INPUT_START 4
+
+/*
+  Settings of a network match: input delay and rollback depth in ticks,
+  and impairments added to the link for testing
+*/
+typedef struct NetConfig NetConfig;
+struct NetConfig {
+  int input_delay;
+  int rollback;
+  // one way delay and its random extra in milliseconds
+  int latency;
+  int jitter;
+  // percentage of packets dropped
+  double loss;
+};
+
+/*
+  The part of a Game that a tick changes, its Match, saved before every
+  tick so the game can be rolled back to it. The hash is taken when it is
+  saved.
+*/
+typedef struct NetState NetState;
+struct NetState {
+  Uint64 tick;
+  Uint64 hash;
+  Match match;
+};
+
+/*
+  A packet held back by the simulated link until it is due
+*/
+typedef struct NetPacket NetPacket;
+struct NetPacket {
+  Uint32 due;
+  int size;
+  Uint8 data[NET_MAX_PACKET];
+};
+
+/*
+  One side of a two-player match over UDP with rollback. Both sides run
+  the same deterministic simulation from the host's seed and physics
+  (double or fixed point); the host moves the player paddle and the guest
+  the robot paddle.
+
+  Every tick the local input is sampled for input_delay ticks ahead and
+  sent, along with all inputs the peer hasn't acknowledged, so a lost
+  packet costs no more than a late one. A tick whose remote input hasn't
+  arrived is simulated with the remote player's last input (the paddle
+  keeps its dy). The state before every tick is kept, and when a remote
+  input turns out different from the one predicted, the game is restored
+  to that tick and simulated forward again with the real input. The game
+  stalls instead of predicting more than rollback ticks ahead, and skips
+  a tick now and then when it runs ahead of the peer.
+
+  Inputs and states are rings indexed by tick % NET_RING. Hashes of the
+  state every NET_CHECK_INTERVAL ticks, once its inputs are confirmed,
+  are exchanged to detect a desync.
+*/
+struct Net {
+  Uint64 socket;
+  bool hosting;
+  bool connected;
+  Uint32 peer_ip;
+  Uint16 peer_port;
+  Player side;
+  Uint64 seed;
+  int sim_hz;
+  bool fixed_point;
+  NetConfig config;
+  Uint32 now;
+  Uint32 last_hello;
+
+  Uint8 local_inputs[NET_RING];
+  Uint8 remote_inputs[NET_RING];
+  // remote input each tick was last simulated with
+  Uint8 used_remote[NET_RING];
+  // inputs are known for ticks below these
+  Uint64 local_known;
+  Uint64 remote_known;
+  // the peer has our inputs for ticks below this
+  Uint64 remote_acked;
+  // the peer's tick and lead over us as of its latest packet
+  Uint64 remote_tick;
+  int remote_advantage;
+  // how far we lead beyond what the peer leads, smoothed over ticks
+  double sync_gap;
+  bool rollback_pending;
+  Uint64 rollback_tick;
+  Uint64 last_sync;
+  NetState states[NET_RING];
+
+  Uint64 next_check;
+  Uint64 check_ticks[NET_CHECKS];
+  Uint64 check_hashes[NET_CHECKS];
+  Uint64 remote_check_tick;
+  Uint64 remote_check_hash;
+  Uint64 compared_tick;
+
+  // simulated link
+  Rng link_rng;
+  NetPacket link[NET_LINK_QUEUE];
+  int link_count;
+
+  Uint64 ticks;
+  Uint64 rollbacks;
+  Uint64 rollback_ticks;
+  Uint64 max_rollback;
+  Uint64 stalls;
+  Uint64 sync_stalls;
+  Uint64 sent;
+  Uint64 received;
+  Uint64 dropped;
+  Uint64 checks;
+  Uint64 desyncs;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Listen for a guest on a UDP port. The host decides the
+    seed, simulation rate and physics and plays the player paddle.
+    Parameters:
+      int port: UDP port to listen on, 0 for any free port
+      Uint64 seed: seed of the match
+      int sim_hz: simulation steps per second
+      bool fixed_point: the match runs fixed point physics
+      NetConfig* config: input delay, rollback depth and link impairments
+    Returns: Net* pointer to the new connection, or NULL on failure
+    ---------------------------------------------------------------------- */
+Net* net_host(int port, Uint64 seed, int sim_hz, bool fixed_point,
+  NetConfig* config);
+
+/*  ----------------------------------------------------------------------
+    Description: Join a host. The guest plays the robot paddle and takes
+    the seed, simulation rate and physics from the host when connected.
+    Parameters:
+      const char* address: host as HOST:PORT, or HOST for NET_PORT
+      NetConfig* config: input delay, rollback depth and link impairments
+    Returns: Net* pointer to the new connection, or NULL on failure
+    ---------------------------------------------------------------------- */
+Net* net_join(const char* address, NetConfig* config);
+
+/*  ----------------------------------------------------------------------
+    Description: Make progress on connecting without blocking: the guest
+    says hello every NET_HELLO_MS, the host answers with the seed,
+    simulation rate and physics
+    Parameters:
+      Net* net: pointer to the connection
+      Uint32 now: current time in milliseconds
+    Returns: true once connected
+    ---------------------------------------------------------------------- */
+bool net_connect(Net* net, Uint32 now);
+
+/*  ----------------------------------------------------------------------
+    Description: Sample the local player's input from the keyboard: the
+    arrow keys move the paddle and space starts the match
+    Parameters: none
+    Returns: NET_INPUT_* bits
+    ---------------------------------------------------------------------- */
+Uint8 net_local_input(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Advance a network match by one tick: receive packets,
+    roll back and simulate forward again if a remote input was
+    mispredicted, then send the local input and simulate the next tick,
+    unless the game has to wait for the peer
+    Parameters:
+      Net* net: pointer to the connection
+      Game* game: pointer to the Game object, started with new_game()
+      from the connection's seed and with its fixed_point
+      Uint8 input: local NET_INPUT_* bits for input_delay ticks ahead
+      double sim_step: fixed simulation step in seconds
+      Uint32 now: current time in milliseconds
+    Returns: true if a tick was simulated, false if stalled
+    ---------------------------------------------------------------------- */
+bool net_advance(Net* net, Game* game, Uint8 input, double sim_step,
+  Uint32 now);
+
+/*  ----------------------------------------------------------------------
+    Description: Log the rollback, stall, packet and desync counts, close
+    the socket and free the connection
+    Parameters:
+      Net* net: pointer to the connection, NULL is ignored
+      const char* label: name of this side in the log
+    Returns: none
+    ---------------------------------------------------------------------- */
+void net_close(Net* net, const char* label);
+
+/*  ----------------------------------------------------------------------
+    Description: Test harness: play a host and a guest against each other
+    over loopback UDP in one process, with the configured latency, jitter
+    and loss on both links and random inputs, on a simulated clock as
+    fast as possible. Logs the rollbacks and stalls of both sides and
+    checks that their states agree.
+    Parameters:
+      NetConfig* config: input delay, rollback depth and link impairments
+      double seconds: seconds of play to simulate
+      Uint64 seed: seed of the match and the inputs
+      int sim_hz: simulation steps per second
+      bool fixed_point: run fixed point physics
+    Returns: true if both sides compared states and never disagreed
+    ---------------------------------------------------------------------- */
+bool run_net_test(NetConfig* config, double seconds, Uint64 seed, int sim_hz,
+  bool fixed_point);
+
+#endif
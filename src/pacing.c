@@ -0,0 +1,161 @@
+// Frame pacing and input-to-present latency
+#include "pacing.h"
+#include <stdlib.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a frame pacer
+    Parameters:
+      bool low_latency: wait before polling input rather than after
+      presenting
+      bool vsync: true if SDL_RenderPresent() waits for the display
+      double budget: frame budget in seconds
+    Returns: Pacer* pointer to the pacer, or NULL on failure
+    ---------------------------------------------------------------------- */
+Pacer* pacer_create(bool low_latency, bool vsync, double budget) {
+  // the histogram is large, keep it off the stack
+  Pacer* pacer = calloc(1, sizeof(Pacer));
+  if (pacer == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate frame pacer");
+    return NULL;
+  }
+  pacer->low_latency = low_latency;
+  pacer->vsync = vsync;
+  pacer->budget = budget * SDL_GetPerformanceFrequency();
+  if (low_latency) {
+    SDL_LogInfo(LOGCAT, "Low latency pacing: %.2f ms frames, vsync %s",
+      budget * 1000, vsync ? "on" : "off");
+  }
+  return pacer;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Wait until the performance counter reaches a value,
+    sleeping while it is far off and spinning for the last PACING_SPIN_US
+    Parameters:
+      Uint64 target: performance counter value to wait for
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_wait(Uint64 target) {
+  double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+  Uint64 spin = PACING_SPIN_US / 1000.0 * ticks_per_ms;
+
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (now + spin < target) {
+    SDL_Delay((Uint32)((target - spin - now) / ticks_per_ms));
+  }
+  while (SDL_GetPerformanceCounter() < target) {
+    // spin
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Start a frame just before polling input. In low latency
+    mode this waits until the frame's work is expected to finish
+    PACING_SAFETY_US before its deadline.
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_begin_frame(Pacer* pacer) {
+  if (pacer == NULL) {
+    return;
+  }
+  if (pacer->low_latency && pacer->deadline != 0) {
+    Uint64 safety =
+      PACING_SAFETY_US / 1e6 * SDL_GetPerformanceFrequency();
+    Uint64 lead = pacer->work + safety;
+    if (pacer->deadline > lead) {
+      pacer_wait(pacer->deadline - lead);
+    }
+  }
+  pacer->poll_counter = SDL_GetPerformanceCounter();
+  pacer->poll_ms = SDL_GetTicks();
+  pacer->input_pending = false;
+  pacer->input_age_ms = 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Note a paddle motion event applied this frame, to measure
+    its latency when the frame is presented
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+      SDL_Event* e: pointer to the event
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_input(Pacer* pacer, SDL_Event* e) {
+  if (pacer == NULL) {
+    return;
+  }
+  // key events queued during the poll may be stamped after it began
+  Uint32 age = SDL_TICKS_PASSED(pacer->poll_ms, e->key.timestamp) ?
+    pacer->poll_ms - e->key.timestamp : 0;
+  if (!pacer->input_pending || age > pacer->input_age_ms) {
+    pacer->input_age_ms = age;
+  }
+  pacer->input_pending = true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: End a frame after presenting it: count the latency of its
+    paddle motion input, update the work estimate and set the next deadline
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+      Uint64 present_start: performance counter just before presenting
+      Uint64 present_end: performance counter just after presenting
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_end_frame(Pacer* pacer, Uint64 present_start, Uint64 present_end) {
+  if (pacer == NULL) {
+    return;
+  }
+  double us_per_tick = 1e6 / SDL_GetPerformanceFrequency();
+
+  if (pacer->input_pending) {
+    double latency = pacer->input_age_ms * 1000.0 +
+      (present_end - pacer->poll_counter) * us_per_tick;
+    histogram_record(&pacer->latency, (Uint64)latency);
+  }
+
+  // with vsync the present blocks until the display takes the frame, so
+  // the work ends when it is submitted
+  Uint64 work = (pacer->vsync ? present_start : present_end) -
+    pacer->poll_counter;
+  if (work > pacer->work) {
+    pacer->work = work;
+  } else {
+    pacer->work -= (pacer->work - work) / PACING_DECAY;
+  }
+
+  if (pacer->vsync || pacer->deadline == 0) {
+    pacer->deadline = present_end + pacer->budget;
+  } else {
+    pacer->deadline += pacer->budget;
+    // don't try to catch up on frames that were missed
+    if (pacer->deadline < present_end) {
+      pacer->deadline = present_end + pacer->budget;
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Log the input latency percentiles and free the pacer
+    Parameters:
+      Pacer* pacer: pointer to the pacer, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_destroy(Pacer* pacer) {
+  if (pacer == NULL) {
+    return;
+  }
+  if (pacer->latency.count > 0) {
+    SDL_LogInfo(LOGCAT,
+      "Input latency: %llu frames, p50 %.1f ms, p99 %.1f ms, max %.1f ms",
+      (unsigned long long)pacer->latency.count,
+      histogram_percentile(&pacer->latency, 50) / 1000.0,
+      histogram_percentile(&pacer->latency, 99) / 1000.0,
+      pacer->latency.max / 1000.0);
+  }
+  free(pacer);
+}
@@ -0,0 +1,104 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "histogram.h"
+
+// the last stretch of every wait is spun rather than slept
+#define PACING_SPIN_US 2000
+// margin kept between the expected end of a frame's work and its deadline
+#define PACING_SAFETY_US 1000
+// each frame the work estimate drops by 1/PACING_DECAY of its excess
+#define PACING_DECAY 32
+
+/*
+  Frame pacing and input latency. In low latency mode every frame waits
+  until its deadline minus the expected frame work before polling input,
+  so input is as fresh as possible when the frame is presented. Waits
+  sleep in whole milliseconds until PACING_SPIN_US before the target and
+  spin on the performance counter from there, as SDL_Delay() may oversleep
+  by a millisecond or two.
+
+  In every mode, frames that applied a paddle motion event count the time
+  from the oldest such event's timestamp to the end of SDL_RenderPresent()
+  in microseconds. Event timestamps only have millisecond resolution, so
+  the event's age when it was polled is added to the poll-to-present time
+  measured with the performance counter.
+*/
+typedef struct Pacer Pacer;
+struct Pacer {
+  bool low_latency;
+  bool vsync;
+  // performance counter ticks
+  Uint64 budget;
+  Uint64 work;
+  Uint64 deadline;
+  Uint64 poll_counter;
+  Uint32 poll_ms;
+  // age of the oldest paddle motion event of this frame when polled
+  bool input_pending;
+  Uint32 input_age_ms;
+  Histogram latency;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a frame pacer
+    Parameters:
+      bool low_latency: wait before polling input rather than after
+      presenting
+      bool vsync: true if SDL_RenderPresent() waits for the display
+      double budget: frame budget in seconds
+    Returns: Pacer* pointer to the pacer, or NULL on failure
+    ---------------------------------------------------------------------- */
+Pacer* pacer_create(bool low_latency, bool vsync, double budget);
+
+/*  ----------------------------------------------------------------------
+    Description: Wait until the performance counter reaches a value,
+    sleeping while it is far off and spinning for the last PACING_SPIN_US
+    Parameters:
+      Uint64 target: performance counter value to wait for
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_wait(Uint64 target);
+
+/*  ----------------------------------------------------------------------
+    Description: Start a frame just before polling input. In low latency
+    mode this waits until the frame's work is expected to finish
+    PACING_SAFETY_US before its deadline.
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_begin_frame(Pacer* pacer);
+
+/*  ----------------------------------------------------------------------
+    Description: Note a paddle motion event applied this frame, to measure
+    its latency when the frame is presented
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+      SDL_Event* e: pointer to the event
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_input(Pacer* pacer, SDL_Event* e);
+
+/*  ----------------------------------------------------------------------
+    Description: End a frame after presenting it: count the latency of its
+    paddle motion input, update the work estimate and set the next deadline
+    Parameters:
+      Pacer* pacer: pointer to the pacer, nothing happens if NULL
+      Uint64 present_start: performance counter just before presenting
+      Uint64 present_end: performance counter just after presenting
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_end_frame(Pacer* pacer, Uint64 present_start, Uint64 present_end);
+
+/*  ----------------------------------------------------------------------
+    Description: Log the input latency percentiles and free the pacer
+    Parameters:
+      Pacer* pacer: pointer to the pacer, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pacer_destroy(Pacer* pacer);
+
+#endif
@@ -0,0 +1,49 @@
+// Assets compiled into the executable
+#include "pack.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+static const char* asset_dir = NULL;
+
+/*  ----------------------------------------------------------------------
+    Description: Load assets from a directory instead of the pack
+    Parameters:
+      const char* dir: directory holding the asset files, or NULL to use
+      the pack
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pack_set_directory(const char* dir) {
+  asset_dir = dir;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Open an asset for reading
+    Parameters:
+      const char* name: file name of the asset, e.g. "VT323-Regular.ttf"
+    Returns: SDL_RWops* reading the packed bytes in place, or the file in
+    the directory set by pack_set_directory(); NULL if there is no such
+    asset
+    ---------------------------------------------------------------------- */
+SDL_RWops* pack_open(const char* name) {
+  if (asset_dir != NULL) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", asset_dir, name);
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if (rw == NULL) {
+      SDL_LogError(LOGCAT, "Failed to open asset '%s': %s",
+        path, SDL_GetError());
+    }
+    return rw;
+  }
+
+  for (int i = 0; i < pack_count; i++) {
+    if (strcmp(pack_entries[i].name, name) == 0) {
+      return SDL_RWFromConstMem(pack_entries[i].data,
+        (int)pack_entries[i].size);
+    }
+  }
+  SDL_LogError(LOGCAT, "Asset '%s' is not in the pack", name);
+  return NULL;
+}
@@ -0,0 +1,45 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <SDL.h>
+#include <stddef.h>
+
+/*
+  Asset pack: the game's asset files compiled into the executable as
+  read-only byte arrays by tools/pack_assets.c at build time, so no files
+  are opened at startup and the game runs from any working directory.
+  Assets are read in place through SDL_RWFromConstMem(), without copies.
+  For development, a directory set with pack_set_directory() is read
+  instead.
+*/
+typedef struct PackEntry PackEntry;
+struct PackEntry {
+  const char* name;
+  const unsigned char* data;
+  size_t size;
+};
+
+// defined in the generated source
+extern const PackEntry pack_entries[];
+extern const int pack_count;
+
+/*  ----------------------------------------------------------------------
+    Description: Load assets from a directory instead of the pack
+    Parameters:
+      const char* dir: directory holding the asset files, or NULL to use
+      the pack
+    Returns: none
+    ---------------------------------------------------------------------- */
+void pack_set_directory(const char* dir);
+
+/*  ----------------------------------------------------------------------
+    Description: Open an asset for reading
+    Parameters:
+      const char* name: file name of the asset, e.g. "VT323-Regular.ttf"
+    Returns: SDL_RWops* reading the packed bytes in place, or the file in
+    the directory set by pack_set_directory(); NULL if there is no such
+    asset
+    ---------------------------------------------------------------------- */
+SDL_RWops* pack_open(const char* name);
+
+#endif
@@ -1,25 +1,58 @@
 // SDL2 Pong Game
 #include "pong.h"
+#include "batch.h"
+#include "fixed.h"
+#include "skip.h"
+#include "farm.h"
+#include "replay.h"
+#include "net.h"
+#include "spectate.h"
 
 /*  ----------------------------------------------------------------------
     Description: initialize SDL systems and set logging level.
-    Parameters: none
+    Parameters:
+      Options* options: command line options. With headless set, only the
+      SDL core is initialized; no window, renderer, fonts or audio device
+      are created. Otherwise the video subsystem, window and renderer are
+      created here, and the fonts and audio device are left to the loader
+      thread started before the window, see take_assets(). vsync and
+      audio_buffer configure the renderer and the audio device.
     Returns: App object containing initialized SDL_Window and SDL_Renderer
     objects.
 */
-App* init(void) {
-
-  srand(time(0));
+App* init(Options* options) {
 
   App* app = malloc(sizeof(App));
 
   app->log_priority = SDL_LOG_PRIORITY_INFO;
+  app->headless = options->headless;
+  app->vsync = false;
+  app->court_layer = (Layer){ .texture = NULL, .dirty = true };
+  app->instructions_layer = (Layer){ .texture = NULL, .dirty = true };
+  app->window = NULL;
+  app->renderer = NULL;
+  app->draw_calls = 0;
+  app->last_draw_calls = 0;
+  app->pacer = NULL;
+  app->loader = NULL;
+  app->capture = NULL;
+  quads_init(&app->quads);
    
   SDL_LogSetPriority(LOGCAT, app->log_priority);
 
-  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+  if (app->headless) {
+    if (SDL_Init(0) < 0) {
+      fprintf(stderr, "Could not initialize SDL2: %s\n", SDL_GetError());
+    }
+    return app;
+  }
+
+  if (SDL_Init(SDL_INIT_VIDEO) < 0) {
     fprintf(stderr, "Could not initialize SDL2: %s\n", SDL_GetError());
   }
+  // fonts and audio load while the window and renderer are created
+  app->loader = loader_start(options->audio_buffer);
+
   //Set texture filtering to linear
   if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1")) {
     SDL_LogWarn(LOGCAT, "Linear texture filtering not enabled!");
@@ -33,36 +66,290 @@ App* init(void) {
     SDL_LogError(LOGCAT, "Could not create window: %s\n", SDL_GetError());
   }
 
-  app->renderer = SDL_CreateRenderer(app->window, -1, SDL_RENDERER_PRESENTVSYNC);
+  app->renderer = SDL_CreateRenderer(app->window, -1,
+    options->vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
   if (app->renderer == NULL) {
     SDL_LogCritical(LOGCAT,
       "Renderer could not be created! SDL Error: %s\n",
       SDL_GetError());
   }
+
+  // only cap the frame rate ourselves when the display isn't pacing us
+  SDL_RendererInfo info;
+  app->vsync = app->renderer != NULL &&
+    SDL_GetRendererInfo(app->renderer, &info) == 0 &&
+    (info.flags & SDL_RENDERER_PRESENTVSYNC);
   SDL_SetRenderDrawColor(app->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+  return app;
+}
 
-  //Initialize PNG loading
-  int imgFlags = IMG_INIT_PNG;
-  if (!(IMG_Init(imgFlags) & imgFlags)) {
-    SDL_LogCritical(LOGCAT,
-      "SDL_image could not initialize! SDL_image Error: %s\n",
-      IMG_GetError());
+/*  ---------------------------------------------------------------------- 
+    Description: Parse command line arguments into an Options object.
+    Recognized arguments:
+      --headless          run matches without video, audio or frame cap
+      --matches N         number of matches to run in headless mode
+      --time-step S       synthetic time step in seconds for headless mode
+      --sim-hz N          fixed simulation rate in steps per second
+      --batch N           with --headless, run N concurrent matches in the
+                          structure-of-arrays batch simulator
+      --kernel NAME       batch kernel: auto, scalar, sse2 or avx2
+      --farm              with --headless, spread matches over all cores
+      --threads N         number of farm worker threads, 0 for one per CPU
+      --trace FILE        record timing zones and write them to FILE as
+                          Chrome trace-event JSON on exit or on 'T'
+      --soak FILE         append frame time percentiles and hitch counts
+                          to FILE as JSON lines
+      --soak-interval S   seconds per soak window
+      --seed N            random seed, default is the current time
+      --record FILE       record the seed and player input to a replay file,
+                          not with --headless
+      --replay FILE       play a replay file back, as fast as possible
+                          with --headless
+      --low-latency       poll input as late as possible before each frame
+      --no-vsync          don't wait for the display when presenting
+      --audio-buffer N    audio buffer in sample frames, a power of two;
+                          default 2048, or 512 with --low-latency
+      --assets DIR        load fonts from DIR instead of the built-in pack
+      --capture FILE      stream every frame to FILE as Y4M video
+      --capture-png PRE   save every frame to PRE_000001.png, ...
+      --capture-frames N  with --headless, stop capturing after N frames
+      --host PORT         host a two-player match on UDP PORT, 1 to 65535,
+                          and play the right paddle
+      --join HOST[:PORT]  join the match hosted by HOST (default port
+                          7777) and play the left paddle
+      --input-delay N     ticks each local input is delayed, 0 to 10
+                          (default 2)
+      --rollback N        most ticks predicted ahead of the remote input,
+                          1 to 30 (default 12)
+      --net-latency MS    delay what this side sends by MS, 0 or more
+      --net-jitter MS     add up to MS of random delay, 0 or more
+      --net-loss PCT      drop PCT percent of what this side sends, 0 to
+                          100. Network matches can't be recorded or
+                          replayed
+      --net-test S        with --headless implied, play a host and a
+                          guest over loopback for S seconds of random
+                          input, failing on a desync
+      --spectate-port PORT
+                          broadcast the game to spectators on TCP PORT,
+                          1 to 65535
+      --spectate-hz N     broadcasts per second, 1 to 1000 (default 60)
+      --spectate-max N    most spectators at once, 1 to 65536 (default
+                          1024)
+      --spectate HOST[:PORT]
+                          watch the game broadcast by HOST (default port
+                          7778); it only watches, so not with --host,
+                          --join, --record or --replay
+      --spectate-test N   with --headless implied, broadcast an AI vs AI
+                          game to N spectators over loopback for 10
+                          seconds, N up to 65536
+      --fixed-point       move the ball and paddles in 16.16 fixed point,
+                          for results that are the same on every machine
+      --event-driven      with --headless, jump from one ball event to the
+                          next instead of ticking
+    Parameters: 
+      int argc, char* argv[]: command line arguments from main()
+      Options* options: pointer to Options object to fill in
+    Returns: true if all arguments were recognized, otherwise false
+    ---------------------------------------------------------------------- */
+bool parse_options(int argc, char* argv[], Options* options) {
+  options->headless = false;
+  options->matches = HEADLESS_MATCHES;
+  options->time_step = HEADLESS_TIME_STEP;
+  options->sim_hz = SIM_HZ;
+  options->batch = 0;
+  options->kernel = "auto";
+  options->farm = false;
+  options->threads = 0;
+  options->trace = NULL;
+  options->soak = NULL;
+  options->soak_interval = SOAK_FLUSH_SECONDS;
+  options->seed = time(0);
+  options->record = NULL;
+  options->replay = NULL;
+  options->low_latency = false;
+  options->vsync = true;
+  options->audio_buffer = 0;
+  options->assets = NULL;
+  options->capture = NULL;
+  options->capture_png = NULL;
+  options->capture_frames = 0;
+  options->net_host = 0;
+  options->net_join = NULL;
+  options->net_test = 0;
+  options->input_delay = NET_INPUT_DELAY;
+  options->rollback = NET_ROLLBACK;
+  options->net_latency = 0;
+  options->net_jitter = 0;
+  options->net_loss = 0;
+  options->spectate_port = 0;
+  options->spectate_hz = SPECTATE_HZ;
+  options->spectate_max = SPECTATE_MAX_CLIENTS;
+  options->spectate = NULL;
+  options->spectate_test = 0;
+  options->fixed_point = false;
+  options->event_driven = false;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--headless") == 0) {
+      options->headless = true;
+    } else if (strcmp(argv[i], "--matches") == 0 && has_value) {
+      options->matches = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--time-step") == 0 && has_value) {
+      options->time_step = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--sim-hz") == 0 && has_value) {
+      options->sim_hz = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+      options->batch = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--kernel") == 0 && has_value) {
+      options->kernel = argv[++i];
+    } else if (strcmp(argv[i], "--farm") == 0) {
+      options->farm = true;
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      options->threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+      options->trace = argv[++i];
+    } else if (strcmp(argv[i], "--soak") == 0 && has_value) {
+      options->soak = argv[++i];
+    } else if (strcmp(argv[i], "--soak-interval") == 0 && has_value) {
+      options->soak_interval = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      options->seed = strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+      options->record = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && has_value) {
+      options->replay = argv[++i];
+    } else if (strcmp(argv[i], "--low-latency") == 0) {
+      options->low_latency = true;
+    } else if (strcmp(argv[i], "--no-vsync") == 0) {
+      options->vsync = false;
+    } else if (strcmp(argv[i], "--audio-buffer") == 0 && has_value) {
+      options->audio_buffer = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--assets") == 0 && has_value) {
+      options->assets = argv[++i];
+    } else if (strcmp(argv[i], "--capture") == 0 && has_value) {
+      options->capture = argv[++i];
+    } else if (strcmp(argv[i], "--capture-png") == 0 && has_value) {
+      options->capture_png = argv[++i];
+    } else if (strcmp(argv[i], "--capture-frames") == 0 && has_value) {
+      options->capture_frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--host") == 0 && has_value) {
+      options->net_host = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--join") == 0 && has_value) {
+      options->net_join = argv[++i];
+    } else if (strcmp(argv[i], "--net-test") == 0 && has_value) {
+      options->net_test = atof(argv[++i]);
+      options->headless = true;
+    } else if (strcmp(argv[i], "--input-delay") == 0 && has_value) {
+      options->input_delay = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rollback") == 0 && has_value) {
+      options->rollback = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--net-latency") == 0 && has_value) {
+      options->net_latency = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--net-jitter") == 0 && has_value) {
+      options->net_jitter = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--net-loss") == 0 && has_value) {
+      options->net_loss = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--spectate-port") == 0 && has_value) {
+      options->spectate_port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--spectate-hz") == 0 && has_value) {
+      options->spectate_hz = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--spectate-max") == 0 && has_value) {
+      options->spectate_max = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--spectate") == 0 && has_value) {
+      options->spectate = argv[++i];
+    } else if (strcmp(argv[i], "--spectate-test") == 0 && has_value) {
+      options->spectate_test = atoi(argv[++i]);
+      options->headless = true;
+    } else if (strcmp(argv[i], "--fixed-point") == 0) {
+      options->fixed_point = true;
+    } else if (strcmp(argv[i], "--event-driven") == 0) {
+      options->event_driven = true;
+    } else {
+      SDL_LogError(LOGCAT, "Unknown or incomplete argument '%s'", argv[i]);
+      return false;
+    }
   }
 
-  //Initialize SDL_ttf
-  if (TTF_Init() == -1) {
-    SDL_LogCritical(LOGCAT,
-      "SDL_ttf could not initialize! SDL_ttf Error: %s\n",
-      TTF_GetError());
+  if (options->matches < 1 || options->time_step <= 0 || options->sim_hz < 1 ||
+    options->soak_interval <= 0) {
+    SDL_LogError(LOGCAT,
+      "--matches, --time-step, --sim-hz and --soak-interval must be positive");
+    return false;
   }
 
-  //Initialize SDL_mixer
-  if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
-    SDL_LogCritical(LOGCAT,
-      "SDL_mixer could not initialize! SDL_mixer Error: %s\n",
-      Mix_GetError());
+  if (options->fixed_point && options->time_step > FIXED_MAX_TIME_STEP) {
+    SDL_LogError(LOGCAT, "--time-step is at most %g s with --fixed-point",
+      FIXED_MAX_TIME_STEP);
+    return false;
   }
-  return app;
+
+  if (options->event_driven && (options->fixed_point || options->batch > 0)) {
+    SDL_LogError(LOGCAT,
+      "--event-driven doesn't go with --fixed-point or --batch");
+    return false;
+  }
+
+  if (options->audio_buffer == 0) {
+    options->audio_buffer = options->low_latency ?
+      SOUND_LOW_LATENCY_FRAMES : SOUND_BUFFER_FRAMES;
+  }
+  if (options->audio_buffer < 64 ||
+    (options->audio_buffer & (options->audio_buffer - 1)) != 0) {
+    SDL_LogError(LOGCAT, "--audio-buffer must be a power of two, 64 or more");
+    return false;
+  }
+
+  if (options->net_host < 0 || options->net_host > 65535) {
+    SDL_LogError(LOGCAT, "--host must be a UDP port");
+    return false;
+  }
+  if (options->input_delay < 0 || options->input_delay > NET_MAX_INPUT_DELAY ||
+    options->rollback < 1 || options->rollback > NET_MAX_ROLLBACK) {
+    SDL_LogError(LOGCAT, "--input-delay must be 0 to %d and --rollback 1 to %d",
+      NET_MAX_INPUT_DELAY, NET_MAX_ROLLBACK);
+    return false;
+  }
+  if (options->net_latency < 0 || options->net_jitter < 0 ||
+    options->net_loss < 0 || options->net_loss > 100) {
+    SDL_LogError(LOGCAT, "--net-latency and --net-jitter can't be negative, "
+      "--net-loss is 0 to 100");
+    return false;
+  }
+  bool networked = options->net_host > 0 || options->net_join != NULL;
+  if (networked && (options->record != NULL || options->replay != NULL)) {
+    SDL_LogError(LOGCAT, "Network matches can't be recorded or replayed");
+    return false;
+  }
+
+  if (options->spectate_port < 0 || options->spectate_port > 65535 ||
+    options->spectate_hz < 1 || options->spectate_hz > 1000 ||
+    options->spectate_max < 1 ||
+    options->spectate_max > SPECTATE_CLIENT_LIMIT ||
+    options->spectate_test < 0 ||
+    options->spectate_test > SPECTATE_CLIENT_LIMIT) {
+    SDL_LogError(LOGCAT, "--spectate-port must be a TCP port, --spectate-hz "
+      "1 to 1000, --spectate-max and --spectate-test up to %d",
+      SPECTATE_CLIENT_LIMIT);
+    return false;
+  }
+  if (options->spectate != NULL && (networked ||
+    options->record != NULL || options->replay != NULL)) {
+    SDL_LogError(LOGCAT, "--spectate only watches, it can't play or record");
+    return false;
+  }
+  if (options->headless && options->record != NULL) {
+    SDL_LogError(LOGCAT,
+      "--record needs the game window, headless runs have no input to record");
+    return false;
+  }
+
+  BatchKernel kernel;
+  if (!batch_kernel_from_name(options->kernel, &kernel)) {
+    SDL_LogError(LOGCAT, "Unknown batch kernel '%s'", options->kernel);
+    return false;
+  }
+  return true;
 }
 
 /*  ---------------------------------------------------------------------- 
@@ -82,134 +369,135 @@ void set_log_priority(App* app) {
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Load WAV sound assets
-    Parameters: Game object
-    Returns: none
+    Description: Once the loader thread is done, take its fonts and sound
+    effects into the game, build the glyph atlases and free the loader.
+    Until then the game runs without text and sound. Does nothing while
+    the loader is still busy or after the assets were taken.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
+      Uint64 start: performance counter at the start of main()
+    Returns: true if the assets were taken by this call
     ---------------------------------------------------------------------- */
-void load_sounds(Game* game) {
-  game->ball.paddle_sound = Mix_LoadWAV("../assets/paddle.wav");
-  if (game->ball.paddle_sound == NULL) {
-    SDL_LogError(LOGCAT, "Failed to load paddle.wav");
-  }
-  game->ball.wall_sound = Mix_LoadWAV("../assets/wall.wav");
-  if (game->ball.wall_sound == NULL) {
-    SDL_LogError(LOGCAT, "Failed to load wall.wav");
-  }
-  game->point_sound = Mix_LoadWAV("../assets/point.wav");
-  if (game->point_sound == NULL) {
-    SDL_LogError(LOGCAT, "Failed to load point.wav");
+bool take_assets(App* app, Game* game, Uint64 start) {
+  Loader* loader = app->loader;
+  if (!loader_ready(loader)) {
+    return false;
   }
+  game->score_font = loader->score_font;
+  game->stats_font = loader->stats_font;
+  game->paddle_sound = loader->paddle_sound;
+  game->wall_sound = loader->wall_sound;
+  game->point_sound = loader->point_sound;
+  loader->score_font = NULL;
+  loader->stats_font = NULL;
+  loader->paddle_sound = NULL;
+  loader->wall_sound = NULL;
+  loader->point_sound = NULL;
+
+  double frequency = (double)SDL_GetPerformanceFrequency();
+  SDL_LogInfo(LOGCAT, "Assets loaded in %.1f ms, ready %.1f ms after start",
+    loader->elapsed * 1000.0 / frequency,
+    (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency);
+  loader_destroy(loader);
+  app->loader = NULL;
+
+  load_atlases(app, game);
+  // the instructions layer was cached without text
+  invalidate_layers(app);
+  // S may have been pressed before the audio device was open
+  Mix_Volume(-1, game->play_sounds ? MIX_MAX_VOLUME : 0);
+  return true;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: load ttf font from specified file at specified size
+    Description: load ttf font from the asset pack at specified size. The
+    font is read in place from the packed bytes, see pack_open().
     Parameters: 
-      char* path: path to TTF font file
+      const char* name: file name of the TTF font asset
       int size:   display size of font in pixels
     Returns: TTF_font* pointer to font object
     ---------------------------------------------------------------------- */
-TTF_Font* load_font(char* path, int size) {
-  TTF_Font* font = TTF_OpenFont(path, size);
+TTF_Font* load_font(const char* name, int size) {
+  SDL_RWops* rw = pack_open(name);
+  if (rw == NULL) {
+    return NULL;
+  }
+  // the font keeps reading from rw and closes it with the font
+  TTF_Font* font = TTF_OpenFontRW(rw, 1, size);
   if (font == NULL) {
     SDL_LogError(LOGCAT,
       "Failed to load font '%s'! SDL_ttf Error: %s\n",
-      path, TTF_GetError());
+      name, TTF_GetError());
   }
   return font;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Reset Game object to defaults for new game
-    Parameters: Game* game - game object
+    Description: Build the glyph atlases for the score, instructions and
+    stats text from the game's fonts. The score and instructions share the
+    VT323 font at different sizes, so each size gets its own atlas and the
+    font size is never changed while drawing.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_game(Game* game) {
-  game->score_board.player = 0;
-  game->score_board.robot = 0;
-  game->winner = game->over ? game->winner : NOBODY;
-  reset_paddle(&game->player, PLAYER);
-  reset_paddle(&game->robot, ROBOT);
-  reset_ball(&game->ball, ROBOT);
-  game->ball.speed = BALL_MIN_SPEED;
-  game->idle = true;
-  game->over = false;
+void load_atlases(App* app, Game* game) {
+  game->instructions_atlas = atlas_create(
+    app->renderer, game->score_font, INSTRUCTIONS_FONT_SIZE);
+  game->score_atlas = atlas_create(
+    app->renderer, game->score_font, SCORE_FONT_SIZE);
+  game->stats_atlas =
+    atlas_create(app->renderer, game->stats_font, STATS_FONT_SIZE);
 }
 
-/*  ---------------------------------------------------------------------- 
-    Description: Reset specified Paddle object to defaults for given Player
-    Parameters: 
-      Paddle* paddle: pointer to player paddle
-      Player* owner: owner of paddle (either PLAYER or ROBOT), 
-      determines x position of paddle on court
+/*  ----------------------------------------------------------------------
+    Description: Match phase hook that times each phase of step_match()
+    as a trace zone. Phases don't nest, so one open zone is enough.
+    Parameters:
+      const char* name: phase name, a string literal
+      bool begin: true as the phase begins, false as it ends
+      void* ctx: pointer to the TraceZone holding the open phase
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_paddle(Paddle* paddle, Player owner) {
-  paddle->owner = owner;
-  paddle->speed = PADDLE_SPEED;
-  paddle->time_step = 0;
-  paddle->dx = 0;
-  paddle->dy = 0;
-  paddle->fudge = 0;
-  paddle->h = PADDLE_H;
-  paddle->w = PADDLE_W;
-  paddle->x = paddle->owner == PLAYER ? PLAYER_X : ROBOT_X;
-  paddle->y = PADDLE_Y;
+void trace_phase(const char* name, bool begin, void* ctx) {
+  TraceZone* zone = ctx;
+  if (begin) {
+    *zone = trace_zone_begin(name);
+  } else {
+    trace_zone_end(zone);
+  }
 }
 
-/*  ---------------------------------------------------------------------- 
-    Description: Reset Ball object to defaults. Sets the ball's initial
-    dx, dy and 'fudge' to random values within a specified range.
-    Parameters:   
-      Ball* ball: ball object
-      Player server: player serving ball, determines the position and direction
-      of the ball for service.
+/*  ----------------------------------------------------------------------
+    Description: Time the phases of the game's match with trace_phase()
+    when tracing is enabled. Without tracing the match has no hook and
+    steps as fast as in the farm.
+    Parameters:
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_ball(Ball* ball, Player server) {
-  ball->service = server;
-  ball->speed = ball->speed < BALL_MIN_SPEED ? BALL_MIN_SPEED : ball->speed;
-  ball->x = 0;
-  ball->y = 0;
-
-  /*
-    Service angle adjustment
-    a % b:	the remainder of a divided by b
-    rand() % n      ->  0 to n-1
-    rand() % 7      ->  0 to 6
-    rand() % 7 - 3  -> -3 to 3
-    rand() % 9 - 4  -> -4 to 4
-  */
-
-  do {
-    ball->dy = rand() % 7 - 3;
-  } while (ball->dy == 0);
-
-  // rand() % 4:     0 to 3
-  // rand() % 4 + 2: 2 to 5
-  ball->dx = rand() % 4 + 2;
-  if (ball->service == PLAYER) {
-    ball->dx *= -1;
-  }
-
-  ball->fudge = get_fudge();
-  ball->paddle_segment = 0;
-
-  ball->time_step = 0;
-  ball->x = ball->service == ROBOT ? ROBOT_SERVICE_X : PLAYER_SERVICE_X;
-  ball->y = SCREEN_MID_H - BALL_SIZE / 2;
-  ball->h = BALL_SIZE;
-  ball->w = BALL_SIZE;
+void trace_match(Game* game) {
+  if (trace_enabled()) {
+    game->match.phase = trace_phase;
+    game->match.phase_ctx = &game->phase_zone;
+  }
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Generate a random 'fudge' value between 0 and 14 
-    that affects a paddle's movement speed, either increasing or decreasing 
-    the paddle's y axis motion
-    Parameters: none
-    Returns: int fudge value
+    Description: Seed the game and serve the first ball of an idle game.
+    A recorded game and its replay start from this same state.
+    Parameters: 
+      Game* game: pointer to the Game object
+      Uint64 seed: random seed
+    Returns: none
     ---------------------------------------------------------------------- */
-int get_fudge(void) {
-  return rand() % 15;
+void new_game(Game* game, Uint64 seed) {
+  seed_match(&game->match, seed);
+  trace_match(game);
+  game->sim_ticks = 0;
+  snap_interpolation(game);
 }
 
 /*  ---------------------------------------------------------------------- 
@@ -217,232 +505,364 @@ int get_fudge(void) {
     Paddle moves as long as key is held down. 
     Parameters: 
       SDL_Event* e: pointer to SDL Event object
-      Paddle* paddle: pointer to player paddle object
-    Returns: none
+      Game* game: pointer to the Game object
+    Returns: true if the event started or stopped paddle motion
     ---------------------------------------------------------------------- */
-void handle_input(SDL_Event* e, Paddle* paddle) {
+bool handle_input(SDL_Event* e, Game* game) {
   if (e->type == SDL_KEYDOWN && e->key.repeat == 0) {
     // Move the sprite as long as the key is down
     switch (e->key.keysym.sym) {
     case SDLK_UP:
-      paddle->dy -= paddle->speed;
-      break;
+      apply_command(game, COMMAND_UP_PRESS);
+      return true;
     case SDLK_DOWN:
-      paddle->dy += paddle->speed;
-      break;
+      apply_command(game, COMMAND_DOWN_PRESS);
+      return true;
     }
   }
   if (e->type == SDL_KEYUP && e->key.repeat == 0) {
     // Stop moving once the key is released
     switch (e->key.keysym.sym) {
     case SDLK_UP:
-      paddle->dy += paddle->speed;
-      break;
+      apply_command(game, COMMAND_UP_RELEASE);
+      return true;
     case SDLK_DOWN:
-      paddle->dy -= paddle->speed;
-      break;
+      apply_command(game, COMMAND_DOWN_RELEASE);
+      return true;
     }
   }
+  return false;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Updates the paddle oject's dy value to move the paddle 
-    toward the game ball's position. The dy value is set to the paddle speed 
-    minus the 'fudge' factor, which may speed up or slow down the paddle.
-    Called by the Robot paddle when in play state. Called by both player and
-    robot paddles when game is in Idle state, to simulate a game.
+    Description: Apply one player command to the game. All input that
+    changes the simulation goes through here, so it can be recorded into
+    the game's replay and fed back from it.
     Parameters: 
-      Ball* ball: the game ball
-      Paddle* paddle: the paddle object
+      Game* game: pointer to the Game object
+      Command command: command to apply
     Returns: none
     ---------------------------------------------------------------------- */
-void update_player(Ball* ball, Paddle* paddle) {
-  int paddle_top = paddle->y;
-  int paddle_bottom = paddle->y + paddle->h;
+void apply_command(Game* game, Command command) {
+  // takes effect before the next simulation step
+  replay_record(game->replay, game->sim_ticks, command);
 
-  int ball_top = ball->y;
-  int ball_bottom = ball->y + ball->h;
-  paddle->dy = 0;
-
-  // move paddle up
-  if (ball_top < paddle_top) {
-    paddle->dy -= paddle->speed - ball->fudge;
-  }
-
-  // move paddle down
-  if (ball_bottom > paddle_bottom) {
-    paddle->dy += paddle->speed - ball->fudge;
+  apply_match_command(&game->match, command);
+  if (command == COMMAND_START || command == COMMAND_RESET) {
+    snap_interpolation(game);
   }
 }
 
-/*  ---------------------------------------------------------------------- 
-    Description: Check for collision between the ball and the given paddle.
-    See https://www.jeffreythompson.org/collision-detection/rect-rect.php
-    for an explanation of collision algorithm.
-    If a collision is detected:
-      - play the paddle sound
-      - flip the ball's dx so it rebounds from the paddle
-      - update the ball's 'fudge' factor for the next collision
-      - call apply_english() to change the ball's speed or angle of return
+/*  ----------------------------------------------------------------------
+    Description: Step the game's match with step_match(), then play the
+    sounds of the paddle hits, wall hits and points it left in its events
     Parameters:
-      Ball* ball: pointer to game ball object
-      Paddle* paddle: pointer to player paddle
-    Returns: none
+      Game* game: pointer to the Game object
+      double time_step: elapsed time in seconds to simulate
+    Returns: Player who scored a point during this step, or NOBODY
     ---------------------------------------------------------------------- */
-void check_collision(Ball* ball, Paddle* paddle) {
-  bool collided =
-    ball->x + ball->w >= paddle->x &&   // ball right edge past paddle left edge
-    ball->x <= paddle->x + paddle->w && // ball left edge past paddle right edge
-    ball->y + ball->h >= paddle->y &&   // ball top edge past paddle bottom
-    ball->y <= paddle->y + paddle->h;   // ball bottom past paddle top
-
-  // bounce the ball off the paddle
-  if (collided) {
-    play_sound(ball->paddle_sound);
-    ball->dx *= -1;
-    ball->fudge = get_fudge();
-    // give player a chance to change the ball speed
-    apply_english(ball, paddle);
+Player step_game(Game* game, double time_step) {
+  Player scorer = step_match(&game->match, time_step);
+
+  EventBuffer* events = &game->match.events;
+  for (int i = 0; i < events->count; i++) {
+    switch (events->events[i].type) {
+    case EVENT_PADDLE_HIT:
+      play_sound(game->paddle_sound);
+      break;
+    case EVENT_WALL_HIT:
+      play_sound(game->wall_sound);
+      break;
+    case EVENT_POINT:
+      play_sound(game->point_sound);
+      break;
+    }
   }
+  return scorer;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Applies 'English' to the ball on rebound from the paddle.
-    Calculates a value based on which of 5 segments the ball makes contact:
-      - For the outermost segments 1 and 5 the ball's dy value is increased by 2.
-      - For the inner segments 2 and 4 the ball's dy value is increased by 1.
-      - For the middle segment 3 the ball's speed is increased by 10, up to 
-        BALL_MAX_SPEED.
-    Parameters:
-      Ball* ball: pointer to game ball object
-      Paddle* paddle: pointer to player paddle
+    Description: Copy the current ball and paddle states into the previous
+    states used for render interpolation, so the next frame is drawn 
+    without blending across a discontinuity such as a serve or reset.
+    Parameters: 
+      Game* game: pointer to the Game object
     Returns: none
+    ---------------------------------------------------------------------- */
+void snap_interpolation(Game* game) {
+  game->prev_player = game->match.player;
+  game->prev_robot = game->match.robot;
+  game->prev_ball = game->match.ball;
+}
 
-    'paddle_segment' is only used for display in the stats string
+/*  ---------------------------------------------------------------------- 
+    Description: Run one fixed simulation step: feed due replay commands,
+    step the game and count the tick. Interpolation is snapped across
+    serves and resets.
+    Parameters: 
+      Game* game: pointer to the Game object
+      double sim_step: fixed simulation step in seconds
+    Returns: Player who scored a point during this step, or NOBODY
+    ---------------------------------------------------------------------- */
+Player tick_game(Game* game, double sim_step) {
+  replay_feed(game->replay, game);
+
+  bool was_over = game->match.over;
+  snap_interpolation(game);
+  Player scorer = step_game(game, sim_step);
+  // serve or new game: don't interpolate from the old positions
+  if (was_over || scorer != NOBODY) {
+    snap_interpolation(game);
+  }
+  game->sim_ticks++;
+  return scorer;
+}
 
-    By a random 1 in 6 chance the function may return early without 
-    changing the ball.
+/*  ---------------------------------------------------------------------- 
+    Description: Advance the simulation in fixed steps of 1 / sim_hz seconds
+    for the real time elapsed since the previous call, measured with the 
+    high resolution performance counter. Leftover time is carried in the 
+    game's accumulator to the next frame.
+    Frame times are clamped to SIM_MAX_FRAME_TIME so a long stall (window
+    drag, debugger break) doesn't trigger a burst of catch-up steps.
+    In a network match each step goes through net_advance(), and time
+    spent stalled for the peer is dropped.
+    Parameters: 
+      Game* game: pointer to the Game object
+      double sim_step: fixed simulation step in seconds
+    Returns: interpolation factor between 0 and 1 for rendering between
+    the previous and current simulation states
     ---------------------------------------------------------------------- */
-void apply_english(Ball* ball, Paddle* paddle) {
-  // rand() % n == 0 is true n-1/n times, i.e. 5/6
-  if (rand() % 6 == 0) {
-    return;
+double advance_simulation(Game* game, double sim_step) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  double frame_time =
+    (now - game->sim_counter) / (double)SDL_GetPerformanceFrequency();
+  game->sim_counter = now;
+
+  if (frame_time > SIM_MAX_FRAME_TIME) {
+    frame_time = SIM_MAX_FRAME_TIME;
   }
-  // reset segment id
-  ball->paddle_segment = 0;
-
-  // divide paddle into 5 sections, apply angle and/or speed change
-  // for each section
-  int ball_top = ball->y;
-  int paddle_top = paddle->y;
-  int paddle_s1 = paddle->y + paddle->h / 5;
-  int paddle_s2 = paddle->y + (paddle->h / 5) * 2;
-  int paddle_s3 = paddle->y + (paddle->h / 5) * 3;
-  int paddle_s4 = paddle->y + (paddle->h / 5) * 4;
-  int paddle_bottom = paddle->y + paddle->h;
-
-  bool hit_s1 = ball_top >= paddle_top && ball_top <= paddle_s1;
-  bool hit_s2 = ball_top >= paddle_s1 && ball_top <= paddle_s2;
-  bool hit_s3 = ball_top >= paddle_s2 && ball_top <= paddle_s3;
-  bool hit_s4 = ball_top >= paddle_s3 && ball_top <= paddle_s4;
-  bool hit_s5 = ball_top >= paddle_s4 && ball_top <= paddle_bottom;
-
-  if (hit_s1) {
-    ball->dy -= 2;
-    ball->paddle_segment = 1;
-  }
-  if (hit_s2) {
-    ball->dy -= 1;
-    ball->paddle_segment = 2;
-  }
-  if (hit_s3) {
-    if (ball->speed < BALL_MAX_SPEED) {
-      ball->speed += 10;
+  game->sim_accumulator += frame_time;
+
+  while (game->sim_accumulator >= sim_step &&
+    !replay_finished(game->replay, game)) {
+    if (game->net == NULL) {
+      tick_game(game, sim_step);
+    } else if (!net_advance(game->net, game, net_local_input(), sim_step,
+      SDL_GetTicks())) {
+      // waiting for the peer: drop the time rather than catch up later
+      game->sim_accumulator = 0;
+      break;
     }
-    ball->paddle_segment = 3;
-  }
-  if (hit_s4) {
-    ball->dy += 1;
-    ball->paddle_segment = 4;
+    game->sim_accumulator -= sim_step;
   }
 
-  if (hit_s5) {
-    ball->dy += 2;
-    ball->paddle_segment = 5;
-  }
+  return game->sim_accumulator / sim_step;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Move the paddle up or down within the bounds of the court,
-    COURT_OFFSIDE at the top edge, or COURT_HEIGHT at the bottom edge. This
-    creates a buffer area at top and bottom of the court (delineated by white
-    lines) that allows the ball to occasionally sneak past the paddle. 
+    Description: Log win rates, rally lengths and throughput of a set of
+    headless matches
     Parameters: 
-      Paddle* paddle: pointer to player paddle
+      char* label: prefix for each log line, e.g. "Headless"
+      MatchStats* stats: pointer to the stats to log
+      double elapsed: wall clock seconds taken to play the matches
     Returns: none
     ---------------------------------------------------------------------- */
-void move_paddle(Paddle* paddle) {
-  paddle->y += paddle->dy * paddle->speed * paddle->time_step;
-  if (paddle->y < COURT_OFFSIDE) {
-    paddle->y = COURT_OFFSIDE;
+void log_match_stats(char* label, MatchStats* stats, double elapsed) {
+  double matches = stats->matches > 0 ? stats->matches : 1;
+  double points = stats->points > 0 ? stats->points : 1;
+  if (elapsed <= 0) {
+    elapsed = 1e-9;
   }
-  if (paddle->y + paddle->h > COURT_HEIGHT) {
-    paddle->y = COURT_HEIGHT - paddle->h;
+
+  SDL_LogInfo(LOGCAT,
+    "%s: %llu matches, player won %.1f%%, robot won %.1f%%, abandoned %llu",
+    label, (unsigned long long)stats->matches,
+    100.0 * stats->player_wins / matches, 100.0 * stats->robot_wins / matches,
+    (unsigned long long)stats->abandoned);
+  SDL_LogInfo(LOGCAT,
+    "%s: %llu points, average rally %.2f volleys, longest rally %d",
+    label, (unsigned long long)stats->points, stats->volleys / points,
+    stats->longest_rally);
+  if (stats->events > 0) {
+    SDL_LogInfo(LOGCAT,
+      "%s: %llu events in %.3f s, %.1f matches/sec, %.0f events/sec",
+      label, (unsigned long long)stats->events, elapsed,
+      stats->matches / elapsed, stats->events / elapsed);
+  } else {
+    SDL_LogInfo(LOGCAT,
+      "%s: %llu ticks in %.3f s, %.1f matches/sec, %.0f ticks/sec",
+      label, (unsigned long long)stats->ticks, elapsed,
+      stats->matches / elapsed, stats->ticks / elapsed);
   }
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Update the ball's x and y position to move it across the court.
-    The new positions are the product of the ball's dx, speed and the time_step
-    which adjusts the dx and speed to consitent frame independent motion.
-    If the ball's position intersects the court wall, the wall sound is played
-    and the ball's dy value is flipped so that it rebounds from the court wall.
+    Description: Run AI vs AI matches as fast as possible with a synthetic 
+    time step, without rendering, sound or frame rate cap, then log the 
+    throughput in matches/sec and ticks/sec.
     Parameters: 
-      Ball* ball: pointer to the game ball object
+      Game* game: pointer to the Game object
+      int matches: number of matches to play to MAX_SCORE
+      double time_step: simulated seconds per tick
+      bool event_driven: jump from ball event to ball event with
+      play_skip_match() instead of ticking, time_step is unused
     Returns: none
     ---------------------------------------------------------------------- */
-void move_ball(Ball* ball) {
-  ball->x += ball->dx * ball->speed * ball->time_step;
-  ball->y += ball->dy * ball->speed * ball->time_step;
-  // bounce off top and bottom
-  if (ball->y < 0 || ball->y + ball->h > SCREEN_HEIGHT) {
-    play_sound(ball->wall_sound);
-    ball->dy *= -1;
+void run_headless(Game* game, int matches, double time_step,
+  bool event_driven) {
+  MatchStats stats = {0};
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int match = 0; match < matches; match++) {
+    if (event_driven) {
+      play_skip_match(&game->match, &stats);
+    } else {
+      play_match(&game->match, time_step, &stats);
+    }
   }
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+
+  log_match_stats("Headless", &stats, elapsed);
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Renders the game scores stored in the ScoreBoard object
+    Description: Render the game with the software renderer into an
+    offscreen surface and capture every frame, as fast as possible. Plays
+    the replay if one is given, otherwise one AI vs AI match, until it ends
+    or the frame limit is reached. Each frame advances the simulation by
+    1 / SCREEN_FPS seconds of play, so the video runs at SCREEN_FPS.
+    Parameters: 
+      App* app: pointer to the App object, without a renderer
+      Options* options: command line options with the capture outputs
+    Returns: true if the frames were captured and the replay, if any,
+    played back as recorded
+    ---------------------------------------------------------------------- */
+bool run_offscreen(App* app, Options* options) {
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0,
+    SCREEN_WIDTH, SCREEN_HEIGHT, 32, CAPTURE_FORMAT);
+  app->renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL;
+  if (app->renderer == NULL) {
+    SDL_LogCritical(LOGCAT, "Offscreen renderer could not be created: %s",
+      SDL_GetError());
+    SDL_FreeSurface(surface);
+    return false;
+  }
+  if (TTF_Init() == -1) {
+    SDL_LogCritical(LOGCAT,
+      "SDL_ttf could not initialize! SDL_ttf Error: %s\n",
+      TTF_GetError());
+  }
+
+  Game game = {
+    .match = {
+      .winner = NOBODY,
+      .idle = true,
+      .over = false,
+    },
+    .score_font = load_font("VT323-Regular.ttf", SCORE_FONT_SIZE),
+    .stats_font = load_font("Inconsolata-Regular.ttf", STATS_FONT_SIZE),
+    .play_sounds = false,
+    .running = true,
+  };
+  load_atlases(app, &game);
+
+  Uint64 seed = options->seed;
+  int sim_hz = options->sim_hz;
+  game.match.fixed_point = options->fixed_point;
+  bool ok = true;
+  if (options->replay != NULL) {
+    game.replay = replay_open(options->replay);
+    ok = game.replay != NULL;
+    if (ok) {
+      seed = game.replay->seed;
+      sim_hz = game.replay->sim_hz;
+      game.match.fixed_point = game.replay->fixed_point;
+    }
+  }
+  new_game(&game, seed);
+  double sim_step = 1.0 / sim_hz;
+
+  app->capture = ok ? capture_open(app->renderer, options->capture,
+    options->capture_png, SCREEN_FPS, true) : NULL;
+  ok = app->capture != NULL;
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  game.fps_ticks = SDL_GetTicks();
+  while (ok) {
+    game.sim_accumulator += 1.0 / SCREEN_FPS;
+    while (game.sim_accumulator >= sim_step &&
+      !replay_finished(game.replay, &game)) {
+      tick_game(&game, sim_step);
+      game.sim_accumulator -= sim_step;
+    }
+    TRACE_ZONE("render") {
+      render_frame(app, &game, game.sim_accumulator / sim_step);
+    }
+    TRACE_ZONE("capture") {
+      capture_frame(app->capture, app->renderer);
+    }
+    game.frame_count++;
+
+    bool done = game.replay != NULL ?
+      replay_finished(game.replay, &game) : game.match.over;
+    if (done || (options->capture_frames > 0 &&
+      game.frame_count >= options->capture_frames)) {
+      break;
+    }
+  }
+  capture_close(app->capture);
+  app->capture = NULL;
+
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+  SDL_LogInfo(LOGCAT, "Offscreen: %d frames (%.1f s of play) in %.3f s",
+    game.frame_count, game.frame_count / (double)SCREEN_FPS, elapsed);
+  if (game.replay != NULL) {
+    ok = replay_close(game.replay, &game) && ok;
+  }
+
+  destroy_layers(app);
+  atlas_destroy(game.stats_atlas);
+  atlas_destroy(game.instructions_atlas);
+  atlas_destroy(game.score_atlas);
+  TTF_CloseFont(game.stats_font);
+  TTF_CloseFont(game.score_font);
+  TTF_Quit();
+  SDL_DestroyRenderer(app->renderer);
+  app->renderer = NULL;
+  SDL_FreeSurface(surface);
+  return ok;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Renders the game scores stored in the match's ScoreBoard
     Parameters: 
       App* app: pointer the App object
-      ScoreBoard* score_board: pointer to the ScoreBoard object
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void draw_score(App* app, ScoreBoard* score_board) {
+void draw_score(App* app, Game* game) {
   char score_text[SCREEN_FPS_BUF_SIZE];
   SDL_Color score_color = { .r = 255, .g = 255, .b = 255, .a = 255 };
+  ScoreBoard* score_board = &game->match.score_board;
+
+  if (game->score_atlas == NULL) {
+    return;
+  }
 
   snprintf(score_text, SCREEN_FPS_BUF_SIZE,
     "%.2d   %.2d", score_board->robot, score_board->player);
-  SDL_Surface* score_surface =
-    TTF_RenderText_Blended(score_board->font, score_text, score_color);
-  SDL_Texture* fps_texture =
-    SDL_CreateTextureFromSurface(app->renderer, score_surface);
 
   int w = 0;
   int h = 0;
-
-  TTF_SizeUTF8(score_board->font, score_text, &w, &h);
-  SDL_FreeSurface(score_surface);
-  score_surface = NULL;
+  atlas_measure(game->score_atlas, score_text, &w, &h);
 
   int text_x = (SCREEN_WIDTH - w) / 2;
-
-  SDL_Rect renderQuad = { text_x, COURT_OFFSIDE, w, h };
-  SDL_RenderCopyEx(
-    app->renderer, fps_texture, NULL, &renderQuad, 0, NULL, SDL_FLIP_NONE);
-  SDL_DestroyTexture(fps_texture);
-  fps_texture = NULL;
+  app->draw_calls += atlas_draw(app->renderer, game->score_atlas, score_text,
+    text_x, COURT_OFFSIDE, score_color);
 }
 
 /*  ---------------------------------------------------------------------- 
@@ -454,7 +874,6 @@ void draw_score(App* app, ScoreBoard* score_board) {
     Returns: none
     ---------------------------------------------------------------------- */
 void draw_instructions(App* app, Game* game) {
-  TTF_SetFontSize(game->score_board.font, 36);
   char* player_wins_text = "YAY!!! YOU WIN!!! :)\n\n";
   char* robot_wins_text = "AWWW!!! ROBOT WINS :(\n\n";
   char* instruction_text =
@@ -463,38 +882,31 @@ void draw_instructions(App* app, Game* game) {
     "PRESS S TO TOGGLE BEEPS\n"
     "PRESS Q TO QUIT";
 
+  if (game->instructions_atlas == NULL) {
+    return;
+  }
+
   char output_text[SCREEN_INSTRUCTIONS_BUF_SIZE] = "";
-  if (game->winner == PLAYER) {
+  if (game->match.winner == PLAYER) {
     strcat(output_text, player_wins_text);
   }
-  if (game->winner == ROBOT) {
+  if (game->match.winner == ROBOT) {
     strcat(output_text, robot_wins_text);
   }
 
   strcat(output_text, instruction_text);
 
   SDL_Color score_color = { .r = 255, .g = 255, .b = 255, .a = 255 };
-  SDL_Surface* output_surface =
-    TTF_RenderUTF8_Blended_Wrapped(
-      game->score_board.font, output_text, score_color, 0);
-  SDL_Texture* output_texture =
-    SDL_CreateTextureFromSurface(app->renderer, output_surface);
 
-  int w = output_surface->w;
-  int h = output_surface->h;
-
-  // TTF_SizeUTF8(font, output_text, &w, &h);
-  SDL_FreeSurface(output_surface);
-  output_surface = NULL;
+  int w = 0;
+  int h = 0;
+  atlas_measure(game->instructions_atlas, output_text, &w, &h);
 
   int text_x = (SCREEN_WIDTH - w) / 2;
   int text_y = SCREEN_MID_H - h / 2;
 
-  SDL_Rect renderQuad = { text_x, text_y, w, h };
-  SDL_RenderCopyEx(
-    app->renderer, output_texture, NULL, &renderQuad, 0, NULL, SDL_FLIP_NONE);
-  SDL_DestroyTexture(output_texture);
-  output_texture = NULL;
+  app->draw_calls += atlas_draw(app->renderer, game->instructions_atlas,
+    output_text, text_x, text_y, score_color);
 }
 
 /*  ---------------------------------------------------------------------- 
@@ -504,25 +916,128 @@ void draw_instructions(App* app, Game* game) {
     Returns: none
     ---------------------------------------------------------------------- */
 void draw_court(App* app) {
-  SDL_SetRenderDrawColor(app->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+  SDL_Color white = { .r = 0xFF, .g = 0xFF, .b = 0xFF, .a = 0xFF };
   SDL_Rect net_line = { .w = 3, .h = 15, .x = SCREEN_MID_W - 1 };
   for (net_line.y = COURT_OFFSIDE; net_line.y < SCREEN_HEIGHT - COURT_OFFSIDE;
     net_line.y += COURT_OFFSIDE) {
-    SDL_RenderFillRect(app->renderer, &net_line);
+    app->draw_calls += quads_add(&app->quads, app->renderer, &net_line, white);
   }
 
-  SDL_SetRenderDrawColor(app->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
   SDL_Rect court_line = { .w = SCREEN_WIDTH, .h = 1, .x = 0, .y = COURT_OFFSIDE };
-  SDL_RenderFillRect(app->renderer, &court_line);
+  app->draw_calls += quads_add(&app->quads, app->renderer, &court_line, white);
 
   court_line.y = SCREEN_HEIGHT - COURT_OFFSIDE;
-  SDL_RenderFillRect(app->renderer, &court_line);
+  app->draw_calls += quads_add(&app->quads, app->renderer, &court_line, white);
+
+  app->draw_calls += quads_flush(&app->quads, app->renderer);
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Render the court lines and net into an already bound
+    layer; adapts draw_court() to the LayerDraw signature.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: unused
+    Returns: none
+    ---------------------------------------------------------------------- */
+void draw_court_layer(App* app, Game* game) {
+  (void)game;
+  draw_court(app);
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Composite a cached layer onto the screen, first redrawing
+    it with the given draw function if it is dirty or its key changed.
+    Falls back to drawing straight to the screen when the renderer doesn't
+    support render targets.
+    Layer content is drawn onto transparent black with normal alpha 
+    blending, which leaves premultiplied color in the texture, so the layer
+    is composited with a premultiplied alpha blend mode.
+    Parameters: 
+      App* app: pointer to the App object
+      Layer* layer: pointer to the layer
+      int key: value identifying the layer content, e.g. the winner
+      LayerDraw draw: function that draws the layer content
+      Game* game: pointer to the Game object passed to draw
+    Returns: none
+    ---------------------------------------------------------------------- */
+void draw_layer(App* app, Layer* layer, int key, LayerDraw draw, Game* game) {
+  if (layer->texture == NULL && SDL_RenderTargetSupported(app->renderer)) {
+    layer->texture = SDL_CreateTexture(app->renderer,
+      SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+      SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (layer->texture == NULL) {
+      SDL_LogWarn(LOGCAT, "Layer texture could not be created: %s",
+        SDL_GetError());
+    } else {
+      SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        SDL_BLENDOPERATION_ADD);
+      if (SDL_SetTextureBlendMode(layer->texture, premultiplied) < 0) {
+        SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND);
+      }
+      layer->dirty = true;
+    }
+  }
+
+  if (layer->texture == NULL) {
+    draw(app, game);
+    return;
+  }
+
+  // draw calls made to redraw the layer count toward this frame
+  if (layer->dirty || layer->key != key) {
+    SDL_SetRenderTarget(app->renderer, layer->texture);
+    SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(app->renderer, 0x00, 0x00, 0x00, 0x00);
+    SDL_RenderClear(app->renderer);
+    app->draw_calls++;
+    SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_BLEND);
+    draw(app, game);
+    SDL_SetRenderTarget(app->renderer, NULL);
+    SDL_SetRenderDrawBlendMode(app->renderer, SDL_BLENDMODE_NONE);
+    layer->dirty = false;
+    layer->key = key;
+  }
+
+  SDL_RenderCopy(app->renderer, layer->texture, NULL, NULL);
+  app->draw_calls++;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Mark all cached layers dirty, e.g. after the renderer lost
+    the contents of its render targets
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void invalidate_layers(App* app) {
+  app->court_layer.dirty = true;
+  app->instructions_layer.dirty = true;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Destroy the textures of all cached layers. They are
+    recreated on next use.
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void destroy_layers(App* app) {
+  SDL_DestroyTexture(app->court_layer.texture);
+  app->court_layer.texture = NULL;
+  SDL_DestroyTexture(app->instructions_layer.texture);
+  app->instructions_layer.texture = NULL;
+  invalidate_layers(app);
 }
 
 /*  ---------------------------------------------------------------------- 
     Description: Render game stats in the offcourt area at the bottom of the 
-    screen. Stats are only of interest to game developers, so it is rendered
-    only when SDL Log priority is higher than SDL_LOG_PRIORITY_DEBUG
+    screen, and the draw calls of the previous frame at the top. Stats
+    are only of interest to game developers, so it is rendered only when
+    SDL Log priority is higher than SDL_LOG_PRIORITY_DEBUG
     Parameters: 
       App* app: pointer to the App object
       Game* game: pointer to the Game object
@@ -537,43 +1052,134 @@ void draw_stats(App* app, Game* game) {
   SDL_Color fps_color = { .r = 255, .g = 255, .b = 0, .a = 255 };
 
   double avg_fps = game->frame_count / ((SDL_GetTicks() - game->fps_ticks) / 1000.f);
+  Ball* ball = &game->match.ball;
   double velocity =
-    sqrt((game->ball.dx * game->ball.dx) + (game->ball.dy * game->ball.dy)) *
-    game->ball.speed;
+    sqrt((ball->dx * ball->dx) + (ball->dy * ball->dy)) * ball->speed;
 
   snprintf(fps_text, SCREEN_FPS_BUF_SIZE,
     "Avg FPS:%2.f Ball [dx:%2.f dy:%2.f] "
     "[x:%4.f y:%4.f] fudge:%2d speed: %d vel: %.f segment: %d",
-    avg_fps, game->ball.dx, game->ball.dy,
-    game->ball.x, game->ball.y, game->ball.fudge,
-    game->ball.speed, velocity, game->ball.paddle_segment);
-
-  SDL_Surface* fps_surface =
-    TTF_RenderText_Blended(game->stats_font, fps_text, fps_color);
-  SDL_Texture* fps_texture =
-    SDL_CreateTextureFromSurface(app->renderer, fps_surface);
-  int fps_w = fps_surface->w;
-  int fps_h = fps_surface->h;
-  SDL_FreeSurface(fps_surface);
-  fps_surface = NULL;
-
-  SDL_Rect renderQuad = { 10, 462, fps_w, fps_h };
-  SDL_RenderCopyEx(
-    app->renderer, fps_texture, NULL, &renderQuad, 0, NULL, SDL_FLIP_NONE);
-  SDL_DestroyTexture(fps_texture);
-  fps_texture = NULL;
+    avg_fps, ball->dx, ball->dy, ball->x, ball->y, ball->fudge,
+    ball->speed, velocity, ball->paddle_segment);
+
+  app->draw_calls +=
+    atlas_draw(app->renderer, game->stats_atlas, fps_text, 10, 462, fps_color);
+
+  if (app->pacer != NULL) {
+    Histogram* latency = &app->pacer->latency;
+    snprintf(fps_text, SCREEN_FPS_BUF_SIZE,
+      "Draw calls: %d Input latency p50:%5.1f ms p99:%5.1f ms",
+      app->last_draw_calls,
+      histogram_percentile(latency, 50) / 1000.0,
+      histogram_percentile(latency, 99) / 1000.0);
+  } else {
+    snprintf(fps_text, SCREEN_FPS_BUF_SIZE,
+      "Draw calls: %d", app->last_draw_calls);
+  }
+  app->draw_calls +=
+    atlas_draw(app->renderer, game->stats_atlas, fps_text, 10, 2, fps_color);
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Render a full frame: court, score, instructions when idle,
+    paddles and ball, and stats. Paddle and ball positions are interpolated
+    between the previous and current simulation states.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
+      double alpha: interpolation factor from advance_simulation()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void render_frame(App* app, Game* game, double alpha) {
+  SDL_Color white = { .r = 0xFF, .g = 0xFF, .b = 0xFF, .a = 0xFF };
+  app->draw_calls = 0;
+
+  //Clear screen
+  SDL_SetRenderDrawColor(app->renderer, 0x00, 0x00, 0x00, 0xFF);
+  SDL_RenderClear(app->renderer);
+  app->draw_calls++;
+
+  // the court and instructions never change while playing, so they are
+  // drawn once into cached layers
+  TRACE_ZONE("draw_court") {
+    draw_layer(app, &app->court_layer, 0, draw_court_layer, game);
+  }
+  TRACE_ZONE("draw_score") {
+    draw_score(app, game);
+  }
+  if (game->match.idle) {
+    TRACE_ZONE("draw_instructions") {
+      draw_layer(app, &app->instructions_layer, game->match.winner,
+        draw_instructions, game);
+    }
+  }
+
+  // paddles and ball are submitted together as one batch
+  TRACE_ZONE("draw_paddles_ball") {
+    Match* match = &game->match;
+    SDL_Rect player_rect = {
+      .h = match->player.h, .w = match->player.w,
+      .x = match->player.x,
+      .y = game->prev_player.y + (match->player.y - game->prev_player.y) * alpha
+    };
+    app->draw_calls +=
+      quads_add(&app->quads, app->renderer, &player_rect, white);
+
+    SDL_Rect robot_rect = {
+      .h = match->robot.h, .w = match->robot.w,
+      .x = match->robot.x,
+      .y = game->prev_robot.y + (match->robot.y - game->prev_robot.y) * alpha
+    };
+    app->draw_calls +=
+      quads_add(&app->quads, app->renderer, &robot_rect, white);
+
+    SDL_Rect ball_rect = {
+      .h = match->ball.h, .w = match->ball.w,
+      .x = game->prev_ball.x + (match->ball.x - game->prev_ball.x) * alpha,
+      .y = game->prev_ball.y + (match->ball.y - game->prev_ball.y) * alpha
+    };
+    app->draw_calls += quads_add(&app->quads, app->renderer, &ball_rect, white);
+    app->draw_calls += quads_flush(&app->quads, app->renderer);
+  }
+
+  TRACE_ZONE("draw_stats") {
+    draw_stats(app, game);
+  }
+  app->last_draw_calls = app->draw_calls;
+}
+
+/*  ---------------------------------------------------------------------- 
+    Description: Get the time available for one frame: the display refresh
+    interval when presents are paced by vsync, otherwise the frame cap
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: frame budget in seconds
+    ---------------------------------------------------------------------- */
+double frame_budget(App* app) {
+  SDL_DisplayMode mode;
+  if (app->vsync && SDL_GetWindowDisplayMode(app->window, &mode) == 0 &&
+    mode.refresh_rate > 0) {
+    return 1.0 / mode.refresh_rate;
+  }
+  return 1.0 / SCREEN_FPS;
 }
 
 /*  ---------------------------------------------------------------------- 
-    Description: Plays the given sound
+    Description: Plays the given sound. NULL sounds (e.g. in headless mode,
+    where no audio device is opened) are ignored.
     Parameters: 
       Mix_Chunk* sound: pointer to the Mix_Chunk sound object
     Returns: none
     ---------------------------------------------------------------------- */
 void play_sound(Mix_Chunk* sound) {
+  if (sound == NULL) {
+    return;
+  }
   Mix_PlayChannel(-1, sound, 0);
 }
 
+// tools/bench.c links the game without its entry point
+#ifndef PONG_NO_MAIN
 /*  ---------------------------------------------------------------------- 
     Description: Entry point to game execution
     Parameters: standard argc and argv. Note this main() is actually called by 
@@ -583,53 +1189,243 @@ void play_sound(Mix_Chunk* sound) {
     Returns: Exit status expected by platform
     ---------------------------------------------------------------------- */
 int main(int argc, char* argv[]) {
-  (void)argc, (void)argv;
+  Uint64 start = SDL_GetPerformanceCounter();
+  Options options;
+  if (!parse_options(argc, argv, &options)) {
+    return EXIT_FAILURE;
+  }
 
-  App* app = init();
+  if (options.trace != NULL) {
+    trace_init(options.trace);
+  }
+
+  pack_set_directory(options.assets);
+  App* app = init(&options);
 
   if (app == NULL) {
     SDL_LogCritical(LOGCAT, "App init failed!");
     return EXIT_FAILURE;
   }
+  // logged so any run can be reproduced with --seed
+  SDL_LogInfo(LOGCAT, "Random seed: %llu", (unsigned long long)options.seed);
+
+  if (app->headless && options.batch > 0) {
+    BatchKernel kernel = BATCH_KERNEL_AUTO;
+    batch_kernel_from_name(options.kernel, &kernel);
+    if (options.fixed_point) {
+      run_fixed_batch(options.batch, options.matches, options.time_step,
+        kernel, options.seed);
+    } else {
+      run_batch(options.batch, options.matches, options.time_step, kernel,
+        options.seed);
+    }
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return EXIT_SUCCESS;
+  }
+
+  if (app->headless && options.farm) {
+    run_farm(options.threads, options.matches, options.time_step,
+      options.seed, options.fixed_point, options.event_driven);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return EXIT_SUCCESS;
+  }
+
+  if (app->headless &&
+    (options.capture != NULL || options.capture_png != NULL)) {
+    bool ok = run_offscreen(app, &options);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (app->headless && options.net_test > 0) {
+    NetConfig config = { options.input_delay, options.rollback,
+      options.net_latency, options.net_jitter, options.net_loss };
+    bool ok = run_net_test(&config, options.net_test, options.seed,
+      options.sim_hz, options.fixed_point);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (app->headless && options.spectate_test > 0) {
+    bool ok = run_spectate_test(options.spectate_test, options.spectate_hz,
+      options.seed, options.sim_hz);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (app->headless && options.replay != NULL) {
+    bool ok = run_replay(options.replay);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (app->headless) {
+    Game game = {
+      .match = {
+        .winner = NOBODY,
+        .idle = true,
+        .over = false,
+      },
+      .play_sounds = false,
+      .running = true,
+    };
+    game.match.fixed_point = options.fixed_point;
+    rng_seed(&game.match.rng, options.seed);
+    trace_match(&game);
+    run_headless(&game, options.matches, options.time_step,
+      options.event_driven);
+    trace_shutdown();
+    free(app);
+    SDL_Quit();
+    return EXIT_SUCCESS;
+  }
 
   Game game = {
-    .score_board = {
-      .font = load_font("../assets/VT323-Regular.ttf", 40),
-      .player = 0,
-      .robot = 0
+    .match = {
+      .score_board = {
+        .player = 0,
+        .robot = 0
+      },
+      .winner = NOBODY,
+      .player = {0},
+      .robot = {0},
+      .ball = {0},
+      .idle = true,
+      .over = false,
     },
-    .winner = NOBODY,
-    .player = {0},
-    .robot = {0},
-    .ball = {0},
-    .stats_font = load_font("../assets/Inconsolata-Regular.ttf", 14),
+    .score_font = NULL,
+    .stats_font = NULL,
     .play_sounds = true,
     .running = true,
-    .idle = true,
-    .over = false,
   };
 
-  load_sounds(&game);
+  // a replay brings its own seed, simulation rate and physics
+  Uint64 seed = options.seed;
+  int sim_hz = options.sim_hz;
+  game.match.fixed_point = options.fixed_point;
+  if (options.replay != NULL) {
+    game.replay = replay_open(options.replay);
+    if (game.replay != NULL) {
+      seed = game.replay->seed;
+      sim_hz = game.replay->sim_hz;
+      game.match.fixed_point = game.replay->fixed_point;
+    }
+  } else if (options.record != NULL) {
+    game.replay = replay_create(options.record, seed, sim_hz,
+      game.match.fixed_point);
+  }
+  bool playback = replay_playing(game.replay);
+
+  // so does the host of a network match
+  if (options.net_host > 0 || options.net_join != NULL) {
+    NetConfig config = { options.input_delay, options.rollback,
+      options.net_latency, options.net_jitter, options.net_loss };
+    game.net = options.net_join != NULL ?
+      net_join(options.net_join, &config) :
+      net_host(options.net_host, seed, sim_hz, game.match.fixed_point, &config);
+    SDL_LogInfo(LOGCAT, "Waiting for the other player...");
+    Uint32 wait_start = SDL_GetTicks();
+    bool connected = false;
+    while (game.net != NULL && !connected) {
+      connected = net_connect(game.net, SDL_GetTicks());
+      SDL_PumpEvents();
+      if (SDL_QuitRequested() ||
+        SDL_GetTicks() - wait_start > NET_CONNECT_MS) {
+        break;
+      }
+      SDL_Delay(5);
+    }
+    if (!connected) {
+      SDL_LogCritical(LOGCAT, "No network match");
+      net_close(game.net, NULL);
+      loader_destroy(app->loader);
+      SDL_DestroyRenderer(app->renderer);
+      SDL_DestroyWindow(app->window);
+      free(app);
+      SDL_Quit();
+      return EXIT_FAILURE;
+    }
+    seed = game.net->seed;
+    sim_hz = game.net->sim_hz;
+    game.match.fixed_point = game.net->fixed_point;
+    game.match.versus = true;
+  }
 
-  reset_paddle(&game.player, PLAYER);
+  // a spectator only draws what the server sends
+  SpectateView* view = NULL;
+  if (options.spectate != NULL) {
+    view = spectate_connect(options.spectate);
+    if (view == NULL) {
+      SDL_LogCritical(LOGCAT, "Nothing to spectate");
+      loader_destroy(app->loader);
+      SDL_DestroyRenderer(app->renderer);
+      SDL_DestroyWindow(app->window);
+      free(app);
+      SDL_Quit();
+      return EXIT_FAILURE;
+    }
+  }
+  SpectateServer* spectators = NULL;
+  if (options.spectate_port > 0) {
+    spectators = spectate_start(options.spectate_port, options.spectate_hz,
+      options.spectate_max);
+  }
+  // paddles and starts come over the network instead
+  bool remote = game.net != NULL || view != NULL;
 
-  reset_paddle(&game.robot, ROBOT);
+  new_game(&game, seed);
 
-  reset_ball(&game.ball, ROBOT);
+  double sim_step = 1.0 / sim_hz;
+
+  Soak* soak = NULL;
+  if (options.soak != NULL) {
+    soak = soak_open(options.soak, frame_budget(app), options.soak_interval);
+  }
+  app->pacer = pacer_create(options.low_latency, app->vsync, frame_budget(app));
+  int capture_fps = (int)(1.0 / frame_budget(app) + 0.5);
+  if (options.capture != NULL || options.capture_png != NULL) {
+    app->capture = capture_open(app->renderer, options.capture,
+      options.capture_png, capture_fps, false);
+  }
 
   SDL_Event e;
   game.frame_count = 0;
   game.cap_ticks = 0;
-  game.step_ticks = 0;
   game.fps_ticks = SDL_GetTicks();
+  game.sim_counter = SDL_GetPerformanceCounter();
+  game.sim_accumulator = 0;
 
   while (game.running) {
+    // in low latency mode, wait here so input is polled just in time
+    TRACE_ZONE("pace") {
+      pacer_begin_frame(app->pacer);
+    }
     game.cap_ticks = SDL_GetTicks();
+    Uint64 frame_start = SDL_GetPerformanceCounter();
 
+    TRACE_ZONE("events")
     while (SDL_PollEvent(&e)) {
       if (e.type == SDL_QUIT) {
         game.running = false;
       }
+      if (e.type == SDL_RENDER_TARGETS_RESET) {
+        invalidate_layers(app);
+      }
+      if (e.type == SDL_RENDER_DEVICE_RESET) {
+        destroy_layers(app);
+      }
       if (e.type == SDL_KEYDOWN) {
         switch (e.key.keysym.sym) {
         case SDLK_q:
@@ -637,144 +1433,129 @@ int main(int argc, char* argv[]) {
           game.running = false;
           break;
         case SDLK_SPACE:
-          reset_game(&game);
-          game.idle = false;
+          if (!playback && !remote) {
+            apply_command(&game, COMMAND_START);
+          }
           break;
         case SDLK_r:
-          reset_game(&game);
+          if (!playback && !remote) {
+            apply_command(&game, COMMAND_RESET);
+          }
           break;
         case SDLK_l:
           set_log_priority(app);
           break;
         case SDLK_s:
+          // toggle sound effects
           game.play_sounds = !game.play_sounds;
+          // until the loader is done, take_assets() sets the volume
+          if (app->loader == NULL) {
+            Mix_Volume(-1, game.play_sounds ? MIX_MAX_VOLUME : 0);
+          }
+          break;
+        case SDLK_t:
+          trace_dump();
+          break;
+        case SDLK_F12:
+          if (app->capture == NULL) {
+            app->capture =
+              capture_open(app->renderer, NULL, NULL, capture_fps, false);
+          }
+          capture_screenshot(app->capture);
           break;
         default:
           break;
         }
       }
-      if (game.idle == false) {
-        handle_input(&e, &game.player);
+      if (game.match.idle == false && !playback && !remote &&
+        handle_input(&e, &game)) {
+        pacer_input(app->pacer, &e);
       }
     }
 
-    // toggle sound effects
-    if (game.play_sounds) {
-      Mix_Volume(-1, MIX_MAX_VOLUME);
-    } else {
-      Mix_Volume(-1, 0);
-    }
-
-    // reset game
-    if (game.over) {
-      reset_game(&game);
+    // swap in the fonts and sounds as soon as the loader is done
+    TRACE_ZONE("assets") {
+      take_assets(app, &game, start);
     }
-
-    if (game.idle) {
-      // let AI control player paddle
-      update_player(&game.ball, &game.player);
+    if (app->loader == NULL) {
+      sound_report();
     }
 
-    update_player(&game.ball, &game.robot);
-
-    check_collision(&game.ball, &game.player);
-    check_collision(&game.ball, &game.robot);
-
-    double time_step = (SDL_GetTicks() - game.step_ticks) / 1000.f;
-    game.ball.time_step = time_step;
-    game.player.time_step = time_step;
-    game.robot.time_step = time_step;
-
-    move_paddle(&game.player);
-    move_paddle(&game.robot);
-
-    // move ball
-    move_ball(&game.ball);
-
-    game.step_ticks = SDL_GetTicks();
-
-    // check for score
-    if (game.ball.x < 0) {
-      // Player scored
-      game.score_board.player++;
-      play_sound(game.point_sound);
-      if (game.score_board.player >= MAX_SCORE) {
-        game.over = true;
-        game.winner = PLAYER;
+    double alpha = 0;
+    TRACE_ZONE("simulate") {
+      if (view != NULL) {
+        if (spectate_receive(view) < 0) {
+          SDL_LogInfo(LOGCAT, "The spectator stream ended");
+          game.running = false;
+        }
+        spectate_apply(view, &game);
+        alpha = 1;
       } else {
-        reset_ball(&game.ball, PLAYER);
-        // game.ball.x = PLAYER_SERVICE_X;
-        game.ball.y = game.player.y + game.player.h / 2;
+        alpha = advance_simulation(&game, sim_step);
       }
     }
-
-    if (game.ball.x > SCREEN_WIDTH) {
-      // Robot scored
-      game.score_board.robot++;
-      play_sound(game.point_sound);
-      if (game.score_board.robot >= MAX_SCORE) {
-        game.over = true;
-        game.winner = ROBOT;
-      } else {
-        reset_ball(&game.ball, ROBOT);
-        game.ball.y = game.robot.y + game.robot.h / 2;
-      }
+    // the server samples the latest state at its own rate
+    spectate_publish(spectators, &game);
+    if (replay_finished(game.replay, &game)) {
+      game.running = false;
     }
 
-    //Clear screen
-    SDL_SetRenderDrawColor(app->renderer, 0x00, 0x00, 0x00, 0xFF);
-    SDL_RenderClear(app->renderer);
-
-    draw_court(app);
-    draw_score(app, &game.score_board);
-    if (game.idle) {
-      draw_instructions(app, &game);
+    TRACE_ZONE("render") {
+      render_frame(app, &game, alpha);
     }
 
-    SDL_SetRenderDrawColor(app->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-    // draw player paddle
-    SDL_Rect player_rect = {
-      .h = game.player.h, .w = game.player.w,
-      .x = game.player.x, .y = game.player.y
-    };
-    SDL_RenderFillRect(app->renderer, &player_rect);
-
-    // draw robot paddle
-    SDL_Rect robot_rect = {
-      .h = game.robot.h, .w = game.robot.w,
-      .x = game.robot.x, .y = game.robot.y
-    };
-    SDL_RenderFillRect(app->renderer, &robot_rect);
-
-    // draw ball
-    SDL_Rect ball_rect = {
-      .h = game.ball.h, .w = game.ball.w,
-      .x = game.ball.x, .y = game.ball.y
-    };
-    SDL_RenderFillRect(app->renderer, &ball_rect);
-
-    draw_stats(app, &game);
+    // read the frame back before presenting, the worker encodes it
+    TRACE_ZONE("capture") {
+      capture_frame(app->capture, app->renderer);
+    }
 
     // Update screen
-    SDL_RenderPresent(app->renderer);
+    Uint64 present_start = SDL_GetPerformanceCounter();
+    TRACE_ZONE("present") {
+      SDL_RenderPresent(app->renderer);
+    }
+    Uint64 present_end = SDL_GetPerformanceCounter();
+    if (game.frame_count == 0) {
+      SDL_LogInfo(LOGCAT, "First frame presented %.1f ms after start",
+        (present_end - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
     ++game.frame_count;
-
-    // Cap frame rate
-    game.frame_ticks = SDL_GetTicks() - game.cap_ticks;
-    if (game.frame_ticks < SCREEN_TICKS_PER_FRAME) {
-      SDL_Delay(SCREEN_TICKS_PER_FRAME - game.frame_ticks);
+    soak_frame(soak, frame_start, present_start, present_end);
+    pacer_end_frame(app->pacer, present_start, present_end);
+
+    // Cap frame rate when neither vsync nor the pacer paces presents
+    if (!app->vsync && (app->pacer == NULL || !app->pacer->low_latency)) {
+      game.frame_ticks = SDL_GetTicks() - game.cap_ticks;
+      if (game.frame_ticks < SCREEN_TICKS_PER_FRAME) {
+        TRACE_ZONE("delay") {
+          SDL_Delay(SCREEN_TICKS_PER_FRAME - game.frame_ticks);
+        }
+      }
     }
   }
 
+  replay_close(game.replay, &game);
+  net_close(game.net, game.net != NULL && game.net->hosting ? "Host" : "Guest");
+  spectate_stop(spectators);
+  spectate_disconnect(view);
+  loader_destroy(app->loader);
+  capture_close(app->capture);
+  soak_close(soak);
+  pacer_destroy(app->pacer);
+  trace_shutdown();
+  destroy_layers(app);
+  atlas_destroy(game.stats_atlas);
+  atlas_destroy(game.instructions_atlas);
+  atlas_destroy(game.score_atlas);
   TTF_CloseFont(game.stats_font);
-  TTF_CloseFont(game.score_board.font);
+  TTF_CloseFont(game.score_font);
   SDL_DestroyRenderer(app->renderer);
   SDL_DestroyWindow(app->window);
-  Mix_FreeChunk(game.ball.wall_sound);
-  Mix_FreeChunk(game.ball.paddle_sound);
+  Mix_FreeChunk(game.wall_sound);
+  Mix_FreeChunk(game.paddle_sound);
   Mix_FreeChunk(game.point_sound);
   TTF_Quit();
-  IMG_Quit();
   SDL_Quit();
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+#endif
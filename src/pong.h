@@ -3,121 +3,240 @@
 
 #include <SDL.h>
 #include <SDL_ttf.h>
-#include <SDL_image.h>
 #include <SDL_mixer.h>
 #include <math.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "atlas.h"
+#include "quads.h"
+#include "trace.h"
+#include "soak.h"
+#include "pacing.h"
+#include "sound.h"
+#include "pack.h"
+#include "loader.h"
+#include "capture.h"
+#include "core.h"
 
-#define SCREEN_WIDTH 640
-#define SCREEN_HEIGHT 480
-#define SCREEN_MID_W SCREEN_WIDTH / 2
-#define SCREEN_MID_H SCREEN_HEIGHT / 2
-#define COURT_OFFSIDE 20
-#define COURT_HEIGHT SCREEN_HEIGHT - COURT_OFFSIDE
 #define SCREEN_FPS_BUF_SIZE 100
 #define SCREEN_INSTRUCTIONS_BUF_SIZE 100
+#define SCORE_FONT_SIZE 40
+#define INSTRUCTIONS_FONT_SIZE 36
+#define STATS_FONT_SIZE 14
 #define SCREEN_FPS 60
 #define SCREEN_TICKS_PER_FRAME 1000 / SCREEN_FPS
+#define SIM_HZ 120
+#define SIM_MAX_FRAME_TIME 0.25
 
-#define BALL_SIZE 10
-#define BALL_MIN_SPEED 70
-#define BALL_MAX_SPEED 120
-#define PADDLE_W 10
-#define PADDLE_H 60
-#define PADDLE_SPEED 20
-#define PADDLE_Y SCREEN_MID_H - PADDLE_H / 2
-#define GOAL_OFFSET 15
-#define PLAYER_X SCREEN_WIDTH - PADDLE_W - GOAL_OFFSET
-#define ROBOT_X GOAL_OFFSET
-//                        | -1 |  BS  |   PW   |   GO   ||<- Screen Width
-#define PLAYER_SERVICE_X SCREEN_WIDTH - GOAL_OFFSET - PADDLE_W - BALL_SIZE - 1
-#define ROBOT_SERVICE_X PADDLE_W + GOAL_OFFSET + 1
-
-#define MAX_SCORE 20
+#define HEADLESS_MATCHES 100
+#define HEADLESS_TIME_STEP 1.0 / SCREEN_FPS
 
 #define LOGCAT SDL_LOG_CATEGORY_APPLICATION
 
+/*
+  A screen sized render target caching drawing that rarely changes. The
+  layer is redrawn only when it is dirty or its key (e.g. the winner shown
+  on the instructions screen) changes, and is otherwise composited with a
+  single copy per frame.
+*/
+typedef struct Layer Layer;
+struct Layer {
+  SDL_Texture* texture;
+  bool dirty;
+  int key;
+};
+
 typedef struct App App;
 struct App {
   SDL_Window* window;
   SDL_Renderer* renderer;
   SDL_LogPriority log_priority;
+  bool headless;
+  bool vsync;
+  Layer court_layer;
+  Layer instructions_layer;
+  QuadBatch quads;
+  int draw_calls;
+  int last_draw_calls;
+  Pacer* pacer;
+  Loader* loader;
+  Capture* capture;
 };
 
-typedef enum {
-  NOBODY,
-  PLAYER,
-  ROBOT
-} Player;
-
-typedef struct Ball Ball;
-struct Ball {
-  int speed;
-  double dx;
-  double dy;
-  double x;
-  double y;
-  int fudge;
-  int paddle_segment;
-  int h;
-  int w;
+typedef struct Options Options;
+struct Options {
+  bool headless;
+  int matches;
   double time_step;
-  Player service;
-  Mix_Chunk* wall_sound;
-  Mix_Chunk* paddle_sound;
+  int sim_hz;
+  int batch;
+  char* kernel;
+  bool farm;
+  int threads;
+  char* trace;
+  char* soak;
+  double soak_interval;
+  Uint64 seed;
+  char* record;
+  char* replay;
+  bool low_latency;
+  bool vsync;
+  int audio_buffer;
+  char* assets;
+  char* capture;
+  char* capture_png;
+  int capture_frames;
+  int net_host;
+  char* net_join;
+  double net_test;
+  int input_delay;
+  int rollback;
+  int net_latency;
+  int net_jitter;
+  double net_loss;
+  int spectate_port;
+  int spectate_hz;
+  int spectate_max;
+  char* spectate;
+  int spectate_test;
+  bool fixed_point;
+  bool event_driven;
 };
 
-typedef struct Paddle Paddle;
-struct Paddle {
-  Player owner;
-  int speed;
-  double time_step;
-  double dx;
-  double dy;
-  int fudge;
-  int h;
-  int w;
-  double x;
-  double y;
-};
-
-typedef struct ScoreBoard ScoreBoard;
-struct ScoreBoard {
-  int player;
-  int robot;
-  TTF_Font* font;
-};
+// defined in replay.h
+typedef struct Replay Replay;
+// defined in net.h
+typedef struct Net Net;
 
 typedef struct Game Game;
 struct Game {
-  ScoreBoard score_board;
-  Player winner;
-  Paddle player;
-  Paddle robot;
-  Ball ball;
+  // the simulation, see core.h
+  Match match;
+  // the match phase being traced, see trace_phase()
+  TraceZone phase_zone;
+  TTF_Font* score_font;
+  GlyphAtlas* score_atlas;
+  Paddle prev_player;
+  Paddle prev_robot;
+  Ball prev_ball;
   int frame_count;
   Uint32 frame_ticks;
   Uint32 cap_ticks;
-  Uint32 step_ticks;
   Uint32 fps_ticks;
+  Uint64 sim_counter;
+  double sim_accumulator;
+  Uint64 sim_ticks;
+  Replay* replay;
+  // two-player network match: the robot paddle is the remote player's
+  Net* net;
   TTF_Font* stats_font;
+  GlyphAtlas* stats_atlas;
+  GlyphAtlas* instructions_atlas;
+  Mix_Chunk* wall_sound;
+  Mix_Chunk* paddle_sound;
   Mix_Chunk* point_sound;
   bool play_sounds;
   bool running;
-  bool idle;
-  bool over;
 };
 
+/*  ---------------------------------------------------------------------- 
+    Description: Log win rates, rally lengths and throughput of a set of
+    headless matches
+    Parameters: 
+      char* label: prefix for each log line, e.g. "Headless"
+      MatchStats* stats: pointer to the stats to log
+      double elapsed: wall clock seconds taken to play the matches
+    Returns: none
+    ---------------------------------------------------------------------- */
+void log_match_stats(char* label, MatchStats* stats, double elapsed);
+
+typedef void (*LayerDraw)(App* app, Game* game);
+
 /*  ----------------------------------------------------------------------
     Description: initialize SDL systems
-    Parameters: none
+    Parameters:
+      Options* options: command line options. With headless set, only the
+      SDL core is initialized; no window, renderer, fonts or audio device
+      are created. Otherwise the video subsystem, window and renderer are
+      created here, and the fonts and audio device are left to the loader
+      thread started before the window, see take_assets(). vsync and
+      audio_buffer configure the renderer and the audio device.
     Returns: App object containing initialized SDL_Window and SDL_Renderer
     objects.
 */
-App* init(void);
+App* init(Options* options);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Parse command line arguments into an Options object.
+    Recognized arguments:
+      --headless          run matches without video, audio or frame cap
+      --matches N         number of matches to run in headless mode
+      --time-step S       synthetic time step in seconds for headless mode
+      --sim-hz N          fixed simulation rate in steps per second
+      --batch N           with --headless, run N concurrent matches in the
+                          structure-of-arrays batch simulator
+      --kernel NAME       batch kernel: auto, scalar, sse2 or avx2
+      --farm              with --headless, spread matches over all cores
+      --threads N         number of farm worker threads, 0 for one per CPU
+      --trace FILE        record timing zones and write them to FILE as
+                          Chrome trace-event JSON on exit or on 'T'
+      --soak FILE         append frame time percentiles and hitch counts
+                          to FILE as JSON lines
+      --soak-interval S   seconds per soak window
+      --seed N            random seed, default is the current time
+      --record FILE       record the seed and player input to a replay file,
+                          not with --headless
+      --replay FILE       play a replay file back, as fast as possible
+                          with --headless
+      --low-latency       poll input as late as possible before each frame
+      --no-vsync          don't wait for the display when presenting
+      --audio-buffer N    audio buffer in sample frames, a power of two;
+                          default 2048, or 512 with --low-latency
+      --assets DIR        load fonts from DIR instead of the built-in pack
+      --capture FILE      stream every frame to FILE as Y4M video
+      --capture-png PRE   save every frame to PRE_000001.png, ...
+      --capture-frames N  with --headless, stop capturing after N frames
+      --host PORT         host a two-player match on UDP PORT, 1 to 65535,
+                          and play the right paddle
+      --join HOST[:PORT]  join the match hosted by HOST (default port
+                          7777) and play the left paddle
+      --input-delay N     ticks each local input is delayed, 0 to 10
+                          (default 2)
+      --rollback N        most ticks predicted ahead of the remote input,
+                          1 to 30 (default 12)
+      --net-latency MS    delay what this side sends by MS, 0 or more
+      --net-jitter MS     add up to MS of random delay, 0 or more
+      --net-loss PCT      drop PCT percent of what this side sends, 0 to
+                          100. Network matches can't be recorded or
+                          replayed
+      --net-test S        with --headless implied, play a host and a
+                          guest over loopback for S seconds of random
+                          input, failing on a desync
+      --spectate-port PORT
+                          broadcast the game to spectators on TCP PORT,
+                          1 to 65535
+      --spectate-hz N     broadcasts per second, 1 to 1000 (default 60)
+      --spectate-max N    most spectators at once, 1 to 65536 (default
+                          1024)
+      --spectate HOST[:PORT]
+                          watch the game broadcast by HOST (default port
+                          7778); it only watches, so not with --host,
+                          --join, --record or --replay
+      --spectate-test N   with --headless implied, broadcast an AI vs AI
+                          game to N spectators over loopback for 10
+                          seconds, N up to 65536
+      --fixed-point       move the ball and paddles in 16.16 fixed point,
+                          for results that are the same on every machine
+      --event-driven      with --headless, jump from one ball event to the
+                          next instead of ticking
+    Parameters: 
+      int argc, char* argv[]: command line arguments from main()
+      Options* options: pointer to Options object to fill in
+    Returns: true if all arguments were recognized, otherwise false
+    ---------------------------------------------------------------------- */
+bool parse_options(int argc, char* argv[], Options* options);
 
 
 /*  ---------------------------------------------------------------------- 
@@ -130,148 +249,174 @@ App* init(void);
 void set_log_priority(App* app);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Load WAV sound assets
-    Parameters: Game object
-    Returns: none
+    Description: Once the loader thread is done, take its fonts and sound
+    effects into the game, build the glyph atlases and free the loader.
+    Until then the game runs without text and sound. Does nothing while
+    the loader is still busy or after the assets were taken.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
+      Uint64 start: performance counter at the start of main()
+    Returns: true if the assets were taken by this call
     ---------------------------------------------------------------------- */
-void load_sounds(Game* game);
+bool take_assets(App* app, Game* game, Uint64 start);
 
 /*  ---------------------------------------------------------------------- 
-    Description: load ttf font from specified file at specified size
+    Description: load ttf font from the asset pack at specified size. The
+    font is read in place from the packed bytes, see pack_open().
     Parameters: 
-      char* path: path to TTF font file
+      const char* name: file name of the TTF font asset
       int size:   display size of font in pixels
     Returns: TTF_font* pointer to font object
     ---------------------------------------------------------------------- */
-TTF_Font* load_font(char* path, int size);
+TTF_Font* load_font(const char* name, int size);
 
 
 /*  ---------------------------------------------------------------------- 
-    Description: Reset Game object to defaults for new game
-    Parameters: Game* game - game object
+    Description: Build the glyph atlases for the score, instructions and
+    stats text from the game's fonts
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_game(Game* game);
+void load_atlases(App* app, Game* game);
 
-/*  ---------------------------------------------------------------------- 
-    Description: Reset specified Paddle object to defaults for given Player
-    Parameters: 
-      Paddle* paddle: pointer to player paddle
-      Player* owner: owner of paddle (either PLAYER or ROBOT), 
-      determines x position of paddle on court
+/*  ----------------------------------------------------------------------
+    Description: Match phase hook that times each phase of step_match()
+    as a trace zone. Phases don't nest, so one open zone is enough.
+    Parameters:
+      const char* name: phase name, a string literal
+      bool begin: true as the phase begins, false as it ends
+      void* ctx: pointer to the TraceZone holding the open phase
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_paddle(Paddle* paddle, Player owner);
+void trace_phase(const char* name, bool begin, void* ctx);
 
-/*  ---------------------------------------------------------------------- 
-    Description: Reset Ball object to defaults. Sets the ball's initial
-    dx, dy and 'fudge' to random values within a specified range.
-    Parameters:   
-      Ball* ball: ball object
-      Player server: player serving ball, determines the position and direction
-      of the ball for service.
+/*  ----------------------------------------------------------------------
+    Description: Time the phases of the game's match with trace_phase()
+    when tracing is enabled. Without tracing the match has no hook and
+    steps as fast as in the farm.
+    Parameters:
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void reset_ball(Ball* ball, Player server);
+void trace_match(Game* game);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Generate a random 'fudge' value between 0 and 14 
-    that affects a paddle's movement speed, either increasing or decreasing 
-    the paddle's y axis motion
-    Parameters: none
-    Returns: int fudge value
+    Description: Seed the game and serve the first ball of an idle game.
+    A recorded game and its replay start from this same state.
+    Parameters: 
+      Game* game: pointer to the Game object
+      Uint64 seed: random seed
+    Returns: none
     ---------------------------------------------------------------------- */
-int get_fudge(void);
+void new_game(Game* game, Uint64 seed);
 
 /*  ---------------------------------------------------------------------- 
     Description: Handle Up and Down key presses for player paddle motion. 
     Paddle moves as long as key is held down. 
     Parameters: 
       SDL_Event* e: pointer to SDL Event object
-      Paddle* paddle: pointer to player paddle object
-    Returns: none
+      Game* game: pointer to the Game object
+    Returns: true if the event started or stopped paddle motion
     ---------------------------------------------------------------------- */
-void handle_input(SDL_Event* e, Paddle* paddle);
+bool handle_input(SDL_Event* e, Game* game);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Updates the paddle oject's dy value to move the paddle 
-    toward the game ball's position. The dy value is set to the paddle speed 
-    minus the 'fudge' factor, which may speed up or slow down the paddle.
-    Called by the Robot paddle when in play state. Called by both player and
-    robot paddles when game is in Idle state, to simulate a game.
+    Description: Apply one player command to the game. All input that
+    changes the simulation goes through here, so it can be recorded into
+    the game's replay and fed back from it.
     Parameters: 
-      Ball* ball: the game ball
-      Paddle* paddle: the paddle object
+      Game* game: pointer to the Game object
+      Command command: command to apply
     Returns: none
     ---------------------------------------------------------------------- */
-void update_player(Ball* ball, Paddle* paddle);
+void apply_command(Game* game, Command command);
 
-/*  ---------------------------------------------------------------------- 
-    Description: Check for collision between the ball and the given paddle.
-    See https://www.jeffreythompson.org/collision-detection/rect-rect.php
-    for an explanation of collision algorithm.
-    If a collision is detected:
-      - play the paddle sound
-      - flip the ball's dx so it rebounds from the paddle
-      - update the ball's 'fudge' factor for the next collision
-      - call apply_english() to change the ball's speed or angle of return
+/*  ----------------------------------------------------------------------
+    Description: Step the game's match with step_match(), then play the
+    sounds of the paddle hits, wall hits and points it left in its events
     Parameters:
-      Ball* ball: pointer to game ball object
-      Paddle* paddle: pointer to player paddle
-    Returns: none
+      Game* game: pointer to the Game object
+      double time_step: elapsed time in seconds to simulate
+    Returns: Player who scored a point during this step, or NOBODY
     ---------------------------------------------------------------------- */
-void check_collision(Ball* ball, Paddle* paddle);
+Player step_game(Game* game, double time_step);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Applies 'English' to the ball on rebound from the paddle.
-    Calculates a value based on which of 5 segments the ball makes contact:
-      - For the outermost segments 1 and 5 the ball's dy value is increased by 2.
-      - For the inner segments 2 and 4 the ball's dy value is increased by 1.
-      - For the middle segment 3 the ball's speed is increased by 10, up to 
-        BALL_MAX_SPEED.
-    Parameters:
-      Ball* ball: pointer to game ball object
-      Paddle* paddle: pointer to player paddle
+    Description: Copy the current ball and paddle states into the previous
+    states used for render interpolation, so the next frame is drawn 
+    without blending across a discontinuity such as a serve or reset.
+    Parameters: 
+      Game* game: pointer to the Game object
     Returns: none
+    ---------------------------------------------------------------------- */
+void snap_interpolation(Game* game);
 
-    'paddle_segment' is only used for display in the stats string
+/*  ---------------------------------------------------------------------- 
+    Description: Run one fixed simulation step: feed due replay commands,
+    step the game and count the tick. Interpolation is snapped across
+    serves and resets.
+    Parameters: 
+      Game* game: pointer to the Game object
+      double sim_step: fixed simulation step in seconds
+    Returns: Player who scored a point during this step, or NOBODY
+    ---------------------------------------------------------------------- */
+Player tick_game(Game* game, double sim_step);
 
-    By a random 1 in 6 chance the function may return early without 
-    changing the ball.
+/*  ---------------------------------------------------------------------- 
+    Description: Advance the simulation in fixed steps of 1 / sim_hz seconds
+    for the real time elapsed since the previous call, measured with the 
+    high resolution performance counter. Leftover time is carried in the 
+    game's accumulator to the next frame.
+    In a network match each step goes through net_advance(), and time
+    spent stalled for the peer is dropped.
+    Parameters: 
+      Game* game: pointer to the Game object
+      double sim_step: fixed simulation step in seconds
+    Returns: interpolation factor between 0 and 1 for rendering between
+    the previous and current simulation states
     ---------------------------------------------------------------------- */
-void apply_english(Ball* ball, Paddle* paddle);
+double advance_simulation(Game* game, double sim_step);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Move the paddle up or down within the bounds of the court,
-    COURT_OFFSIDE at the top edge, or COURT_HEIGHT at the bottom edge. This
-    creates a buffer area at top and bottom of the court (delineated by white
-    lines) that allows the ball to occasionally sneak past the paddle. 
+    Description: Run AI vs AI matches as fast as possible with a synthetic 
+    time step, without rendering, sound or frame rate cap, then log the 
+    throughput in matches/sec and ticks/sec.
     Parameters: 
-      Paddle* paddle: pointer to player paddle
+      Game* game: pointer to the Game object
+      int matches: number of matches to play to MAX_SCORE
+      double time_step: simulated seconds per tick
+      bool event_driven: jump from ball event to ball event with
+      play_skip_match() instead of ticking, time_step is unused
     Returns: none
     ---------------------------------------------------------------------- */
-void move_paddle(Paddle* paddle);
+void run_headless(Game* game, int matches, double time_step,
+  bool event_driven);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Update the ball's x and y position to move it across the court.
-    The new positions are the product of the ball's dx, speed and the time_step
-    which adjusts the dx and speed to consitent frame independent motion.
-    If the ball's position intersects the court wall, the wall sound is played
-    and the ball's dy value is flipped so that it rebounds from the court wall.
+    Description: Render the game with the software renderer into an
+    offscreen surface and capture every frame, as fast as possible. Plays
+    the replay if one is given, otherwise one AI vs AI match, until it ends
+    or the frame limit is reached. Each frame advances the simulation by
+    1 / SCREEN_FPS seconds of play, so the video runs at SCREEN_FPS.
     Parameters: 
-      Ball* ball: pointer to the game ball object
-    Returns: none
+      App* app: pointer to the App object, without a renderer
+      Options* options: command line options with the capture outputs
+    Returns: true if the frames were captured and the replay, if any,
+    played back as recorded
     ---------------------------------------------------------------------- */
-void move_ball(Ball* ball);
+bool run_offscreen(App* app, Options* options);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Renders the game scores stored in the ScoreBoard object
+    Description: Renders the game scores stored in the match's ScoreBoard
     Parameters: 
       App* app: pointer the App object
-      ScoreBoard* score_board: pointer to the ScoreBoard object
+      Game* game: pointer to the Game object
     Returns: none
     ---------------------------------------------------------------------- */
-void draw_score(App* app, ScoreBoard* score_board);
+void draw_score(App* app, Game* game);
 
 /*  ---------------------------------------------------------------------- 
     Description: Renders the game instructions on startup. When the game is
@@ -291,10 +436,54 @@ void draw_instructions(App* app, Game* game);
     ---------------------------------------------------------------------- */
 void draw_court(App* app);
 
+/*  ---------------------------------------------------------------------- 
+    Description: Render the court lines and net into an already bound
+    layer; adapts draw_court() to the LayerDraw signature.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: unused
+    Returns: none
+    ---------------------------------------------------------------------- */
+void draw_court_layer(App* app, Game* game);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Composite a cached layer onto the screen, first redrawing
+    it with the given draw function if it is dirty or its key changed.
+    Falls back to drawing straight to the screen when the renderer doesn't
+    support render targets.
+    Parameters: 
+      App* app: pointer to the App object
+      Layer* layer: pointer to the layer
+      int key: value identifying the layer content, e.g. the winner
+      LayerDraw draw: function that draws the layer content
+      Game* game: pointer to the Game object passed to draw
+    Returns: none
+    ---------------------------------------------------------------------- */
+void draw_layer(App* app, Layer* layer, int key, LayerDraw draw, Game* game);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Mark all cached layers dirty, e.g. after the renderer lost
+    the contents of its render targets
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void invalidate_layers(App* app);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Destroy the textures of all cached layers. They are
+    recreated on next use.
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void destroy_layers(App* app);
+
 /*  ---------------------------------------------------------------------- 
     Description: Render game stats in the offcourt area at the bottom of the 
-    screen. Stats are only of interest to game developers, so it is rendered
-    only when SDL Log priority is higher than SDL_LOG_PRIORITY_DEBUG
+    screen, and the draw calls of the previous frame at the top. Stats
+    are only of interest to game developers, so it is rendered only when
+    SDL Log priority is higher than SDL_LOG_PRIORITY_DEBUG
     Parameters: 
       App* app: pointer to the App object
       Game* game: pointer to the Game object
@@ -303,7 +492,29 @@ void draw_court(App* app);
 void draw_stats(App* app, Game* game);
 
 /*  ---------------------------------------------------------------------- 
-    Description: Plays the given sound
+    Description: Render a full frame: court, score, instructions when idle,
+    paddles and ball, and stats. Paddle and ball positions are interpolated
+    between the previous and current simulation states.
+    Parameters: 
+      App* app: pointer to the App object
+      Game* game: pointer to the Game object
+      double alpha: interpolation factor from advance_simulation()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void render_frame(App* app, Game* game, double alpha);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Get the time available for one frame: the display refresh
+    interval when presents are paced by vsync, otherwise the frame cap
+    Parameters: 
+      App* app: pointer to the App object
+    Returns: frame budget in seconds
+    ---------------------------------------------------------------------- */
+double frame_budget(App* app);
+
+/*  ---------------------------------------------------------------------- 
+    Description: Plays the given sound. NULL sounds (e.g. in headless mode,
+    where no audio device is opened) are ignored.
     Parameters: 
       Mix_Chunk* sound: pointer to the Mix_Chunk sound object
     Returns: none
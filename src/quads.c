@@ -0,0 +1,71 @@
+// Batched solid color rectangle rendering
+#include "quads.h"
+
+/*  ----------------------------------------------------------------------
+    Description: Prepare an empty quad batch
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void quads_init(QuadBatch* quads) {
+  quads->count = 0;
+  // two triangles per quad, the index pattern never changes
+  for (int q = 0; q < QUAD_BATCH_MAX; q++) {
+    int* index = &quads->indices[q * 6];
+    index[0] = q * 4;
+    index[1] = q * 4 + 1;
+    index[2] = q * 4 + 2;
+    index[3] = q * 4 + 2;
+    index[4] = q * 4 + 3;
+    index[5] = q * 4;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Add a solid colored rectangle to the batch. The batch is
+    flushed first if it is full.
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+      SDL_Renderer* renderer: renderer used if the batch must be flushed
+      const SDL_Rect* rect: rectangle to fill
+      SDL_Color color: fill color
+    Returns: number of draw calls submitted, 0 or 1
+    ---------------------------------------------------------------------- */
+int quads_add(QuadBatch* quads, SDL_Renderer* renderer,
+  const SDL_Rect* rect, SDL_Color color) {
+  int calls = 0;
+  if (quads->count == QUAD_BATCH_MAX) {
+    calls = quads_flush(quads, renderer);
+  }
+
+  float x0 = rect->x;
+  float y0 = rect->y;
+  float x1 = rect->x + rect->w;
+  float y1 = rect->y + rect->h;
+
+  SDL_Vertex* v = &quads->vertices[quads->count * 4];
+  v[0] = (SDL_Vertex){ { x0, y0 }, color, { 0, 0 } };
+  v[1] = (SDL_Vertex){ { x1, y0 }, color, { 0, 0 } };
+  v[2] = (SDL_Vertex){ { x1, y1 }, color, { 0, 0 } };
+  v[3] = (SDL_Vertex){ { x0, y1 }, color, { 0, 0 } };
+  quads->count++;
+  return calls;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Submit all rectangles in the batch with one draw call and
+    empty the batch
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+      SDL_Renderer* renderer: renderer to draw with
+    Returns: number of draw calls submitted, 0 or 1
+    ---------------------------------------------------------------------- */
+int quads_flush(QuadBatch* quads, SDL_Renderer* renderer) {
+  if (quads->count == 0) {
+    return 0;
+  }
+  SDL_RenderGeometry(renderer, NULL, quads->vertices, quads->count * 4,
+    quads->indices, quads->count * 6);
+  quads->count = 0;
+  return 1;
+}
@@ -0,0 +1,52 @@
+#ifndef QUADS_H
+#define QUADS_H
+
+#include <SDL.h>
+
+#define QUAD_BATCH_MAX 256
+
+/*
+  Per-frame batch of solid colored rectangles. Rectangles are collected
+  as colored vertices and submitted together with one SDL_RenderGeometry()
+  call, instead of one SDL_SetRenderDrawColor() and SDL_RenderFillRect()
+  round trip each.
+*/
+typedef struct QuadBatch QuadBatch;
+struct QuadBatch {
+  int count;
+  SDL_Vertex vertices[QUAD_BATCH_MAX * 4];
+  int indices[QUAD_BATCH_MAX * 6];
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Prepare an empty quad batch
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+    Returns: none
+    ---------------------------------------------------------------------- */
+void quads_init(QuadBatch* quads);
+
+/*  ----------------------------------------------------------------------
+    Description: Add a solid colored rectangle to the batch. The batch is
+    flushed first if it is full.
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+      SDL_Renderer* renderer: renderer used if the batch must be flushed
+      const SDL_Rect* rect: rectangle to fill
+      SDL_Color color: fill color
+    Returns: number of draw calls submitted, 0 or 1
+    ---------------------------------------------------------------------- */
+int quads_add(QuadBatch* quads, SDL_Renderer* renderer,
+  const SDL_Rect* rect, SDL_Color color);
+
+/*  ----------------------------------------------------------------------
+    Description: Submit all rectangles in the batch with one draw call and
+    empty the batch
+    Parameters:
+      QuadBatch* quads: pointer to the batch
+      SDL_Renderer* renderer: renderer to draw with
+    Returns: number of draw calls submitted, 0 or 1
+    ---------------------------------------------------------------------- */
+int quads_flush(QuadBatch* quads, SDL_Renderer* renderer);
+
+#endif
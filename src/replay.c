@@ -0,0 +1,298 @@
+// Input recording and deterministic replay
+#include "replay.h"
+#include <limits.h>
+#include <string.h>
+
+/*  ----------------------------------------------------------------------
+    Write an unsigned varint: 7 bits per byte, low bits first, high bit
+    set on all but the last byte
+    ---------------------------------------------------------------------- */
+static void write_varint(FILE* file, Uint64 value) {
+  while (value >= 0x80) {
+    fputc((int)(value & 0x7F) | 0x80, file);
+    value >>= 7;
+  }
+  fputc((int)value, file);
+}
+
+/*  ----------------------------------------------------------------------
+    Read an unsigned varint. Returns false at end of file or if the value
+    doesn't fit 64 bits.
+    ---------------------------------------------------------------------- */
+static bool read_varint(FILE* file, Uint64* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = fgetc(file);
+    if (c == EOF) {
+      return false;
+    }
+    *value |= (Uint64)(c & 0x7F) << shift;
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Create a replay file to record a new game into
+    Parameters:
+      const char* path: file to write
+      Uint64 seed: seed the game is started with by new_game()
+      int sim_hz: simulation steps per second
+      bool fixed_point: the game runs fixed point physics
+    Returns: Replay* pointer to the recording replay, or NULL on failure
+    ---------------------------------------------------------------------- */
+Replay* replay_create(const char* path, Uint64 seed, int sim_hz,
+  bool fixed_point) {
+  Replay* replay = calloc(1, sizeof(Replay));
+  if (replay == NULL) {
+    return NULL;
+  }
+  replay->file = fopen(path, "wb");
+  if (replay->file == NULL) {
+    SDL_LogError(LOGCAT, "Failed to create replay file '%s'", path);
+    free(replay);
+    return NULL;
+  }
+  replay->seed = seed;
+  replay->sim_hz = sim_hz;
+  replay->fixed_point = fixed_point;
+
+  fwrite(REPLAY_MAGIC, 1, 4, replay->file);
+  fputc(REPLAY_VERSION, replay->file);
+  write_varint(replay->file, seed);
+  write_varint(replay->file, sim_hz);
+  write_varint(replay->file, fixed_point ? REPLAY_FIXED_POINT : 0);
+  SDL_LogInfo(LOGCAT, "Recording replay to %s", path);
+  return replay;
+}
+
+/*  ----------------------------------------------------------------------
+    Read ahead the next command, or the end record
+    ---------------------------------------------------------------------- */
+static void read_next(Replay* replay) {
+  Uint64 record;
+  if (!read_varint(replay->file, &record)) {
+    // recording didn't finish (e.g. the game crashed), play what we have
+    SDL_LogWarn(LOGCAT, "Replay ends without a final state");
+    replay->ended = true;
+    replay->end_tick = replay->last_tick;
+    return;
+  }
+
+  replay->next_command = record & ((1 << REPLAY_COMMAND_BITS) - 1);
+  replay->next_tick = replay->last_tick + (record >> REPLAY_COMMAND_BITS);
+  replay->last_tick = replay->next_tick;
+
+  if (replay->next_command == COMMAND_NONE) {
+    replay->ended = true;
+    replay->end_tick = replay->next_tick;
+    replay->checked = read_varint(replay->file, &replay->end_player) &&
+      read_varint(replay->file, &replay->end_robot) &&
+      read_varint(replay->file, &replay->end_hash);
+  } else if (replay->next_command >= COMMAND_COUNT) {
+    SDL_LogWarn(LOGCAT, "Replay has unknown command %d, stopping there",
+      replay->next_command);
+    replay->ended = true;
+    replay->end_tick = replay->next_tick;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Open a replay file for playback. Start the game with
+    new_game() using the replay's seed and physics and step it at its
+    sim_hz.
+    Parameters:
+      const char* path: file to read
+    Returns: Replay* pointer to the replay, or NULL if the file can't be
+    read or isn't a replay
+    ---------------------------------------------------------------------- */
+Replay* replay_open(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    SDL_LogError(LOGCAT, "Failed to open replay file '%s'", path);
+    return NULL;
+  }
+
+  char magic[4];
+  Uint64 seed = 0;
+  Uint64 sim_hz = 0;
+  Uint64 flags = 0;
+  if (fread(magic, 1, 4, file) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+    fgetc(file) != REPLAY_VERSION ||
+    !read_varint(file, &seed) || !read_varint(file, &sim_hz) ||
+    !read_varint(file, &flags) || sim_hz < 1 || sim_hz > INT_MAX) {
+    SDL_LogError(LOGCAT, "'%s' is not a version %d replay file",
+      path, REPLAY_VERSION);
+    fclose(file);
+    return NULL;
+  }
+
+  Replay* replay = calloc(1, sizeof(Replay));
+  if (replay == NULL) {
+    fclose(file);
+    return NULL;
+  }
+  replay->file = file;
+  replay->playing = true;
+  replay->seed = seed;
+  replay->sim_hz = (int)sim_hz;
+  replay->fixed_point = (flags & REPLAY_FIXED_POINT) != 0;
+  read_next(replay);
+  SDL_LogInfo(LOGCAT, "Playing replay %s: seed %llu, %d Hz%s",
+    path, (unsigned long long)seed, replay->sim_hz,
+    replay->fixed_point ? ", fixed point" : "");
+  return replay;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether a replay is being played back
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+    Returns: true when playing back, false when recording or NULL
+    ---------------------------------------------------------------------- */
+bool replay_playing(Replay* replay) {
+  return replay != NULL && replay->playing;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Append a command to a recording replay
+    Parameters:
+      Replay* replay: pointer to the replay; ignored if NULL or playing
+      Uint64 tick: simulation tick the command takes effect before
+      Command command: command applied
+    Returns: none
+    ---------------------------------------------------------------------- */
+void replay_record(Replay* replay, Uint64 tick, Command command) {
+  if (replay == NULL || replay->playing) {
+    return;
+  }
+  Uint64 delta = tick - replay->last_tick;
+  write_varint(replay->file, delta << REPLAY_COMMAND_BITS | command);
+  // commands are rare, flush so a crash still leaves a usable replay
+  fflush(replay->file);
+  replay->last_tick = tick;
+  replay->commands++;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Apply all commands of a playing replay that take effect
+    before the game's current simulation tick
+    Parameters:
+      Replay* replay: pointer to the replay; ignored if NULL or recording
+      Game* game: pointer to the Game object being played back
+    Returns: none
+    ---------------------------------------------------------------------- */
+void replay_feed(Replay* replay, Game* game) {
+  if (!replay_playing(replay)) {
+    return;
+  }
+  while (!replay->ended && replay->next_tick <= game->sim_ticks) {
+    apply_command(game, replay->next_command);
+    read_next(replay);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether playback has reached the last recorded
+    tick. Commands recorded after the last step are applied first.
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+      Game* game: pointer to the Game object being played back
+    Returns: true if the game must not be stepped any further
+    ---------------------------------------------------------------------- */
+bool replay_finished(Replay* replay, Game* game) {
+  if (!replay_playing(replay)) {
+    return false;
+  }
+  replay_feed(replay, game);
+  return replay->ended && game->sim_ticks >= replay->end_tick;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Close a replay. A recording is ended with the final
+    scores and a hash of the game state; a finished playback is checked
+    against them.
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+      Game* game: pointer to the Game object
+    Returns: false if a finished playback didn't reproduce the recorded
+    game, otherwise true
+    ---------------------------------------------------------------------- */
+bool replay_close(Replay* replay, Game* game) {
+  if (replay == NULL) {
+    return true;
+  }
+  bool ok = true;
+
+  if (!replay->playing) {
+    Uint64 delta = game->sim_ticks - replay->last_tick;
+    write_varint(replay->file, delta << REPLAY_COMMAND_BITS | COMMAND_NONE);
+    write_varint(replay->file, game->match.score_board.player);
+    write_varint(replay->file, game->match.score_board.robot);
+    write_varint(replay->file, hash_match(&game->match));
+    SDL_LogInfo(LOGCAT, "Recorded %llu commands over %llu ticks, %ld bytes",
+      (unsigned long long)replay->commands,
+      (unsigned long long)game->sim_ticks, ftell(replay->file));
+  } else if (replay_finished(replay, game) && replay->checked) {
+    ok = replay->end_player == (Uint64)game->match.score_board.player &&
+      replay->end_robot == (Uint64)game->match.score_board.robot &&
+      replay->end_hash == hash_match(&game->match);
+    if (ok) {
+      SDL_LogInfo(LOGCAT, "Replay reproduced the recorded game, %d:%d",
+        game->match.score_board.player, game->match.score_board.robot);
+    } else {
+      SDL_LogError(LOGCAT,
+        "Replay diverged: recorded %llu:%llu, played back %d:%d",
+        (unsigned long long)replay->end_player,
+        (unsigned long long)replay->end_robot,
+        game->match.score_board.player, game->match.score_board.robot);
+    }
+  }
+
+  fclose(replay->file);
+  free(replay);
+  return ok;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Play a replay file back without video or audio as fast as
+    possible, check the result and log the speed-up over real time
+    Parameters:
+      const char* path: replay file to play
+    Returns: true if the replay was read and reproduced the recorded game
+    ---------------------------------------------------------------------- */
+bool run_replay(const char* path) {
+  Replay* replay = replay_open(path);
+  if (replay == NULL) {
+    return false;
+  }
+  Game game = {
+    .match = {
+      .winner = NOBODY,
+      .idle = true,
+      .over = false,
+      .fixed_point = replay->fixed_point,
+    },
+    .play_sounds = false,
+    .running = true,
+    .replay = replay,
+  };
+  new_game(&game, replay->seed);
+  double sim_step = 1.0 / replay->sim_hz;
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  while (!replay_finished(replay, &game)) {
+    tick_game(&game, sim_step);
+  }
+  double elapsed =
+    (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+  double simulated = game.sim_ticks * sim_step;
+
+  SDL_LogInfo(LOGCAT,
+    "Replay: %llu ticks (%.1f s of play) in %.3f s, %.0fx real time",
+    (unsigned long long)game.sim_ticks, simulated, elapsed,
+    elapsed > 0 ? simulated / elapsed : 0.0);
+  return replay_close(replay, &game);
+}
@@ -0,0 +1,128 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "pong.h"
+
+#define REPLAY_MAGIC "PRPL"
+#define REPLAY_VERSION 4
+// low bits of each record hold the command, the rest the tick delta
+#define REPLAY_COMMAND_BITS 3
+// bits of the header's flags
+#define REPLAY_FIXED_POINT 1
+
+/*
+  Replay file: the seed, simulation rate and physics a game was started
+  with, then every player command with the simulation tick it took effect
+  on. As the simulation is deterministic for a seed, feeding the commands
+  back on the same ticks reproduces the match exactly; with fixed point
+  physics, on any machine.
+
+  Layout after the 4 byte magic and a version byte, all numbers varints
+  (7 bits per byte, low bits first):
+    seed, sim_hz, flags (REPLAY_FIXED_POINT)
+    (tick delta << REPLAY_COMMAND_BITS | command) per command
+    (tick delta << REPLAY_COMMAND_BITS | COMMAND_NONE) at the end, followed
+    by the final player score, robot score and a hash of the game state
+*/
+struct Replay {
+  FILE* file;
+  bool playing;
+  Uint64 seed;
+  int sim_hz;
+  bool fixed_point;
+  Uint64 last_tick;
+  Uint64 commands;
+  // playback reads one command ahead
+  Command next_command;
+  Uint64 next_tick;
+  bool ended;
+  bool checked;
+  Uint64 end_tick;
+  Uint64 end_player;
+  Uint64 end_robot;
+  Uint64 end_hash;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Create a replay file to record a new game into
+    Parameters:
+      const char* path: file to write
+      Uint64 seed: seed the game is started with by new_game()
+      int sim_hz: simulation steps per second
+      bool fixed_point: the game runs fixed point physics
+    Returns: Replay* pointer to the recording replay, or NULL on failure
+    ---------------------------------------------------------------------- */
+Replay* replay_create(const char* path, Uint64 seed, int sim_hz,
+  bool fixed_point);
+
+/*  ----------------------------------------------------------------------
+    Description: Open a replay file for playback. Start the game with
+    new_game() using the replay's seed and physics and step it at its
+    sim_hz.
+    Parameters:
+      const char* path: file to read
+    Returns: Replay* pointer to the replay, or NULL if the file can't be
+    read or isn't a replay
+    ---------------------------------------------------------------------- */
+Replay* replay_open(const char* path);
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether a replay is being played back
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+    Returns: true when playing back, false when recording or NULL
+    ---------------------------------------------------------------------- */
+bool replay_playing(Replay* replay);
+
+/*  ----------------------------------------------------------------------
+    Description: Append a command to a recording replay
+    Parameters:
+      Replay* replay: pointer to the replay; ignored if NULL or playing
+      Uint64 tick: simulation tick the command takes effect before
+      Command command: command applied
+    Returns: none
+    ---------------------------------------------------------------------- */
+void replay_record(Replay* replay, Uint64 tick, Command command);
+
+/*  ----------------------------------------------------------------------
+    Description: Apply all commands of a playing replay that take effect
+    before the game's current simulation tick
+    Parameters:
+      Replay* replay: pointer to the replay; ignored if NULL or recording
+      Game* game: pointer to the Game object being played back
+    Returns: none
+    ---------------------------------------------------------------------- */
+void replay_feed(Replay* replay, Game* game);
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether playback has reached the last recorded
+    tick. Commands recorded after the last step are applied first.
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+      Game* game: pointer to the Game object being played back
+    Returns: true if the game must not be stepped any further
+    ---------------------------------------------------------------------- */
+bool replay_finished(Replay* replay, Game* game);
+
+/*  ----------------------------------------------------------------------
+    Description: Close a replay. A recording is ended with the final
+    scores and a hash of the game state; a finished playback is checked
+    against them.
+    Parameters:
+      Replay* replay: pointer to the replay, may be NULL
+      Game* game: pointer to the Game object
+    Returns: false if a finished playback didn't reproduce the recorded
+    game, otherwise true
+    ---------------------------------------------------------------------- */
+bool replay_close(Replay* replay, Game* game);
+
+/*  ----------------------------------------------------------------------
+    Description: Play a replay file back without video or audio as fast as
+    possible, check the result and log the speed-up over real time
+    Parameters:
+      const char* path: replay file to play
+    Returns: true if the replay was read and reproduced the recorded game
+    ---------------------------------------------------------------------- */
+bool run_replay(const char* path);
+
+#endif
@@ -0,0 +1,180 @@
+// Event-driven headless matches
+#include "skip.h"
+
+typedef enum {
+  SKIP_WALL,
+  SKIP_FACE,
+  SKIP_GOAL
+} SkipEvent;
+
+/*  ----------------------------------------------------------------------
+    Description: Move an AI paddle for a stretch of time the way
+    update_player() and move_paddle() do with vanishing ticks: if its
+    target isn't covered, at (speed - fudge) * speed pixels per second
+    towards the nearest position that covers it, then stopped there,
+    within the court
+    Parameters:
+      Ball* ball: the game ball, predicted
+      Paddle* paddle: the paddle object
+      double time: simulated seconds
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void chase_target(Ball* ball, Paddle* paddle, double time) {
+  double target_y = paddle->owner == PLAYER ?
+    ball->player_target_y : ball->robot_target_y;
+  int paddle_top = paddle->y;
+  int paddle_bottom = paddle->y + paddle->h;
+  int ball_top = target_y;
+  int ball_bottom = target_y + ball->h;
+
+  double goal = paddle->y;
+  if (ball_top < paddle_top) {
+    goal = target_y;
+  } else if (ball_bottom > paddle_bottom) {
+    goal = target_y + ball->h - paddle->h;
+  }
+  if (goal < COURT_OFFSIDE) {
+    goal = COURT_OFFSIDE;
+  }
+  if (goal + paddle->h > COURT_HEIGHT) {
+    goal = COURT_HEIGHT - paddle->h;
+  }
+
+  int speed = paddle->speed - ball->fudge;
+  double reach = (double)speed * paddle->speed * time;
+  if (fabs(goal - paddle->y) <= reach) {
+    paddle->y = goal;
+    paddle->dy = 0;
+  } else {
+    paddle->dy = goal < paddle->y ? -speed : speed;
+    paddle->y += paddle->dy * paddle->speed * time;
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Advance an AI vs AI match to its next ball event: a wall
+    rebound, the ball reaching the face of the paddle it is heading for,
+    where it rebounds with check_collision() if the paddle is there, or a
+    goal, scored with award_point(). Both paddles chase their targets in
+    the meantime. Resets the match first if the previous step ended it.
+    The match's events are cleared, then hold what happened at the event.
+    Parameters:
+      Match* match: pointer to the Match object, fixed_point and versus
+      are ignored
+      double* elapsed: receives the simulated seconds up to the event
+    Returns: Player who scored a point at this event, or NOBODY
+    ---------------------------------------------------------------------- */
+Player skip_step(Match* match, double* elapsed) {
+  Ball* ball = &match->ball;
+  Player scorer = NOBODY;
+  match->events.count = 0;
+
+  // reset game
+  if (match->over) {
+    reset_match(match);
+  }
+  if (!ball->predicted) {
+    predict_ball(ball);
+  }
+
+  double vx = ball->dx * ball->speed;
+  double vy = ball->dy * ball->speed;
+  Paddle* paddle = vx > 0 ? &match->player : &match->robot;
+
+  // the goal line ahead, unless the ball reaches the paddle face first
+  SkipEvent event = SKIP_GOAL;
+  double time = vx > 0 ? (SCREEN_WIDTH - ball->x) / vx : -ball->x / vx;
+  double lead = vx > 0 ? ball->x + ball->w : ball->x;
+  double face = vx > 0 ? paddle->x : paddle->x + paddle->w;
+  if (vx > 0 ? lead < face : lead > face) {
+    event = SKIP_FACE;
+    time = (face - lead) / vx;
+  }
+
+  // a wall on the way, paddles first on a tie as in sweep_ball()
+  double wall_y = vy < 0 ? 0 : SCREEN_HEIGHT - ball->h;
+  if (vy != 0 && (wall_y - ball->y) / vy < time) {
+    event = SKIP_WALL;
+    time = (wall_y - ball->y) / vy;
+  }
+  if (time < 0) {
+    time = 0;
+  }
+
+  // everything moves in a straight line until then
+  chase_target(ball, &match->player, time);
+  chase_target(ball, &match->robot, time);
+  ball->x += vx * time;
+  ball->y += vy * time;
+  *elapsed = time;
+
+  switch (event) {
+  case SKIP_WALL:
+    ball->y = wall_y;
+    ball->dy *= -1;
+    push_event(&match->events, EVENT_WALL_HIT, NOBODY);
+    break;
+  case SKIP_FACE:
+    // exactly at the face, a miss leaves the ball on its way to the goal
+    ball->x = vx > 0 ? face - ball->w : face;
+    ball->time_step = 0;
+    if (check_collision(ball, paddle, &match->rng)) {
+      push_event(&match->events, EVENT_PADDLE_HIT, paddle->owner);
+      match->rally++;
+    } else {
+      // off its predicted course, as update_player() has it: chase the
+      // ball from where it passed the face
+      ball->player_target_y = ball->y;
+      ball->robot_target_y = ball->y;
+    }
+    break;
+  case SKIP_GOAL:
+    scorer = vx > 0 ? ROBOT : PLAYER;
+    award_point(match, scorer);
+    break;
+  }
+  return scorer;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: play_match() with skip_step(): one AI vs AI match from a
+    fresh game to MAX_SCORE, event by event, accumulating the result into
+    the given stats with the events counted instead of ticks. Matches
+    that go on for SKIP_MAX_SECONDS of play or HEADLESS_MAX_TICKS events
+    are abandoned and counted separately.
+    Parameters:
+      Match* match: pointer to the Match object
+      MatchStats* stats: pointer to the stats to add this match to
+    Returns: winner of the match, or NOBODY if it was abandoned
+    ---------------------------------------------------------------------- */
+Player play_skip_match(Match* match, MatchStats* stats) {
+  reset_match(match);
+  match->winner = NOBODY;
+
+  int events = 0;
+  double seconds = 0;
+  while (!match->over && events < HEADLESS_MAX_TICKS &&
+    seconds < SKIP_MAX_SECONDS) {
+    double elapsed;
+    if (skip_step(match, &elapsed) != NOBODY) {
+      stats->points++;
+      stats->volleys += match->last_rally;
+      if (match->last_rally > stats->longest_rally) {
+        stats->longest_rally = match->last_rally;
+      }
+    }
+    seconds += elapsed;
+    events++;
+  }
+  stats->events += events;
+  stats->matches++;
+
+  if (match->winner == PLAYER) {
+    stats->player_wins++;
+  } else if (match->winner == ROBOT) {
+    stats->robot_wins++;
+  } else {
+    stats->abandoned++;
+  }
+  return match->winner;
+}
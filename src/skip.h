@@ -0,0 +1,48 @@
+#ifndef SKIP_H
+#define SKIP_H
+
+#include "core.h"
+
+// simulated seconds after which an event-driven match is abandoned: as
+// long as HEADLESS_MAX_TICKS ticks at 60 Hz
+#define SKIP_MAX_SECONDS (HEADLESS_MAX_TICKS / 60.0)
+
+/*
+  Event-driven AI vs AI matches. Between events the ball moves in a
+  straight line and each AI paddle chases its predicted target at a
+  constant speed, so instead of stepping fixed ticks the simulation works
+  out when the next wall rebound, paddle face crossing or goal happens and
+  jumps straight to it. The paddles follow update_player()'s chase rule
+  continuously, which is the limit of the tick engine for small time
+  steps: results agree statistically, not tick for tick.
+*/
+
+/*  ----------------------------------------------------------------------
+    Description: Advance an AI vs AI match to its next ball event: a wall
+    rebound, the ball reaching the face of the paddle it is heading for,
+    where it rebounds with check_collision() if the paddle is there, or a
+    goal, scored with award_point(). Both paddles chase their targets in
+    the meantime. Resets the match first if the previous step ended it.
+    The match's events are cleared, then hold what happened at the event.
+    Parameters:
+      Match* match: pointer to the Match object, fixed_point and versus
+      are ignored
+      double* elapsed: receives the simulated seconds up to the event
+    Returns: Player who scored a point at this event, or NOBODY
+    ---------------------------------------------------------------------- */
+Player skip_step(Match* match, double* elapsed);
+
+/*  ----------------------------------------------------------------------
+    Description: play_match() with skip_step(): one AI vs AI match from a
+    fresh game to MAX_SCORE, event by event, accumulating the result into
+    the given stats with the events counted instead of ticks. Matches
+    that go on for SKIP_MAX_SECONDS of play or HEADLESS_MAX_TICKS events
+    are abandoned and counted separately.
+    Parameters:
+      Match* match: pointer to the Match object
+      MatchStats* stats: pointer to the stats to add this match to
+    Returns: winner of the match, or NOBODY if it was abandoned
+    ---------------------------------------------------------------------- */
+Player play_skip_match(Match* match, MatchStats* stats);
+
+#endif
@@ -0,0 +1,152 @@
+// Long-run frame timing histograms and hitch reporting
+#include "soak.h"
+#include <stdlib.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a soak recorder and open its output file
+    Parameters:
+      const char* path: JSON lines file to append windows to
+      double budget: frame budget in seconds, hitches are intervals longer
+      than SOAK_HITCH_FACTOR budgets
+      double flush_seconds: length of a window in seconds
+    Returns: Soak* pointer to the recorder, or NULL on failure
+    ---------------------------------------------------------------------- */
+Soak* soak_open(const char* path, double budget, double flush_seconds) {
+  // histograms are large, keep them off the stack
+  Soak* soak = calloc(1, sizeof(Soak));
+  if (soak == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate soak recorder");
+    return NULL;
+  }
+  soak->file = fopen(path, "a");
+  if (soak->file == NULL) {
+    SDL_LogError(LOGCAT, "Failed to open soak file '%s'", path);
+    free(soak);
+    return NULL;
+  }
+  soak->budget_us = budget * 1e6;
+  soak->flush_seconds = flush_seconds;
+  soak->start_counter = SDL_GetPerformanceCounter();
+  soak->window_counter = soak->start_counter;
+  SDL_LogInfo(LOGCAT, "Soak: writing frame times to %s every %.0f s",
+    path, flush_seconds);
+  return soak;
+}
+
+/*  ----------------------------------------------------------------------
+    Write percentiles of one histogram as a JSON object member
+    ---------------------------------------------------------------------- */
+static void write_histogram(FILE* file, const char* name, Histogram* hist) {
+  fprintf(file,
+    "\"%s\":{\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p99.9\":%llu,"
+    "\"max\":%llu,\"mean\":%.1f}",
+    name,
+    (unsigned long long)histogram_percentile(hist, 50),
+    (unsigned long long)histogram_percentile(hist, 90),
+    (unsigned long long)histogram_percentile(hist, 99),
+    (unsigned long long)histogram_percentile(hist, 99.9),
+    (unsigned long long)hist->max,
+    hist->count > 0 ? (double)hist->total / hist->count : 0.0);
+}
+
+/*  ----------------------------------------------------------------------
+    Append one JSON line with the given histograms and hitch count
+    ---------------------------------------------------------------------- */
+static void write_window(Soak* soak, Uint64 now, const char* kind,
+  Histogram* work, Histogram* interval, Uint64 hitches) {
+  double freq = SDL_GetPerformanceFrequency();
+  fprintf(soak->file,
+    "{\"kind\":\"%s\",\"window\":%d,\"uptime_s\":%.3f,\"seconds\":%.3f,"
+    "\"budget_us\":%.0f,\"frames\":%llu,\"hitches\":%llu,",
+    kind, soak->windows, (now - soak->start_counter) / freq,
+    (now - soak->window_counter) / freq, soak->budget_us,
+    (unsigned long long)work->count, (unsigned long long)hitches);
+  write_histogram(soak->file, "work_us", work);
+  fprintf(soak->file, ",");
+  write_histogram(soak->file, "interval_us", interval);
+  fprintf(soak->file, "}\n");
+  // flush every line, a kiosk may lose power rather than exit
+  fflush(soak->file);
+}
+
+/*  ----------------------------------------------------------------------
+    Write the current window, fold it into the run totals and reset it
+    ---------------------------------------------------------------------- */
+static void flush_window(Soak* soak, Uint64 now) {
+  write_window(soak, now, "window",
+    &soak->work, &soak->interval, soak->hitches);
+  histogram_add(&soak->total_work, &soak->work);
+  histogram_add(&soak->total_interval, &soak->interval);
+  soak->total_hitches += soak->hitches;
+  histogram_reset(&soak->work);
+  histogram_reset(&soak->interval);
+  soak->hitches = 0;
+  soak->windows++;
+  soak->window_counter = now;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Count one frame and write the window if it is complete
+    Parameters:
+      Soak* soak: pointer to the recorder, nothing happens if NULL
+      Uint64 frame_start: performance counter at the start of the frame
+      Uint64 present_start: performance counter just before presenting
+      Uint64 present_end: performance counter just after presenting
+    Returns: none
+    ---------------------------------------------------------------------- */
+void soak_frame(Soak* soak, Uint64 frame_start, Uint64 present_start,
+  Uint64 present_end) {
+  if (soak == NULL) {
+    return;
+  }
+  double us_per_tick = 1e6 / SDL_GetPerformanceFrequency();
+
+  histogram_record(&soak->work,
+    (Uint64)((present_start - frame_start) * us_per_tick));
+
+  // the first frame has no previous present to measure from
+  if (soak->last_present != 0) {
+    double interval = (present_end - soak->last_present) * us_per_tick;
+    histogram_record(&soak->interval, (Uint64)interval);
+    if (interval > SOAK_HITCH_FACTOR * soak->budget_us) {
+      soak->hitches++;
+    }
+  }
+  soak->last_present = present_end;
+
+  double window = (double)(present_end - soak->window_counter) /
+    SDL_GetPerformanceFrequency();
+  if (window >= soak->flush_seconds) {
+    flush_window(soak, present_end);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Write the open window and a summary of the whole run, then
+    close the file and free the recorder
+    Parameters:
+      Soak* soak: pointer to the recorder, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void soak_close(Soak* soak) {
+  if (soak == NULL) {
+    return;
+  }
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (soak->work.count > 0) {
+    flush_window(soak, now);
+  }
+  soak->window_counter = soak->start_counter;
+  write_window(soak, now, "run", &soak->total_work, &soak->total_interval,
+    soak->total_hitches);
+  SDL_LogInfo(LOGCAT,
+    "Soak: %llu frames, %llu hitches, interval p99 %llu us, max %llu us",
+    (unsigned long long)soak->total_interval.count,
+    (unsigned long long)soak->total_hitches,
+    (unsigned long long)histogram_percentile(&soak->total_interval, 99),
+    (unsigned long long)soak->total_interval.max);
+  fclose(soak->file);
+  free(soak);
+}
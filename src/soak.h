@@ -0,0 +1,68 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "histogram.h"
+
+#define SOAK_FLUSH_SECONDS 60
+// frames whose present-to-present interval exceeds this many budgets
+#define SOAK_HITCH_FACTOR 2
+
+/*
+  Long-run frame timing. Every frame's work time (frame start until
+  SDL_RenderPresent() is called) and present-to-present interval are
+  counted in microseconds, per flush window and for the whole run. Each
+  window is appended to a JSON lines file as it closes.
+*/
+typedef struct Soak Soak;
+struct Soak {
+  FILE* file;
+  double budget_us;
+  double flush_seconds;
+  Uint64 start_counter;
+  Uint64 window_counter;
+  Uint64 last_present;
+  Uint64 hitches;
+  Uint64 total_hitches;
+  int windows;
+  Histogram work;
+  Histogram interval;
+  Histogram total_work;
+  Histogram total_interval;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Allocate a soak recorder and open its output file
+    Parameters:
+      const char* path: JSON lines file to append windows to
+      double budget: frame budget in seconds, hitches are intervals longer
+      than SOAK_HITCH_FACTOR budgets
+      double flush_seconds: length of a window in seconds
+    Returns: Soak* pointer to the recorder, or NULL on failure
+    ---------------------------------------------------------------------- */
+Soak* soak_open(const char* path, double budget, double flush_seconds);
+
+/*  ----------------------------------------------------------------------
+    Description: Count one frame and write the window if it is complete
+    Parameters:
+      Soak* soak: pointer to the recorder, nothing happens if NULL
+      Uint64 frame_start: performance counter at the start of the frame
+      Uint64 present_start: performance counter just before presenting
+      Uint64 present_end: performance counter just after presenting
+    Returns: none
+    ---------------------------------------------------------------------- */
+void soak_frame(Soak* soak, Uint64 frame_start, Uint64 present_start,
+  Uint64 present_end);
+
+/*  ----------------------------------------------------------------------
+    Description: Write the open window and a summary of the whole run, then
+    close the file and free the recorder
+    Parameters:
+      Soak* soak: pointer to the recorder, may be NULL
+    Returns: none
+    ---------------------------------------------------------------------- */
+void soak_close(Soak* soak);
+
+#endif
@@ -0,0 +1,144 @@
+// Portable socket helpers for the network modules
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "sockets.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#endif
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+
+/*  ----------------------------------------------------------------------
+    Description: Start the socket library once per process (Winsock),
+    nothing to do elsewhere
+    Parameters: none
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool sockets_start(void) {
+#ifdef _WIN32
+  static bool started = false;
+  if (!started) {
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+      return false;
+    }
+    started = true;
+  }
+#endif
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Make a socket's calls return at once instead of waiting
+    Parameters:
+      Socket s: the socket
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool socket_set_nonblocking(Socket s) {
+#ifdef _WIN32
+  u_long nonblocking = 1;
+  return ioctlsocket(s, FIONBIO, &nonblocking) == 0;
+#else
+  int flags = fcntl(s, F_GETFL, 0);
+  return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether the last failed call on a non-blocking
+    socket only means it would have had to wait
+    Parameters: none
+    Returns: true if the call should be retried later
+    ---------------------------------------------------------------------- */
+bool socket_would_block(void) {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Find the local port a socket is bound to
+    Parameters:
+      Socket s: the socket
+    Returns: port number, 0 on failure
+    ---------------------------------------------------------------------- */
+int socket_local_port(Socket s) {
+  struct sockaddr_in addr;
+  socklen_t size = sizeof(addr);
+  if (getsockname(s, (struct sockaddr*)&addr, &size) != 0) {
+    return 0;
+  }
+  return ntohs(addr.sin_port);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Resolve HOST[:PORT] to an IPv4 address
+    Parameters:
+      const char* address: host name or IPv4 address, optionally followed
+      by a colon and a port
+      int default_port: port when the address has none
+      Uint32* ip: receives the address in host byte order
+      Uint16* port: receives the port
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool socket_resolve(const char* address, int default_port, Uint32* ip,
+  Uint16* port) {
+  char host[64];
+  int number = default_port;
+  const char* colon = strrchr(address, ':');
+  size_t length = colon != NULL ? (size_t)(colon - address) : strlen(address);
+  if (colon != NULL) {
+    number = atoi(colon + 1);
+  }
+  if (length == 0 || length >= sizeof(host) || number <= 0 || number > 65535) {
+    SDL_LogError(LOGCAT, "Bad host address '%s'", address);
+    return false;
+  }
+  memcpy(host, address, length);
+  host[length] = '\0';
+
+  struct addrinfo hints;
+  struct addrinfo* found = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  if (!sockets_start() || getaddrinfo(host, NULL, &hints, &found) != 0 ||
+    found == NULL) {
+    SDL_LogError(LOGCAT, "Could not resolve host '%s'", host);
+    return false;
+  }
+  *ip = ntohl(((struct sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+  *port = (Uint16)number;
+  freeaddrinfo(found);
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Raise the limit on open files so a process can hold many
+    sockets (POSIX only)
+    Parameters:
+      int count: sockets wanted, on top of the files already open
+    Returns: none
+    ---------------------------------------------------------------------- */
+void sockets_reserve(int count) {
+#ifndef _WIN32
+  struct rlimit limit;
+  rlim_t wanted = (rlim_t)count + 64;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < wanted) {
+    limit.rlim_cur = limit.rlim_max < wanted ? limit.rlim_max : wanted;
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur < wanted) {
+      SDL_LogWarn(LOGCAT, "Open file limit is %llu, %d sockets wanted",
+        (unsigned long long)limit.rlim_cur, count);
+    }
+  }
+#else
+  (void)count;
+#endif
+}
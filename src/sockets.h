@@ -0,0 +1,90 @@
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+/*
+  Winsock and BSD sockets behind one set of names, for the network
+  modules only. A .c file that includes this defines _POSIX_C_SOURCE
+  200809L before any other include.
+*/
+#include <SDL.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET Socket;
+#define poll WSAPoll
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+// a peer that closed its end must not raise SIGPIPE
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/*  ----------------------------------------------------------------------
+    Description: Start the socket library once per process (Winsock),
+    nothing to do elsewhere
+    Parameters: none
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool sockets_start(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Make a socket's calls return at once instead of waiting
+    Parameters:
+      Socket s: the socket
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool socket_set_nonblocking(Socket s);
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether the last failed call on a non-blocking
+    socket only means it would have had to wait
+    Parameters: none
+    Returns: true if the call should be retried later
+    ---------------------------------------------------------------------- */
+bool socket_would_block(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Find the local port a socket is bound to
+    Parameters:
+      Socket s: the socket
+    Returns: port number, 0 on failure
+    ---------------------------------------------------------------------- */
+int socket_local_port(Socket s);
+
+/*  ----------------------------------------------------------------------
+    Description: Resolve HOST[:PORT] to an IPv4 address
+    Parameters:
+      const char* address: host name or IPv4 address, optionally followed
+      by a colon and a port
+      int default_port: port when the address has none
+      Uint32* ip: receives the address in host byte order
+      Uint16* port: receives the port
+    Returns: true on success
+    ---------------------------------------------------------------------- */
+bool socket_resolve(const char* address, int default_port, Uint32* ip,
+  Uint16* port);
+
+/*  ----------------------------------------------------------------------
+    Description: Raise the limit on open files so a process can hold many
+    sockets (POSIX only)
+    Parameters:
+      int count: sockets wanted, on top of the files already open
+    Returns: none
+    ---------------------------------------------------------------------- */
+void sockets_reserve(int count);
+
+#endif
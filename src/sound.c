@@ -0,0 +1,133 @@
+// Synthesized sound effects and audio device setup
+#include "sound.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+// RIFF header of a 16 bit PCM WAV file
+#define WAV_HEADER_SIZE 44
+
+// bytes mixed per callback, written by the audio thread until reported
+static SDL_atomic_t mix_bytes;
+static bool reported;
+
+/*  ----------------------------------------------------------------------
+    Post-mix hook that records how many bytes SDL asks for per callback,
+    which is the buffer size it actually opened the device with
+    ---------------------------------------------------------------------- */
+static void measure_buffer(void* udata, Uint8* stream, int len) {
+  (void)udata;
+  (void)stream;
+  SDL_AtomicSet(&mix_bytes, len);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Open the audio device through SDL_mixer with the given
+    buffer size. The buffer SDL actually uses is measured from the first
+    mix and logged by sound_report().
+    Parameters:
+      int buffer_frames: requested buffer size in sample frames
+    Returns: true if the audio device was opened
+    ---------------------------------------------------------------------- */
+bool sound_open(int buffer_frames) {
+  if (Mix_OpenAudio(SOUND_RATE, MIX_DEFAULT_FORMAT, 2, buffer_frames) < 0) {
+    SDL_LogCritical(LOGCAT,
+      "SDL_mixer could not initialize! SDL_mixer Error: %s\n",
+      Mix_GetError());
+    return false;
+  }
+  SDL_AtomicSet(&mix_bytes, 0);
+  reported = false;
+  Mix_SetPostMix(measure_buffer, NULL);
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Log the audio buffer size and latency once the first mix
+    has measured it. Cheap to call every frame; logs only once.
+    Parameters: none
+    Returns: none
+    ---------------------------------------------------------------------- */
+void sound_report(void) {
+  if (reported) {
+    return;
+  }
+  int bytes = SDL_AtomicGet(&mix_bytes);
+  if (bytes == 0) {
+    return;
+  }
+  reported = true;
+  Mix_SetPostMix(NULL, NULL);
+
+  int rate;
+  Uint16 format;
+  int channels;
+  if (Mix_QuerySpec(&rate, &format, &channels) == 0 || rate <= 0) {
+    return;
+  }
+  int frames = bytes / (channels * SDL_AUDIO_BITSIZE(format) / 8);
+  SDL_LogInfo(LOGCAT, "Audio: %d Hz, %d channels, buffer %d frames (%.1f ms)",
+    rate, channels, frames, frames * 1000.0 / rate);
+}
+
+static void put_le16(Uint8* p, Uint16 value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static void put_le32(Uint8* p, Uint32 value) {
+  put_le16(p, value & 0xFFFF);
+  put_le16(p + 2, value >> 16);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Synthesize a square wave beep in memory as a sound chunk
+    in the audio device's format. No files are read.
+    Parameters:
+      int hz: tone frequency
+      int ms: length in milliseconds
+    Returns: Mix_Chunk* pointer to the chunk, or NULL on failure
+    ---------------------------------------------------------------------- */
+Mix_Chunk* sound_beep(int hz, int ms) {
+  int samples = SOUND_RATE * ms / 1000;
+  Uint32 data_size = samples * 2;
+  Uint8* wav = malloc(WAV_HEADER_SIZE + data_size);
+  if (wav == NULL) {
+    return NULL;
+  }
+
+  // mono 16 bit WAV, so SDL_mixer converts it to the device's format
+  memcpy(wav, "RIFF", 4);
+  put_le32(wav + 4, WAV_HEADER_SIZE - 8 + data_size);
+  memcpy(wav + 8, "WAVEfmt ", 8);
+  put_le32(wav + 16, 16);
+  put_le16(wav + 20, 1);
+  put_le16(wav + 22, 1);
+  put_le32(wav + 24, SOUND_RATE);
+  put_le32(wav + 28, SOUND_RATE * 2);
+  put_le16(wav + 32, 2);
+  put_le16(wav + 34, 16);
+  memcpy(wav + 36, "data", 4);
+  put_le32(wav + 40, data_size);
+
+  int fade = SOUND_RATE * SOUND_FADE_MS / 1000;
+  Uint8* out = wav + WAV_HEADER_SIZE;
+  for (int i = 0; i < samples; i++) {
+    // high for the first half of each period, low for the second
+    double level = (2 * (Uint64)i * hz / SOUND_RATE) % 2 == 0 ? 1 : -1;
+    int edge = i < samples - 1 - i ? i : samples - 1 - i;
+    if (edge < fade) {
+      level *= (double)edge / fade;
+    }
+    put_le16(out + i * 2, (Uint16)(Sint16)(level * SOUND_VOLUME * 32767));
+  }
+
+  Mix_Chunk* chunk =
+    Mix_LoadWAV_RW(SDL_RWFromConstMem(wav, WAV_HEADER_SIZE + data_size), 1);
+  if (chunk == NULL) {
+    SDL_LogError(LOGCAT, "Failed to synthesize %d Hz beep: %s",
+      hz, Mix_GetError());
+  }
+  free(wav);
+  return chunk;
+}
@@ -0,0 +1,53 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <stdbool.h>
+
+#define SOUND_RATE 44100
+// audio buffer in sample frames: 2048 is about 46 ms at 44.1 kHz
+#define SOUND_BUFFER_FRAMES 2048
+#define SOUND_LOW_LATENCY_FRAMES 512
+// square wave amplitude as a fraction of full scale
+#define SOUND_VOLUME 0.75
+// fade in and out so the square wave doesn't click
+#define SOUND_FADE_MS 2
+
+// tones of the original Pong sound effects (see Sound Effects in README)
+#define SOUND_PADDLE_HZ 480
+#define SOUND_PADDLE_MS 96
+#define SOUND_WALL_HZ 220
+#define SOUND_WALL_MS 16
+#define SOUND_POINT_HZ 240
+#define SOUND_POINT_MS 257
+
+/*  ----------------------------------------------------------------------
+    Description: Open the audio device through SDL_mixer with the given
+    buffer size. The buffer SDL actually uses is measured from the first
+    mix and logged by sound_report().
+    Parameters:
+      int buffer_frames: requested buffer size in sample frames
+    Returns: true if the audio device was opened
+    ---------------------------------------------------------------------- */
+bool sound_open(int buffer_frames);
+
+/*  ----------------------------------------------------------------------
+    Description: Log the audio buffer size and latency once the first mix
+    has measured it. Cheap to call every frame; logs only once.
+    Parameters: none
+    Returns: none
+    ---------------------------------------------------------------------- */
+void sound_report(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Synthesize a square wave beep in memory as a sound chunk
+    in the audio device's format. No files are read.
+    Parameters:
+      int hz: tone frequency
+      int ms: length in milliseconds
+    Returns: Mix_Chunk* pointer to the chunk, or NULL on failure
+    ---------------------------------------------------------------------- */
+Mix_Chunk* sound_beep(int hz, int ms);
+
+#endif
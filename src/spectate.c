@@ -0,0 +1,798 @@
+// Spectator broadcast server and viewer stream
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "sockets.h"
+#include "spectate.h"
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+// a socket that is ready, slot -1 for the listener
+typedef struct WatchEvent WatchEvent;
+struct WatchEvent {
+  int slot;
+  bool readable;
+  bool writable;
+};
+
+#ifdef __linux__
+static bool watch_open(SpectateServer* server) {
+  server->epoll = epoll_create1(0);
+  return server->epoll >= 0;
+}
+
+static void watch_close(SpectateServer* server) {
+  if (server->epoll >= 0) {
+    close(server->epoll);
+  }
+}
+
+static bool watch_add(SpectateServer* server, Socket s, int slot) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u32 = (Uint32)(slot + 1);
+  return epoll_ctl(server->epoll, EPOLL_CTL_ADD, s, &event) == 0;
+}
+
+static void watch_write(SpectateServer* server, Socket s, int slot,
+  bool write) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | (write ? EPOLLOUT : 0);
+  event.data.u32 = (Uint32)(slot + 1);
+  epoll_ctl(server->epoll, EPOLL_CTL_MOD, s, &event);
+}
+
+static void watch_remove(SpectateServer* server, Socket s, int slot) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  (void)slot;
+  epoll_ctl(server->epoll, EPOLL_CTL_DEL, s, &event);
+}
+
+static int watch_wait(SpectateServer* server, int timeout,
+  WatchEvent* events) {
+  struct epoll_event ready[SPECTATE_EVENTS];
+  int count = epoll_wait(server->epoll, ready, SPECTATE_EVENTS, timeout);
+  for (int i = 0; i < count; i++) {
+    events[i].slot = (int)ready[i].data.u32 - 1;
+    events[i].readable =
+      (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+    events[i].writable = (ready[i].events & EPOLLOUT) != 0;
+  }
+  return count < 0 ? 0 : count;
+}
+#else
+// poll() array: the listener, then one entry per client slot
+static bool watch_open(SpectateServer* server) {
+  struct pollfd* polls =
+    calloc(server->max_clients + 1, sizeof(struct pollfd));
+  if (polls == NULL) {
+    return false;
+  }
+  for (int i = 0; i <= server->max_clients; i++) {
+    polls[i].fd = INVALID_SOCKET;
+  }
+  server->polls = polls;
+  server->epoll = -1;
+  return true;
+}
+
+static void watch_close(SpectateServer* server) {
+  free(server->polls);
+}
+
+static bool watch_add(SpectateServer* server, Socket s, int slot) {
+  struct pollfd* poll_fd = (struct pollfd*)server->polls + slot + 1;
+  poll_fd->fd = s;
+  poll_fd->events = POLLIN;
+  poll_fd->revents = 0;
+  return true;
+}
+
+static void watch_write(SpectateServer* server, Socket s, int slot,
+  bool write) {
+  struct pollfd* poll_fd = (struct pollfd*)server->polls + slot + 1;
+  (void)s;
+  poll_fd->events = POLLIN | (write ? POLLOUT : 0);
+}
+
+static void watch_remove(SpectateServer* server, Socket s, int slot) {
+  struct pollfd* poll_fd = (struct pollfd*)server->polls + slot + 1;
+  (void)s;
+  poll_fd->fd = INVALID_SOCKET;
+  poll_fd->revents = 0;
+}
+
+static int watch_wait(SpectateServer* server, int timeout,
+  WatchEvent* events) {
+  struct pollfd* polls = server->polls;
+  if (poll(polls, server->max_clients + 1, timeout) <= 0) {
+    return 0;
+  }
+  // level triggered: whatever doesn't fit is reported again next time
+  int count = 0;
+  for (int i = 0; i <= server->max_clients && count < SPECTATE_EVENTS; i++) {
+    if (polls[i].fd != INVALID_SOCKET && polls[i].revents != 0) {
+      events[count].slot = i - 1;
+      events[count].readable =
+        (polls[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+      events[count].writable = (polls[i].revents & POLLOUT) != 0;
+      count++;
+    }
+  }
+  return count;
+}
+#endif
+
+static Uint32 zigzag(Sint32 value) {
+  return ((Uint32)value << 1) ^ (Uint32)(value >> 31);
+}
+
+static Sint32 unzigzag(Uint32 value) {
+  return (Sint32)(value >> 1) ^ -(Sint32)(value & 1);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Round a game's ball, paddles, score and state to a
+    snapshot
+    Parameters:
+      Game* game: pointer to the Game object
+      SpectateSnapshot* snapshot: receives the snapshot
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_snapshot(Game* game, SpectateSnapshot* snapshot) {
+  Sint32* values = snapshot->values;
+  values[SPECTATE_BALL_X] = (Sint32)floor(game->match.ball.x + 0.5);
+  values[SPECTATE_BALL_Y] = (Sint32)floor(game->match.ball.y + 0.5);
+  values[SPECTATE_PLAYER_Y] = (Sint32)floor(game->match.player.y + 0.5);
+  values[SPECTATE_ROBOT_Y] = (Sint32)floor(game->match.robot.y + 0.5);
+  values[SPECTATE_PLAYER_SCORE] = game->match.score_board.player;
+  values[SPECTATE_ROBOT_SCORE] = game->match.score_board.robot;
+  values[SPECTATE_STATE] = (game->match.idle ? SPECTATE_IDLE : 0) |
+    (game->match.over ? SPECTATE_OVER : 0) |
+    (Sint32)game->match.winner << SPECTATE_WINNER_SHIFT;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Encode a snapshot as one stream frame
+    Parameters:
+      Uint8* frame: receives the frame, SPECTATE_MAX_FRAME bytes
+      SpectateSnapshot* base: snapshot the frame is a delta against, or
+      NULL for a keyframe
+      SpectateSnapshot* snapshot: snapshot to encode
+    Returns: size of the frame in bytes, 0 if nothing changed since base
+    ---------------------------------------------------------------------- */
+int spectate_encode(Uint8* frame, SpectateSnapshot* base,
+  SpectateSnapshot* snapshot) {
+  Uint8 mask = base == NULL ? SPECTATE_KEYFRAME : 0;
+  int size = 2;
+  for (int i = 0; i < SPECTATE_FIELDS; i++) {
+    Sint32 value = snapshot->values[i];
+    if (base != NULL) {
+      if (value == base->values[i]) {
+        continue;
+      }
+      value -= base->values[i];
+    }
+    mask |= 1 << i;
+    Uint32 bits = zigzag(value);
+    while (bits >= 0x80) {
+      frame[size++] = (Uint8)(bits & 0x7F) | 0x80;
+      bits >>= 7;
+    }
+    frame[size++] = (Uint8)bits;
+  }
+  if (mask == 0) {
+    return 0;
+  }
+  frame[0] = (Uint8)size;
+  frame[1] = mask;
+  return size;
+}
+
+/*  ----------------------------------------------------------------------
+    Apply one frame to a view's snapshot. Returns false if it is corrupt
+    or a delta arrives before the first keyframe.
+    ---------------------------------------------------------------------- */
+static bool decode_frame(SpectateView* view, const Uint8* frame, int size) {
+  Uint8 mask = frame[1];
+  bool key = (mask & SPECTATE_KEYFRAME) != 0;
+  if (!key && !view->keyed) {
+    return false;
+  }
+  int at = 2;
+  for (int i = 0; i < SPECTATE_FIELDS; i++) {
+    if ((mask & (1 << i)) == 0) {
+      continue;
+    }
+    Uint32 bits = 0;
+    for (int shift = 0;; shift += 7) {
+      if (at >= size || shift > 28) {
+        return false;
+      }
+      Uint8 byte = frame[at++];
+      bits |= (Uint32)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        break;
+      }
+    }
+    Sint32 value = unzigzag(bits);
+    view->snapshot.values[i] = key ? value : view->snapshot.values[i] + value;
+  }
+  view->keyed = view->keyed || key;
+  return at == size;
+}
+
+static void close_client(SpectateServer* server, int slot) {
+  SpectateClient* client = &server->clients[slot];
+  watch_remove(server, (Socket)client->socket, slot);
+  closesocket((Socket)client->socket);
+  client->open = false;
+  server->free_slots[server->free_count++] = slot;
+  server->client_count--;
+}
+
+/*  ----------------------------------------------------------------------
+    Send as much of a client's queue as its socket takes, and watch for
+    room only while some is left. Returns false if the client was closed.
+    ---------------------------------------------------------------------- */
+static bool flush_client(SpectateServer* server, int slot) {
+  SpectateClient* client = &server->clients[slot];
+  while (client->size > 0) {
+    int sent = send((Socket)client->socket,
+      (const char*)client->buffer + client->head, client->size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (socket_would_block()) {
+        break;
+      }
+      close_client(server, slot);
+      return false;
+    }
+    client->head += sent;
+    client->size -= sent;
+    server->bytes += sent;
+  }
+  if (client->size == 0) {
+    client->head = 0;
+  }
+  bool writing = client->size > 0;
+  if (writing != client->writing) {
+    watch_write(server, (Socket)client->socket, slot, writing);
+    client->writing = writing;
+  }
+  return true;
+}
+
+/*  ----------------------------------------------------------------------
+    Queue a whole frame for a client and try to send it. Returns false if
+    there isn't room for it.
+    ---------------------------------------------------------------------- */
+static bool queue_frame(SpectateServer* server, int slot, const Uint8* frame,
+  int size) {
+  SpectateClient* client = &server->clients[slot];
+  if (client->head + client->size + size > SPECTATE_CLIENT_BUFFER) {
+    memmove(client->buffer, client->buffer + client->head, client->size);
+    client->head = 0;
+  }
+  if (client->size + size > SPECTATE_CLIENT_BUFFER) {
+    return false;
+  }
+  memcpy(client->buffer + client->head + client->size, frame, size);
+  client->size += size;
+  // a client waiting for room is flushed when its socket reports it
+  if (!client->writing) {
+    flush_client(server, slot);
+  }
+  return true;
+}
+
+static void accept_clients(SpectateServer* server) {
+  for (;;) {
+    Socket s = accept((Socket)server->listener, NULL, NULL);
+    if (s == INVALID_SOCKET) {
+      break;
+    }
+    if (server->free_count == 0 || !socket_set_nonblocking(s)) {
+      closesocket(s);
+      server->rejected++;
+      continue;
+    }
+    // frames are tiny and due now, don't let Nagle hold them back
+    int nodelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay,
+      sizeof(nodelay));
+
+    int slot = server->free_slots[--server->free_count];
+    if (!watch_add(server, s, slot)) {
+      closesocket(s);
+      server->free_slots[server->free_count++] = slot;
+      server->rejected++;
+      continue;
+    }
+    SpectateClient* client = &server->clients[slot];
+    client->socket = (Uint64)s;
+    client->open = true;
+    client->needs_key = true;
+    client->writing = false;
+    client->head = 0;
+    client->size = 0;
+    server->client_count++;
+    server->accepted++;
+  }
+}
+
+static void handle_client(SpectateServer* server, WatchEvent* event) {
+  SpectateClient* client = &server->clients[event->slot];
+  if (event->readable) {
+    // spectators send nothing; reading finds out when they leave
+    char discard[256];
+    for (;;) {
+      int size = recv((Socket)client->socket, discard, sizeof(discard), 0);
+      if (size > 0) {
+        continue;
+      }
+      if (size < 0 && socket_would_block()) {
+        break;
+      }
+      close_client(server, event->slot);
+      return;
+    }
+  }
+  if (event->writable) {
+    flush_client(server, event->slot);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Encode the latest snapshot once, as a delta against the previous
+    broadcast and as a keyframe, and queue it to every client
+    ---------------------------------------------------------------------- */
+static void broadcast(SpectateServer* server) {
+  SpectateSnapshot snapshot;
+  SDL_AtomicLock(&server->lock);
+  bool published = server->published;
+  snapshot = server->latest;
+  SDL_AtomicUnlock(&server->lock);
+  if (!published) {
+    return;
+  }
+
+  Uint8 delta[SPECTATE_MAX_FRAME];
+  Uint8 key[SPECTATE_MAX_FRAME];
+  int delta_size = server->has_sent ?
+    spectate_encode(delta, &server->sent, &snapshot) : 0;
+  int key_size = spectate_encode(key, NULL, &snapshot);
+
+  for (int slot = 0; slot < server->max_clients; slot++) {
+    SpectateClient* client = &server->clients[slot];
+    if (!client->open) {
+      continue;
+    }
+    if (client->needs_key) {
+      if (queue_frame(server, slot, key, key_size)) {
+        client->needs_key = false;
+        server->keyframes++;
+      }
+    } else if (delta_size > 0 && !queue_frame(server, slot, delta, delta_size)) {
+      client->needs_key = true;
+      server->skipped++;
+    }
+  }
+  server->sent = snapshot;
+  server->has_sent = true;
+  server->broadcasts++;
+}
+
+/*  ----------------------------------------------------------------------
+    Server thread: handle socket events until the next broadcast is due,
+    broadcast, and repeat until told to quit
+    ---------------------------------------------------------------------- */
+static int spectate_serve(void* data) {
+  SpectateServer* server = data;
+  Uint64 frequency = SDL_GetPerformanceFrequency();
+  Uint64 period = frequency / server->hz;
+  Uint64 next = SDL_GetPerformanceCounter() + period;
+  WatchEvent events[SPECTATE_EVENTS];
+
+  while (!SDL_AtomicGet(&server->quit)) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    int timeout = now >= next ? 0 :
+      (int)(((next - now) * 1000 + frequency - 1) / frequency);
+    int count = watch_wait(server, timeout, events);
+    Uint64 woke = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < count; i++) {
+      if (events[i].slot < 0) {
+        accept_clients(server);
+      } else if (server->clients[events[i].slot].open) {
+        handle_client(server, &events[i]);
+      }
+    }
+    now = SDL_GetPerformanceCounter();
+    if (now >= next) {
+      broadcast(server);
+      next += period;
+      // fell behind: skip the missed broadcasts rather than burst
+      if (next < now) {
+        next = now + period;
+      }
+    }
+    server->busy += SDL_GetPerformanceCounter() - woke;
+  }
+  return 0;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Start the spectator server thread
+    Parameters:
+      int port: TCP port to listen on, 0 for any free port
+      int hz: broadcasts per second
+      int max_clients: most spectators at once
+    Returns: SpectateServer* pointer to the new server, or NULL on failure
+    ---------------------------------------------------------------------- */
+SpectateServer* spectate_start(int port, int hz, int max_clients) {
+  if (!sockets_start()) {
+    SDL_LogError(LOGCAT, "Failed to start networking");
+    return NULL;
+  }
+  Socket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (s == INVALID_SOCKET) {
+    SDL_LogError(LOGCAT, "Failed to open a TCP socket");
+    return NULL;
+  }
+  int reuse = 1;
+  setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons((Uint16)port);
+  if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+    listen(s, SOMAXCONN) != 0 || !socket_set_nonblocking(s)) {
+    SDL_LogError(LOGCAT, "Failed to listen on TCP port %d", port);
+    closesocket(s);
+    return NULL;
+  }
+
+  SpectateServer* server = calloc(1, sizeof(SpectateServer));
+  if (server == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate the spectator server");
+    closesocket(s);
+    return NULL;
+  }
+  server->listener = (Uint64)s;
+  server->port = socket_local_port(s);
+  server->hz = hz;
+  server->max_clients = max_clients;
+  server->epoll = -1;
+  server->clients = calloc(max_clients, sizeof(SpectateClient));
+  server->free_slots = malloc(max_clients * sizeof(int));
+  bool ok = server->clients != NULL && server->free_slots != NULL &&
+    watch_open(server) && watch_add(server, s, -1);
+  for (int slot = max_clients - 1; ok && slot >= 0; slot--) {
+    server->free_slots[server->free_count++] = slot;
+  }
+
+  server->started = SDL_GetPerformanceCounter();
+  if (ok) {
+    server->thread = SDL_CreateThread(spectate_serve, "spectate", server);
+    ok = server->thread != NULL;
+  }
+  if (!ok) {
+    SDL_LogError(LOGCAT, "Failed to start the spectator server: %s",
+      SDL_GetError());
+    spectate_stop(server);
+    return NULL;
+  }
+  SDL_LogInfo(LOGCAT, "Spectators can watch on TCP port %d", server->port);
+  return server;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Hand the game's current state to the server for its next
+    broadcast. Never waits on the network.
+    Parameters:
+      SpectateServer* server: pointer to the server, NULL is ignored
+      Game* game: pointer to the Game object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_publish(SpectateServer* server, Game* game) {
+  if (server == NULL) {
+    return;
+  }
+  SpectateSnapshot snapshot;
+  spectate_snapshot(game, &snapshot);
+  SDL_AtomicLock(&server->lock);
+  server->latest = snapshot;
+  server->published = true;
+  SDL_AtomicUnlock(&server->lock);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Stop the server thread, disconnect the spectators, log
+    the spectator, frame, byte and CPU counts and free the server
+    Parameters:
+      SpectateServer* server: pointer to the server, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_stop(SpectateServer* server) {
+  if (server == NULL) {
+    return;
+  }
+  if (server->thread != NULL) {
+    SDL_AtomicSet(&server->quit, 1);
+    SDL_WaitThread(server->thread, NULL);
+
+    double elapsed = (SDL_GetPerformanceCounter() - server->started) /
+      (double)SDL_GetPerformanceFrequency();
+    SDL_LogInfo(LOGCAT,
+      "Spectators: %llu accepted, %llu rejected, %llu broadcasts, "
+      "%llu keyframes, %llu deltas skipped for slow spectators, "
+      "%.1f kB/s sent, server thread busy %.1f%% of the time",
+      (unsigned long long)server->accepted,
+      (unsigned long long)server->rejected,
+      (unsigned long long)server->broadcasts,
+      (unsigned long long)server->keyframes,
+      (unsigned long long)server->skipped,
+      elapsed > 0 ? server->bytes / elapsed / 1000 : 0.0,
+      elapsed > 0 ? server->busy * 100.0 /
+        SDL_GetPerformanceFrequency() / elapsed : 0.0);
+  }
+
+  for (int slot = 0; server->clients != NULL && slot < server->max_clients;
+    slot++) {
+    if (server->clients[slot].open) {
+      closesocket((Socket)server->clients[slot].socket);
+    }
+  }
+  closesocket((Socket)server->listener);
+  watch_close(server);
+  free(server->clients);
+  free(server->free_slots);
+  free(server);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Connect to a spectator server
+    Parameters:
+      const char* address: server as HOST:PORT, or HOST for SPECTATE_PORT
+    Returns: SpectateView* pointer to the new view, or NULL on failure
+    ---------------------------------------------------------------------- */
+SpectateView* spectate_connect(const char* address) {
+  Uint32 ip = 0;
+  Uint16 port = 0;
+  if (!socket_resolve(address, SPECTATE_PORT, &ip, &port)) {
+    return NULL;
+  }
+  Socket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (s == INVALID_SOCKET) {
+    SDL_LogError(LOGCAT, "Failed to open a TCP socket");
+    return NULL;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(ip);
+  addr.sin_port = htons(port);
+  if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+    !socket_set_nonblocking(s)) {
+    SDL_LogError(LOGCAT, "Could not connect to '%s'", address);
+    closesocket(s);
+    return NULL;
+  }
+  SpectateView* view = calloc(1, sizeof(SpectateView));
+  if (view == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate the spectator view");
+    closesocket(s);
+    return NULL;
+  }
+  view->socket = (Uint64)s;
+  return view;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Read what has arrived without waiting and decode the
+    complete frames into the view's snapshot
+    Parameters:
+      SpectateView* view: pointer to the view
+    Returns: frames decoded, or -1 if the server closed the stream or it
+    is corrupt
+    ---------------------------------------------------------------------- */
+int spectate_receive(SpectateView* view) {
+  int frames = 0;
+  for (;;) {
+    // fewer than SPECTATE_MAX_FRAME bytes are ever left undecoded
+    int size = recv((Socket)view->socket, (char*)view->buffer + view->size,
+      SPECTATE_VIEW_BUFFER - view->size, 0);
+    if (size == 0 || (size < 0 && !socket_would_block())) {
+      return -1;
+    }
+    if (size < 0) {
+      break;
+    }
+    view->bytes += size;
+    view->size += size;
+
+    int at = 0;
+    while (at < view->size && at + view->buffer[at] <= view->size) {
+      int frame_size = view->buffer[at];
+      if (frame_size < 2 ||
+        !decode_frame(view, view->buffer + at, frame_size)) {
+        return -1;
+      }
+      at += frame_size;
+      frames++;
+      view->frames++;
+    }
+    memmove(view->buffer, view->buffer + at, view->size - at);
+    view->size -= at;
+  }
+  return frames;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Move the game's ball and paddles to the view's snapshot
+    and copy its score and state, for rendering
+    Parameters:
+      SpectateView* view: pointer to the view
+      Game* game: pointer to the Game object, started with new_game()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_apply(SpectateView* view, Game* game) {
+  if (!view->keyed) {
+    return;
+  }
+  Sint32* values = view->snapshot.values;
+  Match* match = &game->match;
+  match->ball.x = values[SPECTATE_BALL_X];
+  match->ball.y = values[SPECTATE_BALL_Y];
+  match->player.y = values[SPECTATE_PLAYER_Y];
+  match->robot.y = values[SPECTATE_ROBOT_Y];
+  match->score_board.player = values[SPECTATE_PLAYER_SCORE];
+  match->score_board.robot = values[SPECTATE_ROBOT_SCORE];
+  match->idle = (values[SPECTATE_STATE] & SPECTATE_IDLE) != 0;
+  match->over = (values[SPECTATE_STATE] & SPECTATE_OVER) != 0;
+  match->winner = (Player)(values[SPECTATE_STATE] >> SPECTATE_WINNER_SHIFT);
+  snap_interpolation(game);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Close the connection and free the view
+    Parameters:
+      SpectateView* view: pointer to the view, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_disconnect(SpectateView* view) {
+  if (view == NULL) {
+    return;
+  }
+  closesocket((Socket)view->socket);
+  free(view);
+}
+
+// receive on every view, dropping those whose stream ended
+static void receive_views(SpectateView** views, int count, int* lost) {
+  for (int i = 0; i < count; i++) {
+    if (views[i] != NULL && spectate_receive(views[i]) < 0) {
+      spectate_disconnect(views[i]);
+      views[i] = NULL;
+      (*lost)++;
+    }
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Load test: run an AI vs AI game in real time, publish it
+    to a server on loopback and connect many spectators to it from this
+    thread, for SPECTATE_TEST_SECONDS. Logs the server's CPU use,
+    bandwidth per spectator and the game thread's publish cost, and
+    checks that every spectator ends with the last snapshot.
+    Parameters:
+      int clients: spectators to connect
+      int hz: broadcasts per second
+      Uint64 seed: seed of the game
+      int sim_hz: simulation steps per second
+    Returns: true if every spectator connected and ended in sync
+    ---------------------------------------------------------------------- */
+bool run_spectate_test(int clients, int hz, Uint64 seed, int sim_hz) {
+  // both ends of every connection live in this process
+  sockets_reserve(2 * clients);
+  SpectateServer* server = spectate_start(0, hz, clients);
+  SpectateView** views = calloc(clients, sizeof(SpectateView*));
+  if (server == NULL || views == NULL) {
+    spectate_stop(server);
+    free(views);
+    return false;
+  }
+  char address[32];
+  snprintf(address, sizeof(address), "127.0.0.1:%d", server->port);
+  int connected = 0;
+  while (connected < clients &&
+    (views[connected] = spectate_connect(address)) != NULL) {
+    connected++;
+  }
+
+  Game game = {
+    .match = { .winner = NOBODY, .idle = true },
+    .running = true,
+  };
+  new_game(&game, seed);
+  Histogram publish_ns;
+  histogram_reset(&publish_ns);
+  int lost = 0;
+  Uint64 frequency = SDL_GetPerformanceFrequency();
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (;;) {
+    double elapsed = (SDL_GetPerformanceCounter() - start) / (double)frequency;
+    if (elapsed >= SPECTATE_TEST_SECONDS) {
+      break;
+    }
+    while (game.sim_ticks < elapsed * sim_hz) {
+      tick_game(&game, 1.0 / sim_hz);
+    }
+    Uint64 before = SDL_GetPerformanceCounter();
+    spectate_publish(server, &game);
+    histogram_record(&publish_ns,
+      (SDL_GetPerformanceCounter() - before) * 1000000000 / frequency);
+    receive_views(views, connected, &lost);
+    // spectators read about twice per broadcast, like a display would
+    SDL_Delay(1000 / hz / 2 > 0 ? 1000 / hz / 2 : 1);
+  }
+  // let the last snapshot reach everyone
+  for (int i = 0; i < 20; i++) {
+    SDL_Delay(10);
+    receive_views(views, connected, &lost);
+  }
+
+  SpectateSnapshot last;
+  spectate_snapshot(&game, &last);
+  int in_sync = 0;
+  int counted = 0;
+  Uint64 frames = 0;
+  Uint64 min_frames = 0;
+  Uint64 bytes = 0;
+  for (int i = 0; i < connected; i++) {
+    SpectateView* view = views[i];
+    if (view == NULL) {
+      continue;
+    }
+    if (view->keyed && memcmp(&view->snapshot, &last, sizeof(last)) == 0) {
+      in_sync++;
+    }
+    frames += view->frames;
+    bytes += view->bytes;
+    if (counted++ == 0 || view->frames < min_frames) {
+      min_frames = view->frames;
+    }
+  }
+  spectate_stop(server);
+  for (int i = 0; i < connected; i++) {
+    spectate_disconnect(views[i]);
+  }
+  free(views);
+
+  double seconds = SPECTATE_TEST_SECONDS;
+  int viewers = connected - lost;
+  SDL_LogInfo(LOGCAT,
+    "Spectate test: %d of %d spectators connected, %d lost, %d in sync "
+    "at the end; per spectator %.1f frames/s (min %.1f), %.0f bytes/s; "
+    "%.2f Mbit/s in total; publish p50 %llu ns, p99 %llu ns, max %llu ns",
+    connected, clients, lost, in_sync,
+    viewers > 0 ? frames / seconds / viewers : 0.0, min_frames / seconds,
+    viewers > 0 ? bytes / seconds / viewers : 0.0, bytes * 8 / seconds / 1e6,
+    (unsigned long long)histogram_percentile(&publish_ns, 50),
+    (unsigned long long)histogram_percentile(&publish_ns, 99),
+    (unsigned long long)publish_ns.max);
+  bool ok = connected == clients && in_sync == clients;
+  if (ok) {
+    SDL_LogInfo(LOGCAT, "Spectate test passed");
+  } else {
+    SDL_LogError(LOGCAT, "Spectate test failed");
+  }
+  return ok;
+}
@@ -0,0 +1,228 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include "pong.h"
+
+#define SPECTATE_PORT 7778
+// snapshots broadcast per second
+#define SPECTATE_HZ 60
+#define SPECTATE_MAX_CLIENTS 1024
+#define SPECTATE_CLIENT_LIMIT 65536
+// bytes queued for a slow spectator before it skips to a later keyframe
+#define SPECTATE_CLIENT_BUFFER 512
+// one frame: size, field mask and a zigzag varint per field
+#define SPECTATE_MAX_FRAME 40
+#define SPECTATE_VIEW_BUFFER 4096
+// socket events handled per wait
+#define SPECTATE_EVENTS 256
+#define SPECTATE_TEST_SECONDS 10
+
+// set in a frame's field mask when its values are absolute, not deltas
+#define SPECTATE_KEYFRAME 0x80
+// bits of SPECTATE_STATE
+#define SPECTATE_IDLE 1
+#define SPECTATE_OVER 2
+#define SPECTATE_WINNER_SHIFT 2
+
+// fields of a snapshot, in stream order
+typedef enum {
+  SPECTATE_BALL_X,
+  SPECTATE_BALL_Y,
+  SPECTATE_PLAYER_Y,
+  SPECTATE_ROBOT_Y,
+  SPECTATE_PLAYER_SCORE,
+  SPECTATE_ROBOT_SCORE,
+  SPECTATE_STATE,
+  SPECTATE_FIELDS
+} SpectateField;
+
+/*
+  What a spectator needs to draw a frame: ball and paddle positions
+  rounded to court pixels, scores, and the idle, over and winner state.
+  Sizes and paddle x positions are fixed by the court.
+*/
+typedef struct SpectateSnapshot SpectateSnapshot;
+struct SpectateSnapshot {
+  Sint32 values[SPECTATE_FIELDS];
+};
+
+/*
+  A connected spectator and the frames queued for it. Frames are queued
+  whole, so when the socket can't take a delta the spectator drops it
+  and waits for a keyframe instead of falling further behind.
+*/
+typedef struct SpectateClient SpectateClient;
+struct SpectateClient {
+  Uint64 socket;
+  bool open;
+  bool needs_key;
+  // the socket has been asked to report when it can take more
+  bool writing;
+  int head;
+  int size;
+  Uint8 buffer[SPECTATE_CLIENT_BUFFER];
+};
+
+/*
+  Spectator broadcast server. The game thread publishes a snapshot with
+  spectate_publish(), which only copies it under a spin lock, so the game
+  never waits on the network. A server thread accepts spectators on a
+  TCP port and, SPECTATE_HZ times a second, encodes the latest snapshot
+  once as a delta against the previous broadcast and queues the same
+  bytes to every spectator; new and lagging spectators get a keyframe.
+  Sockets are non-blocking and waited on with epoll on Linux, poll()
+  elsewhere.
+*/
+typedef struct SpectateServer SpectateServer;
+struct SpectateServer {
+  Uint64 listener;
+  int port;
+  int hz;
+  int max_clients;
+  SpectateClient* clients;
+  int* free_slots;
+  int free_count;
+  int client_count;
+  // epoll descriptor, or poll() array with the listener first
+  int epoll;
+  void* polls;
+
+  SDL_Thread* thread;
+  SDL_atomic_t quit;
+  SDL_SpinLock lock;
+  SpectateSnapshot latest;
+  bool published;
+  // snapshot the stream's deltas are against
+  SpectateSnapshot sent;
+  bool has_sent;
+
+  Uint64 accepted;
+  Uint64 rejected;
+  Uint64 broadcasts;
+  Uint64 keyframes;
+  Uint64 skipped;
+  Uint64 bytes;
+  // performance counter time the server thread spent not waiting
+  Uint64 busy;
+  Uint64 started;
+};
+
+/*
+  A spectator's end of the stream: bytes received and not yet decoded,
+  and the snapshot decoded so far
+*/
+typedef struct SpectateView SpectateView;
+struct SpectateView {
+  Uint64 socket;
+  // a keyframe has arrived, so snapshot is complete
+  bool keyed;
+  SpectateSnapshot snapshot;
+  int size;
+  Uint8 buffer[SPECTATE_VIEW_BUFFER];
+  Uint64 frames;
+  Uint64 bytes;
+};
+
+/*  ----------------------------------------------------------------------
+    Description: Round a game's ball, paddles, score and state to a
+    snapshot
+    Parameters:
+      Game* game: pointer to the Game object
+      SpectateSnapshot* snapshot: receives the snapshot
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_snapshot(Game* game, SpectateSnapshot* snapshot);
+
+/*  ----------------------------------------------------------------------
+    Description: Encode a snapshot as one stream frame
+    Parameters:
+      Uint8* frame: receives the frame, SPECTATE_MAX_FRAME bytes
+      SpectateSnapshot* base: snapshot the frame is a delta against, or
+      NULL for a keyframe
+      SpectateSnapshot* snapshot: snapshot to encode
+    Returns: size of the frame in bytes, 0 if nothing changed since base
+    ---------------------------------------------------------------------- */
+int spectate_encode(Uint8* frame, SpectateSnapshot* base,
+  SpectateSnapshot* snapshot);
+
+/*  ----------------------------------------------------------------------
+    Description: Start the spectator server thread
+    Parameters:
+      int port: TCP port to listen on, 0 for any free port
+      int hz: broadcasts per second
+      int max_clients: most spectators at once
+    Returns: SpectateServer* pointer to the new server, or NULL on failure
+    ---------------------------------------------------------------------- */
+SpectateServer* spectate_start(int port, int hz, int max_clients);
+
+/*  ----------------------------------------------------------------------
+    Description: Hand the game's current state to the server for its next
+    broadcast. Never waits on the network.
+    Parameters:
+      SpectateServer* server: pointer to the server, NULL is ignored
+      Game* game: pointer to the Game object
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_publish(SpectateServer* server, Game* game);
+
+/*  ----------------------------------------------------------------------
+    Description: Stop the server thread, disconnect the spectators, log
+    the spectator, frame, byte and CPU counts and free the server
+    Parameters:
+      SpectateServer* server: pointer to the server, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_stop(SpectateServer* server);
+
+/*  ----------------------------------------------------------------------
+    Description: Connect to a spectator server
+    Parameters:
+      const char* address: server as HOST:PORT, or HOST for SPECTATE_PORT
+    Returns: SpectateView* pointer to the new view, or NULL on failure
+    ---------------------------------------------------------------------- */
+SpectateView* spectate_connect(const char* address);
+
+/*  ----------------------------------------------------------------------
+    Description: Read what has arrived without waiting and decode the
+    complete frames into the view's snapshot
+    Parameters:
+      SpectateView* view: pointer to the view
+    Returns: frames decoded, or -1 if the server closed the stream or it
+    is corrupt
+    ---------------------------------------------------------------------- */
+int spectate_receive(SpectateView* view);
+
+/*  ----------------------------------------------------------------------
+    Description: Move the game's ball and paddles to the view's snapshot
+    and copy its score and state, for rendering
+    Parameters:
+      SpectateView* view: pointer to the view
+      Game* game: pointer to the Game object, started with new_game()
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_apply(SpectateView* view, Game* game);
+
+/*  ----------------------------------------------------------------------
+    Description: Close the connection and free the view
+    Parameters:
+      SpectateView* view: pointer to the view, NULL is ignored
+    Returns: none
+    ---------------------------------------------------------------------- */
+void spectate_disconnect(SpectateView* view);
+
+/*  ----------------------------------------------------------------------
+    Description: Load test: run an AI vs AI game in real time, publish it
+    to a server on loopback and connect many spectators to it from this
+    thread, for SPECTATE_TEST_SECONDS. Logs the server's CPU use,
+    bandwidth per spectator and the game thread's publish cost, and
+    checks that every spectator ends with the last snapshot.
+    Parameters:
+      int clients: spectators to connect
+      int hz: broadcasts per second
+      Uint64 seed: seed of the game
+      int sim_hz: simulation steps per second
+    Returns: true if every spectator connected and ended in sync
+    ---------------------------------------------------------------------- */
+bool run_spectate_test(int clients, int hz, Uint64 seed, int sim_hz);
+
+#endif
@@ -0,0 +1,248 @@
+// Scoped timing zones with Chrome trace-event export
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOGCAT SDL_LOG_CATEGORY_APPLICATION
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL __thread
+#endif
+
+typedef struct TraceEvent TraceEvent;
+struct TraceEvent {
+  const char* name;
+  Uint64 start;
+  Uint64 end;
+};
+
+/*
+  Events of one thread. Only the owning thread writes events and advances
+  head, so recording needs no lock; the dumping thread reads head before
+  and after copying to detect events overwritten in the meantime.
+*/
+typedef struct TraceRing TraceRing;
+struct TraceRing {
+  SDL_atomic_t head;
+  SDL_atomic_t wrapped;
+  char thread_name[TRACE_THREAD_NAME_SIZE];
+  TraceEvent events[TRACE_RING_SIZE];
+};
+
+bool trace_on = false;
+
+static char* trace_path = NULL;
+static Uint64 trace_origin = 0;
+static SDL_atomic_t ring_count;
+static TraceRing* rings[TRACE_MAX_THREADS];
+static TRACE_THREAD_LOCAL TraceRing* local_ring = NULL;
+static TRACE_THREAD_LOCAL bool local_ring_failed = false;
+
+/*  ----------------------------------------------------------------------
+    Description: Enable tracing. Zones are recorded from now on into a ring
+    buffer per thread and written to the given file by trace_dump() or
+    trace_shutdown().
+    Parameters:
+      const char* path: file to write Chrome/Perfetto trace JSON to
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_init(const char* path) {
+  trace_path = SDL_strdup(path);
+  trace_origin = SDL_GetPerformanceCounter();
+  SDL_AtomicSet(&ring_count, 0);
+  trace_on = trace_path != NULL;
+  trace_thread_name("main");
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Write the trace file if tracing is enabled, then disable
+    tracing and free the ring buffers. Call once all traced threads have
+    finished.
+    Parameters: none
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_shutdown(void) {
+  if (!trace_on) {
+    return;
+  }
+  trace_dump();
+  trace_on = false;
+
+  int count = SDL_AtomicGet(&ring_count);
+  for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) {
+    free(rings[i]);
+    rings[i] = NULL;
+  }
+  local_ring = NULL;
+  SDL_free(trace_path);
+  trace_path = NULL;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether tracing is enabled
+    Parameters: none
+    Returns: true if zones are being recorded
+    ---------------------------------------------------------------------- */
+bool trace_enabled(void) {
+  return trace_on;
+}
+
+/*  ----------------------------------------------------------------------
+    Get the calling thread's ring, registering a new one on first use.
+    Returns NULL if the ring can't be allocated or all slots are taken.
+    ---------------------------------------------------------------------- */
+static TraceRing* get_ring(void) {
+  if (local_ring != NULL || local_ring_failed) {
+    return local_ring;
+  }
+
+  TraceRing* ring = calloc(1, sizeof(TraceRing));
+  int slot = ring != NULL ? SDL_AtomicAdd(&ring_count, 1) : 0;
+  if (ring == NULL || slot >= TRACE_MAX_THREADS) {
+    SDL_LogWarn(LOGCAT, "No trace buffer for thread %lu, zones dropped",
+      SDL_ThreadID());
+    free(ring);
+    local_ring_failed = true;
+    return NULL;
+  }
+  snprintf(ring->thread_name, TRACE_THREAD_NAME_SIZE, "thread %d", slot);
+  // publish the ring only once it is fully set up
+  SDL_AtomicSetPtr((void**)&rings[slot], ring);
+  local_ring = ring;
+  return ring;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Name the calling thread in the trace output
+    Parameters:
+      const char* name: thread name, truncated to TRACE_THREAD_NAME_SIZE
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_thread_name(const char* name) {
+  if (!trace_on) {
+    return;
+  }
+  TraceRing* ring = get_ring();
+  if (ring != NULL) {
+    snprintf(ring->thread_name, TRACE_THREAD_NAME_SIZE, "%s", name);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Record a finished zone into the calling thread's ring
+    buffer, creating the ring on the thread's first zone
+    Parameters:
+      const char* name: zone name
+      Uint64 start, Uint64 end: performance counter values
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_record(const char* name, Uint64 start, Uint64 end) {
+  TraceRing* ring = get_ring();
+  if (ring == NULL) {
+    return;
+  }
+  // head is only written by this thread, so a plain read is current
+  Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+  TraceEvent* event = &ring->events[head & TRACE_RING_MASK];
+  event->name = name;
+  event->start = start;
+  event->end = end;
+  // SDL_AtomicSet is a full barrier, the event is visible before head
+  SDL_AtomicSet(&ring->head, (int)(head + 1));
+  if (head == TRACE_RING_MASK) {
+    SDL_AtomicSet(&ring->wrapped, 1);
+  }
+}
+
+/*  ----------------------------------------------------------------------
+    Write one ring's events as complete ("X") events. Events are copied
+    out first; any the owner overwrote while copying are skipped.
+    Returns the number of events written.
+    ---------------------------------------------------------------------- */
+static int dump_ring(FILE* file, TraceRing* ring, int tid,
+  TraceEvent* copy, bool* first) {
+  double us_per_tick = 1e6 / SDL_GetPerformanceFrequency();
+
+  fprintf(file, "%s\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+    "\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+    *first ? "" : ",", tid, ring->thread_name);
+  *first = false;
+
+  Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+  bool wrapped = SDL_AtomicGet(&ring->wrapped) != 0;
+  Uint32 count = wrapped ? TRACE_RING_SIZE : head;
+  Uint32 begin = head - count;
+  for (Uint32 i = 0; i < count; i++) {
+    copy[i] = ring->events[(begin + i) & TRACE_RING_MASK];
+  }
+  Uint32 after = (Uint32)SDL_AtomicGet(&ring->head);
+
+  int written = 0;
+  for (Uint32 i = 0; i < count; i++) {
+    // slot reused, or being reused, by the owner since we read head
+    if (after - (begin + i) >= TRACE_RING_SIZE) {
+      continue;
+    }
+    TraceEvent* event = &copy[i];
+    fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\","
+      "\"ts\":%.3f,\"dur\":%.3f}",
+      tid, event->name,
+      (double)(event->start - trace_origin) * us_per_tick,
+      (double)(event->end - event->start) * us_per_tick);
+    written++;
+  }
+  return written;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Write the events currently held in all ring buffers to
+    the trace file as Chrome trace-event JSON, viewable in chrome://tracing
+    or ui.perfetto.dev. Safe to call while other threads keep tracing;
+    events they overwrite during the dump are skipped.
+    Parameters: none
+    Returns: true if the file was written
+    ---------------------------------------------------------------------- */
+bool trace_dump(void) {
+  if (!trace_on) {
+    return false;
+  }
+  FILE* file = fopen(trace_path, "w");
+  if (file == NULL) {
+    SDL_LogError(LOGCAT, "Failed to open trace file '%s'", trace_path);
+    return false;
+  }
+  TraceEvent* copy = malloc(TRACE_RING_SIZE * sizeof(TraceEvent));
+  if (copy == NULL) {
+    SDL_LogError(LOGCAT, "Failed to allocate trace dump buffer");
+    fclose(file);
+    return false;
+  }
+
+  bool first = true;
+  int events = 0;
+  int count = SDL_AtomicGet(&ring_count);
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (int i = 0; i < count && i < TRACE_MAX_THREADS; i++) {
+    TraceRing* ring = SDL_AtomicGetPtr((void**)&rings[i]);
+    // slot claimed but not yet published
+    if (ring != NULL) {
+      events += dump_ring(file, ring, i + 1, copy, &first);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  free(copy);
+
+  bool ok = !ferror(file);
+  if (fclose(file) != 0) {
+    ok = false;
+  }
+  if (ok) {
+    SDL_LogInfo(LOGCAT, "Wrote %d trace events to %s", events, trace_path);
+  } else {
+    SDL_LogError(LOGCAT, "Failed to write trace file '%s'", trace_path);
+  }
+  return ok;
+}
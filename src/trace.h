@@ -0,0 +1,120 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// events kept per thread, older events are overwritten
+#define TRACE_RING_SIZE 65536
+#define TRACE_MAX_THREADS 64
+#define TRACE_THREAD_NAME_SIZE 32
+
+typedef struct TraceZone TraceZone;
+struct TraceZone {
+  const char* name;
+  Uint64 start;
+};
+
+/*
+  Time a block of code as a named zone while tracing is enabled, e.g.
+
+    TRACE_ZONE("move_ball") {
+      move_ball(&game->ball);
+    }
+
+  The zone ends when the block is left normally; don't 'break', 'return'
+  or 'goto' out of the block. Names must be string literals (or otherwise
+  outlive the trace) since only the pointer is recorded.
+*/
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(zone_name) \
+  for (TraceZone TRACE_CONCAT(trace_zone_, __LINE__) = \
+    trace_zone_begin(zone_name); \
+    TRACE_CONCAT(trace_zone_, __LINE__).name != NULL; \
+    trace_zone_end(&TRACE_CONCAT(trace_zone_, __LINE__)))
+
+/*  ----------------------------------------------------------------------
+    Description: Enable tracing. Zones are recorded from now on into a ring
+    buffer per thread and written to the given file by trace_dump() or
+    trace_shutdown().
+    Parameters:
+      const char* path: file to write Chrome/Perfetto trace JSON to
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_init(const char* path);
+
+/*  ----------------------------------------------------------------------
+    Description: Write the trace file if tracing is enabled, then disable
+    tracing and free the ring buffers. Call once all traced threads have
+    finished.
+    Parameters: none
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_shutdown(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Check whether tracing is enabled
+    Parameters: none
+    Returns: true if zones are being recorded
+    ---------------------------------------------------------------------- */
+bool trace_enabled(void);
+
+/*  ----------------------------------------------------------------------
+    Description: Name the calling thread in the trace output
+    Parameters:
+      const char* name: thread name, truncated to TRACE_THREAD_NAME_SIZE
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_thread_name(const char* name);
+
+/*  ----------------------------------------------------------------------
+    Description: Record a finished zone into the calling thread's ring
+    buffer, creating the ring on the thread's first zone
+    Parameters:
+      const char* name: zone name
+      Uint64 start, Uint64 end: performance counter values
+    Returns: none
+    ---------------------------------------------------------------------- */
+void trace_record(const char* name, Uint64 start, Uint64 end);
+
+// set by trace_init(), read inline so disabled zones cost one branch
+extern bool trace_on;
+
+/*  ----------------------------------------------------------------------
+    Description: Start timing a zone; used by TRACE_ZONE
+    Parameters:
+      const char* name: zone name
+    Returns: TraceZone with the start time, or a start of 0 when tracing
+    is disabled so nothing is recorded
+    ---------------------------------------------------------------------- */
+static inline TraceZone trace_zone_begin(const char* name) {
+  TraceZone zone = { name, trace_on ? SDL_GetPerformanceCounter() : 0 };
+  return zone;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Finish timing a zone and record it; used by TRACE_ZONE
+    Parameters:
+      TraceZone* zone: zone returned by trace_zone_begin(), its name is
+      cleared to end the TRACE_ZONE loop
+    Returns: none
+    ---------------------------------------------------------------------- */
+static inline void trace_zone_end(TraceZone* zone) {
+  if (zone->start != 0) {
+    trace_record(zone->name, zone->start, SDL_GetPerformanceCounter());
+  }
+  zone->name = NULL;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Write the events currently held in all ring buffers to
+    the trace file as Chrome trace-event JSON, viewable in chrome://tracing
+    or ui.perfetto.dev. Safe to call while other threads keep tracing;
+    events they overwrite during the dump are skipped.
+    Parameters: none
+    Returns: true if the file was written
+    ---------------------------------------------------------------------- */
+bool trace_dump(void);
+
+#endif
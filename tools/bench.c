@@ -0,0 +1,538 @@
+// Microbenchmarks of the physics and render hot paths
+#include "pong.h"
+#include "env.h"
+#include "batch.h"
+#include "skip.h"
+#include <string.h>
+
+// randomized states each physics benchmark runs over per sample
+#define BENCH_STATES 4096
+// draw calls per render benchmark sample
+#define BENCH_DRAWS 64
+// environments in the batch, and batch steps per sample
+#define BENCH_ENVS 256
+#define BENCH_ENV_STEPS 16
+// matches in the double and fixed point batches, and steps per sample
+#define BENCH_BATCH_LANES 1024
+#define BENCH_BATCH_STEPS 4
+// ball events of the event-driven match per sample
+#define BENCH_SKIP_EVENTS 1024
+#define BENCH_SAMPLES 200
+#define BENCH_SEED 0x5EED
+
+/*
+  One benchmark's randomized inputs. Every sample starts again from the
+  pristine copies, so functions that move the ball or paddles see the
+  same states in every sample; the copy is not timed.
+*/
+typedef struct Bench Bench;
+struct Bench {
+  Ball balls[BENCH_STATES];
+  Paddle paddles[BENCH_STATES];
+  Ball work_balls[BENCH_STATES];
+  Paddle work_paddles[BENCH_STATES];
+  // the same states in fixed point
+  FixedBall fixed_balls[BENCH_STATES];
+  FixedPaddle fixed_paddles[BENCH_STATES];
+  FixedBall work_fixed_balls[BENCH_STATES];
+  FixedPaddle work_fixed_paddles[BENCH_STATES];
+  Rng rng;
+  App* app;
+  Game* game;
+  int scores[BENCH_DRAWS];
+  // the batch carries on from sample to sample, episodes reset themselves
+  PongEnv* env;
+  int actions[BENCH_ENV_STEPS][BENCH_ENVS];
+  float observations[BENCH_ENVS * ENV_OBS_SIZE];
+  float rewards[BENCH_ENVS];
+  float dones[BENCH_ENVS];
+  Batch* batch;
+  FixedBatch* fixed_batch;
+  // an AI vs AI match, played on from sample to sample
+  Match skip_match;
+};
+
+// runs one sample and returns the performance counter ticks it took
+typedef Uint64 (*BenchRun)(Bench* bench);
+
+// keeps the compiler from dropping results nobody reads
+static volatile double bench_sink;
+
+/*  ----------------------------------------------------------------------
+    Description: Get a random double in [low, high)
+    Parameters:
+      Rng* rng: random number generator
+      double low, high: range
+    Returns: random value
+    ---------------------------------------------------------------------- */
+static double random_range(Rng* rng, double low, double high) {
+  return low +
+    (high - low) * (rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Serve a ball and move it to a random position, speed and
+    direction on the court, partway through a simulation step
+    Parameters:
+      Ball* ball: ball to randomize
+      Rng* rng: random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void random_ball(Ball* ball, Rng* rng) {
+  *ball = (Ball){0};
+  reset_ball(ball, rng_int(rng, 2) == 0 ? PLAYER : ROBOT, rng);
+  ball->x = random_range(rng, 0, SCREEN_WIDTH - BALL_SIZE);
+  ball->y = random_range(rng, 0, SCREEN_HEIGHT - BALL_SIZE);
+  ball->speed = BALL_MIN_SPEED + 10 * rng_int(rng, 6);
+  ball->dy = rng_int(rng, 11) - 5;
+  ball->time_step = random_range(rng, 0, 1.0 / SIM_HZ);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Reset a paddle and move it to a random position and
+    velocity on the court
+    Parameters:
+      Paddle* paddle: paddle to randomize
+      Player owner: PLAYER or ROBOT
+      Rng* rng: random number generator
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void random_paddle(Paddle* paddle, Player owner, Rng* rng) {
+  reset_paddle(paddle, owner);
+  paddle->y = random_range(rng, COURT_OFFSIDE, COURT_HEIGHT - PADDLE_H);
+  paddle->dy = rng_int(rng, 2 * PADDLE_SPEED + 1) - PADDLE_SPEED;
+  paddle->time_step = 1.0 / SIM_HZ;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Copy the pristine states into the work arrays
+    Parameters:
+      Bench* bench: benchmark inputs
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void restore(Bench* bench) {
+  memcpy(bench->work_balls, bench->balls, sizeof(bench->balls));
+  memcpy(bench->work_paddles, bench->paddles, sizeof(bench->paddles));
+  memcpy(bench->work_fixed_balls, bench->fixed_balls,
+    sizeof(bench->fixed_balls));
+  memcpy(bench->work_fixed_paddles, bench->fixed_paddles,
+    sizeof(bench->fixed_paddles));
+}
+
+static Uint64 run_move_ball(Bench* bench) {
+  restore(bench);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    move_ball(&bench->work_balls[i]);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_balls[BENCH_STATES - 1].y;
+  return ticks;
+}
+
+static Uint64 run_move_paddle(Bench* bench) {
+  restore(bench);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    move_paddle(&bench->work_paddles[i]);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_paddles[BENCH_STATES - 1].y;
+  return ticks;
+}
+
+static Uint64 run_check_collision(Bench* bench) {
+  restore(bench);
+  Rng rng = bench->rng;
+  int hits = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    hits += check_collision(&bench->work_balls[i], &bench->work_paddles[i],
+      &rng);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = hits;
+  return ticks;
+}
+
+static Uint64 run_apply_english(Bench* bench) {
+  restore(bench);
+  Rng rng = bench->rng;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    apply_english(&bench->work_balls[i], &bench->work_paddles[i], &rng);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_balls[BENCH_STATES - 1].dy;
+  return ticks;
+}
+
+static Uint64 run_update_player(Bench* bench) {
+  restore(bench);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    update_player(&bench->work_balls[i], &bench->work_paddles[i]);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_paddles[BENCH_STATES - 1].dy;
+  return ticks;
+}
+
+static Uint64 run_fixed_move_ball(Bench* bench) {
+  restore(bench);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    fixed_move_ball(&bench->work_fixed_balls[i]);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_fixed_balls[BENCH_STATES - 1].y;
+  return ticks;
+}
+
+static Uint64 run_fixed_move_paddle(Bench* bench) {
+  restore(bench);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    fixed_move_paddle(&bench->work_fixed_paddles[i]);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_fixed_paddles[BENCH_STATES - 1].y;
+  return ticks;
+}
+
+static Uint64 run_fixed_check_collision(Bench* bench) {
+  restore(bench);
+  Rng rng = bench->rng;
+  int hits = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    hits += fixed_check_collision(&bench->work_fixed_balls[i],
+      &bench->work_fixed_paddles[i], &rng);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = hits;
+  return ticks;
+}
+
+static Uint64 run_fixed_apply_english(Bench* bench) {
+  restore(bench);
+  Rng rng = bench->rng;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_STATES; i++) {
+    fixed_apply_english(&bench->work_fixed_balls[i],
+      &bench->work_fixed_paddles[i], &rng);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->work_fixed_balls[BENCH_STATES - 1].dy;
+  return ticks;
+}
+
+// the batches carry on from sample to sample, like the environments
+static Uint64 run_batch_step(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_BATCH_STEPS; i++) {
+    batch_step(bench->batch);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->batch->x[0];
+  return ticks;
+}
+
+static Uint64 run_fixed_batch_step(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_BATCH_STEPS; i++) {
+    fixed_batch_step(bench->fixed_batch);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->fixed_batch->x[0];
+  return ticks;
+}
+
+static Uint64 run_skip_step(Bench* bench) {
+  double elapsed = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_SKIP_EVENTS; i++) {
+    skip_step(&bench->skip_match, &elapsed);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->skip_match.ball.x + elapsed;
+  return ticks;
+}
+
+static Uint64 run_env_step(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_ENV_STEPS; i++) {
+    pong_env_step(bench->env, bench->actions[i], bench->observations,
+      bench->rewards, bench->dones);
+  }
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  bench_sink = bench->observations[ENV_BALL_X];
+  return ticks;
+}
+
+// each draw is flushed, as the renderer otherwise queues it until present
+static Uint64 run_draw_score(Bench* bench) {
+  ScoreBoard* score_board = &bench->game->match.score_board;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    score_board->player = bench->scores[i] % (MAX_SCORE + 1);
+    score_board->robot = bench->scores[i] / (MAX_SCORE + 1);
+    draw_score(bench->app, bench->game);
+    SDL_RenderFlush(bench->app->renderer);
+  }
+  return SDL_GetPerformanceCounter() - start;
+}
+
+static Uint64 run_draw_instructions(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    bench->game->match.winner = (Player)(bench->scores[i] % 3);
+    draw_instructions(bench->app, bench->game);
+    SDL_RenderFlush(bench->app->renderer);
+  }
+  return SDL_GetPerformanceCounter() - start;
+}
+
+static Uint64 run_draw_court(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    draw_court(bench->app);
+    SDL_RenderFlush(bench->app->renderer);
+  }
+  return SDL_GetPerformanceCounter() - start;
+}
+
+// the cached court layer, as drawn every frame once it is built
+static Uint64 run_draw_layer(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    draw_layer(bench->app, &bench->app->court_layer, 0, draw_court_layer,
+      bench->game);
+    SDL_RenderFlush(bench->app->renderer);
+  }
+  return SDL_GetPerformanceCounter() - start;
+}
+
+static Uint64 run_draw_stats(Bench* bench) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    bench->game->match.ball = bench->balls[i];
+    draw_stats(bench->app, bench->game);
+    SDL_RenderFlush(bench->app->renderer);
+  }
+  return SDL_GetPerformanceCounter() - start;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Run a benchmark for the given number of samples, after
+    one untimed warm up sample, and print its result as one JSON line:
+    mean ns/op, ops/sec, and the variance, standard deviation and minimum
+    of the per sample ns/op
+    Parameters:
+      Bench* bench: benchmark inputs
+      const char* name: benchmark name
+      BenchRun run: runs one sample
+      int ops: operations per sample
+      int samples: number of timed samples
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void bench_run(Bench* bench, const char* name, BenchRun run, int ops,
+  int samples) {
+  double ns_per_tick = 1e9 / SDL_GetPerformanceFrequency();
+  run(bench);
+
+  // Welford's running mean and variance of the per sample ns/op
+  double mean = 0;
+  double m2 = 0;
+  double min = 0;
+  for (int i = 0; i < samples; i++) {
+    double ns = run(bench) * ns_per_tick / ops;
+    double delta = ns - mean;
+    mean += delta / (i + 1);
+    m2 += delta * (ns - mean);
+    if (i == 0 || ns < min) {
+      min = ns;
+    }
+  }
+  double variance = samples > 1 ? m2 / (samples - 1) : 0;
+
+  printf("{\"bench\":\"%s\",\"samples\":%d,\"ops_per_sample\":%d,"
+    "\"ns_per_op\":%.3f,\"ops_per_sec\":%.0f,\"variance_ns2\":%.4f,"
+    "\"stddev_ns\":%.3f,\"min_ns_per_op\":%.3f}\n",
+    name, samples, ops, mean, mean > 0 ? 1e9 / mean : 0, variance,
+    sqrt(variance), min);
+  fflush(stdout);
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Fill the benchmark inputs with randomized balls and
+    paddles. Balls heading for a paddle are placed within two steps of its
+    face so that check_collision() and apply_english() take their hit
+    paths about half the time.
+    Parameters:
+      Bench* bench: benchmark inputs
+      Uint64 seed: random seed
+    Returns: none
+    ---------------------------------------------------------------------- */
+static void bench_init(Bench* bench, Uint64 seed) {
+  Rng rng;
+  rng_seed(&rng, seed);
+  for (int i = 0; i < BENCH_STATES; i++) {
+    Ball* ball = &bench->balls[i];
+    Paddle* paddle = &bench->paddles[i];
+    random_ball(ball, &rng);
+    random_paddle(paddle, ball->dx > 0 ? PLAYER : ROBOT, &rng);
+
+    double reach = fabs(ball->dx) * ball->speed / SIM_HZ;
+    ball->x = ball->dx > 0 ?
+      random_range(&rng, paddle->x - ball->w - 2 * reach,
+        paddle->x - ball->w) :
+      random_range(&rng, paddle->x + paddle->w,
+        paddle->x + paddle->w + 2 * reach);
+    ball->y = random_range(&rng, paddle->y - ball->h, paddle->y + paddle->h);
+
+    // round to fixed point so both paths start from the same states
+    fixed_load_ball(&bench->fixed_balls[i], ball);
+    fixed_load_paddle(&bench->fixed_paddles[i], paddle);
+    fixed_store_ball(ball, &bench->fixed_balls[i]);
+    fixed_store_paddle(paddle, &bench->fixed_paddles[i]);
+  }
+  for (int i = 0; i < BENCH_DRAWS; i++) {
+    bench->scores[i] = rng_int(&rng, (MAX_SCORE + 1) * (MAX_SCORE + 1));
+  }
+  for (int i = 0; i < BENCH_ENV_STEPS; i++) {
+    for (int j = 0; j < BENCH_ENVS; j++) {
+      bench->actions[i][j] = rng_int(&rng, 3);
+    }
+  }
+  bench->skip_match = (Match){ .winner = NOBODY };
+  bench->skip_match.rng = rng;
+  rng_jump(&rng);
+  reset_match(&bench->skip_match);
+  bench->rng = rng;
+}
+
+/*
+  Usage: bench [--samples N] [--seed N]
+  Benchmarks the physics functions over randomized states, in doubles
+  and in fixed point, a step of the double and fixed batches and the
+  event-driven skip_step(), then each draw_* function on a software
+  renderer drawing into an offscreen surface, so no display or video
+  driver is needed. Results are printed to stdout as JSON lines.
+*/
+int main(int argc, char* argv[]) {
+  int samples = BENCH_SAMPLES;
+  Uint64 seed = BENCH_SEED;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      samples = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: bench [--samples N] [--seed N]\n");
+      return EXIT_FAILURE;
+    }
+  }
+  if (samples < 1) {
+    samples = 1;
+  }
+
+  if (SDL_Init(0) < 0 || TTF_Init() == -1) {
+    fprintf(stderr, "Could not initialize SDL2: %s\n", SDL_GetError());
+    return EXIT_FAILURE;
+  }
+
+  Bench* bench = calloc(1, sizeof(Bench));
+  if (bench == NULL) {
+    fprintf(stderr, "Failed to allocate the benchmark states\n");
+    return EXIT_FAILURE;
+  }
+  bench_init(bench, seed);
+
+  bench_run(bench, "move_ball", run_move_ball, BENCH_STATES, samples);
+  bench_run(bench, "move_paddle", run_move_paddle, BENCH_STATES, samples);
+  bench_run(bench, "check_collision", run_check_collision, BENCH_STATES,
+    samples);
+  bench_run(bench, "apply_english", run_apply_english, BENCH_STATES,
+    samples);
+  bench_run(bench, "update_player", run_update_player, BENCH_STATES,
+    samples);
+  bench_run(bench, "fixed_move_ball", run_fixed_move_ball, BENCH_STATES,
+    samples);
+  bench_run(bench, "fixed_move_paddle", run_fixed_move_paddle, BENCH_STATES,
+    samples);
+  bench_run(bench, "fixed_check_collision", run_fixed_check_collision,
+    BENCH_STATES, samples);
+  bench_run(bench, "fixed_apply_english", run_fixed_apply_english,
+    BENCH_STATES, samples);
+
+  // ops are ball-ticks, one lane stepped once, with the widest kernel
+  bench->batch = batch_create(BENCH_BATCH_LANES, 1.0 / SIM_HZ,
+    BATCH_KERNEL_AUTO, seed);
+  bench->fixed_batch = fixed_batch_create(BENCH_BATCH_LANES, 1.0 / SIM_HZ,
+    BATCH_KERNEL_AUTO, seed);
+  if (bench->batch != NULL && bench->fixed_batch != NULL) {
+    bench_run(bench, "batch_step", run_batch_step,
+      BENCH_BATCH_LANES * BENCH_BATCH_STEPS, samples);
+    bench_run(bench, "fixed_batch_step", run_fixed_batch_step,
+      BENCH_BATCH_LANES * BENCH_BATCH_STEPS, samples);
+  }
+  batch_destroy(bench->batch);
+  fixed_batch_destroy(bench->fixed_batch);
+
+  bench_run(bench, "skip_step", run_skip_step, BENCH_SKIP_EVENTS, samples);
+
+  bench->env = pong_env_create(BENCH_ENVS, seed);
+  if (bench->env != NULL) {
+    pong_env_reset(bench->env, bench->observations);
+    bench_run(bench, "env_step", run_env_step, BENCH_ENVS * BENCH_ENV_STEPS,
+      samples);
+    pong_env_destroy(bench->env);
+  }
+
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0,
+    SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+  App app = {
+    .renderer = surface != NULL ? SDL_CreateSoftwareRenderer(surface) : NULL,
+    .court_layer = { .texture = NULL, .dirty = true },
+    .instructions_layer = { .texture = NULL, .dirty = true },
+  };
+  if (app.renderer == NULL) {
+    fprintf(stderr, "Could not create software renderer: %s\n",
+      SDL_GetError());
+  } else {
+    quads_init(&app.quads);
+    Game game = {
+      .match = { .winner = NOBODY, .idle = true },
+      .score_font = load_font("VT323-Regular.ttf", SCORE_FONT_SIZE),
+      .stats_font = load_font("Inconsolata-Regular.ttf", STATS_FONT_SIZE),
+      .fps_ticks = SDL_GetTicks(),
+    };
+    load_atlases(&app, &game);
+    bench->app = &app;
+    bench->game = &game;
+
+    // draw_stats only draws at debug priority
+    SDL_LogSetPriority(LOGCAT, SDL_LOG_PRIORITY_DEBUG);
+    bench_run(bench, "draw_court", run_draw_court, BENCH_DRAWS, samples);
+    bench_run(bench, "draw_layer", run_draw_layer, BENCH_DRAWS, samples);
+    bench_run(bench, "draw_score", run_draw_score, BENCH_DRAWS, samples);
+    bench_run(bench, "draw_instructions", run_draw_instructions,
+      BENCH_DRAWS, samples);
+    bench_run(bench, "draw_stats", run_draw_stats, BENCH_DRAWS, samples);
+
+    destroy_layers(&app);
+    atlas_destroy(game.stats_atlas);
+    atlas_destroy(game.instructions_atlas);
+    atlas_destroy(game.score_atlas);
+    TTF_CloseFont(game.stats_font);
+    TTF_CloseFont(game.score_font);
+    SDL_DestroyRenderer(app.renderer);
+  }
+  SDL_FreeSurface(surface);
+
+  free(bench);
+  TTF_Quit();
+  SDL_Quit();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+// Build step: pack asset files into a C source file linked into the game
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  ----------------------------------------------------------------------
+    Description: Get the file name part of a path, with either separator
+    Parameters:
+      const char* path: file path
+    Returns: pointer into path after the last '/' or '\'
+    ---------------------------------------------------------------------- */
+static const char* base_name(const char* path) {
+  const char* name = path;
+  for (const char* p = path; *p != '\0'; p++) {
+    if (*p == '/' || *p == '\\') {
+      name = p + 1;
+    }
+  }
+  return name;
+}
+
+/*  ----------------------------------------------------------------------
+    Description: Write one file as a byte array named asset_<index>
+    Parameters:
+      FILE* out: generated source file
+      const char* path: asset file to read
+      int index: asset number
+    Returns: size of the asset in bytes, or -1 if it can't be read
+    ---------------------------------------------------------------------- */
+static long write_asset(FILE* out, const char* path, int index) {
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    fprintf(stderr, "pack_assets: can't open '%s'\n", path);
+    return -1;
+  }
+  fprintf(out, "\n// %s\nstatic const unsigned char asset_%d[] = {",
+    path, index);
+  long size = 0;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    fprintf(out, "%s%d,", size % 20 == 0 ? "\n  " : "", c);
+    size++;
+  }
+  // C doesn't allow empty arrays
+  if (size == 0) {
+    fprintf(out, "\n  0");
+  }
+  fprintf(out, "\n};\n");
+  fclose(in);
+  return size;
+}
+
+/*
+  Usage: pack_assets OUT.c FILE...
+  Writes OUT.c defining pack_entries[] and pack_count (see src/pack.h),
+  with every FILE as a read-only byte array listed under its file name.
+*/
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: pack_assets OUT.c FILE...\n");
+    return EXIT_FAILURE;
+  }
+  FILE* out = fopen(argv[1], "w");
+  if (out == NULL) {
+    fprintf(stderr, "pack_assets: can't create '%s'\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  int count = argc - 2;
+  long* sizes = calloc(count + 1, sizeof(long));
+
+  fprintf(out, "// Generated by tools/pack_assets.c, do not edit\n");
+  fprintf(out, "#include \"pack.h\"\n");
+  for (int i = 0; i < count; i++) {
+    sizes[i] = write_asset(out, argv[i + 2], i);
+    if (sizes[i] < 0) {
+      fclose(out);
+      remove(argv[1]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  fprintf(out, "\nconst PackEntry pack_entries[] = {\n");
+  for (int i = 0; i < count; i++) {
+    fprintf(out, "  { \"%s\", asset_%d, %ld },\n",
+      base_name(argv[i + 2]), i, sizes[i]);
+  }
+  // keeps the array non-empty when nothing is packed
+  fprintf(out, "  { NULL, NULL, 0 }\n};\n");
+  fprintf(out, "\nconst int pack_count = %d;\n", count);
+
+  fclose(out);
+  free(sizes);
+  return EXIT_SUCCESS;
+}